@@ -0,0 +1,27 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+namespace signalr
+{
+    // Where hub method handlers registered with hub_connection::on and invoke completions run.
+    enum class callback_mode
+    {
+        // On the connection's strand: one at a time and in order with the keepalive timers and the disconnected
+        // callback. They run on the receive thread when nothing else is running for the connection and are queued on the
+        // scheduler otherwise.
+        scheduled,
+
+        // Directly on the thread that completed the websocket receive, without going through the strand, for the lowest
+        // latency. Rules for handlers and completions in this mode:
+        // - the next message isn't received until they return, keep them short
+        // - they may call invoke, send and stop but must not block waiting for the result, the result can only arrive
+        //   through the receive they are blocking, which deadlocks the connection
+        // - they aren't ordered with the keepalive timers or the disconnected callback and can run at the same time as
+        //   the disconnected callback
+        // - like in scheduled mode they must not destroy the hub_connection
+        caller_runs
+    };
+}
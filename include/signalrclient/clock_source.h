@@ -0,0 +1,20 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <chrono>
+
+namespace signalr
+{
+    // Implemented by a scheduler that has its own notion of time (like virtual_scheduler). The library reads the time
+    // through the scheduler its timers run on, so timeouts and keepalive pings follow the scheduler's clock. Schedulers
+    // that don't implement it are measured against std::chrono::steady_clock.
+    struct clock_source
+    {
+        virtual std::chrono::steady_clock::time_point now() const = 0;
+
+        virtual ~clock_source() {}
+    };
+}
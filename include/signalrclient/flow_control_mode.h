@@ -0,0 +1,23 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+namespace signalr
+{
+    // What invoke and send do while the connection is at one of the limits set with
+    // signalr_client_config::set_max_pending_invocations and set_max_outbound_bytes. Either way the callback set with
+    // hub_connection::set_ready_to_send runs once the connection is below its limits again.
+    enum class flow_control_mode
+    {
+        // The call is held and made once the connection is below its limits, in the order calls were made. Held calls keep
+        // their arguments alive, a producer that doesn't wait for its calls to complete or for the ready to send callback
+        // still grows memory, just not on the socket's send queue.
+        wait,
+
+        // The call fails right away with a signalr_exception and nothing is kept for it, the producer is expected to retry
+        // once the ready to send callback ran.
+        reject
+    };
+}
@@ -12,6 +12,7 @@
 #include "log_writer.h"
 #include "signalr_client_config.h"
 #include "signalr_value.h"
+#include "upload_stream.h"
 
 namespace signalr
 {
@@ -41,17 +42,41 @@ namespace signalr
 
         SIGNALRCLIENT_API connection_state __cdecl get_connection_state() const;
         SIGNALRCLIENT_API std::string __cdecl get_connection_id() const;
+        // Invocations that are waiting for their result, they are bounded by the invocation timeout while the server isn't
+        // responding.
+        SIGNALRCLIENT_API size_t __cdecl get_pending_invocation_count() const;
 
         SIGNALRCLIENT_API void __cdecl set_disconnected(const std::function<void __cdecl(std::exception_ptr)>& disconnected_callback);
 
+        // Runs on the scheduler once a call was held or rejected because the connection reached one of its flow control
+        // limits (see flow_control_mode) and the connection is below its limits again.
+        SIGNALRCLIENT_API void __cdecl set_ready_to_send(const std::function<void __cdecl()>& ready_to_send_callback);
+
         SIGNALRCLIENT_API void __cdecl set_client_config(const signalr_client_config& config);
 
         SIGNALRCLIENT_API void __cdecl on(const std::string& event_name, const method_invoked_handler& handler);
 
         SIGNALRCLIENT_API void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments = std::vector<signalr::value>(), std::function<void(const signalr::value&, std::exception_ptr)> callback = [](const signalr::value&, std::exception_ptr) {}) noexcept;
 
+        // Fails the invocation with a timeout_exception if no result was received within the timeout, a timeout of 0 waits
+        // until the connection closes. The overload above uses signalr_client_config::get_invocation_timeout().
+        SIGNALRCLIENT_API void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout) noexcept;
+
         SIGNALRCLIENT_API void send(const std::string& method_name, const std::vector<signalr::value>& arguments = std::vector<signalr::value>(), std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
 
+        // Invokes a hub method that streams items back. on_item is called on the scheduler for each item, one at a time and
+        // in order, and on_complete once the stream ends, with the error if it failed or was canceled. The connection stops
+        // receiving while a stream holds signalr_client_config::get_stream_buffer_capacity() items its on_item hasn't
+        // taken yet. The returned function cancels the stream, the server is told to stop sending items.
+        SIGNALRCLIENT_API std::function<void()> stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept;
+
+        // Invokes a hub method that reads a stream of items from the client, the returned upload_stream writes them. The
+        // hub method gets the stream after the given arguments. The callback is called with the result once the hub method
+        // returns, which usually happens after the stream completed, so the invocation timeout doesn't apply to it.
+        SIGNALRCLIENT_API std::shared_ptr<upload_stream> upload(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&, std::exception_ptr)> callback = [](const signalr::value&, std::exception_ptr) {}) noexcept;
+
     private:
         friend class hub_connection_builder;
 
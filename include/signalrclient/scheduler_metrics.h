@@ -0,0 +1,41 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace signalr
+{
+    struct latency_histogram
+    {
+        // bucket 0 counts latencies under 1 microsecond, bucket i counts latencies from 2^(i-1) up to 2^i microseconds and
+        // the last bucket also counts anything longer
+        static constexpr size_t bucket_count = 32;
+
+        std::array<uint64_t, bucket_count> buckets{};
+        uint64_t count = 0;
+        std::chrono::microseconds total{ 0 };
+        std::chrono::microseconds max{ 0 };
+    };
+
+    // A snapshot of the default scheduler's metrics, counters accumulate from the time metrics were enabled.
+    struct scheduler_metrics
+    {
+        // from a callback being handed to the workers until a worker starts running it
+        latency_histogram dispatch_latency;
+        // from a delayed callback's deadline until it is handed to the workers
+        latency_histogram timer_lateness;
+        // callbacks waiting for a worker
+        size_t queue_depth = 0;
+        size_t peak_queue_depth = 0;
+        // delayed callbacks whose deadline hasn't been reached yet
+        size_t pending_timers = 0;
+        // time each worker spent running callbacks
+        std::vector<std::chrono::microseconds> worker_busy_time;
+    };
+}
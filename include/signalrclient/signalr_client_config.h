@@ -15,7 +15,12 @@
 #include "_exports.h"
 #include <map>
 #include <string>
+#include <vector>
 #include "scheduler.h"
+#include "scheduler_metrics.h"
+#include "callback_mode.h"
+#include "flow_control_mode.h"
+#include <functional>
 #include <memory>
 
 namespace signalr
@@ -46,13 +51,73 @@ namespace signalr
         SIGNALRCLIENT_API std::map<std::string, std::string>& __cdecl get_http_headers() noexcept;
         SIGNALRCLIENT_API void __cdecl set_http_headers(const std::map<std::string, std::string>& http_headers);
         SIGNALRCLIENT_API void __cdecl set_scheduler(std::shared_ptr<scheduler> scheduler);
-        SIGNALRCLIENT_API const std::shared_ptr<scheduler>& __cdecl get_scheduler() const noexcept;
+        // Returns the scheduler set with set_scheduler, or the default scheduler, which is created by the first call.
+        SIGNALRCLIENT_API const std::shared_ptr<scheduler>& __cdecl get_scheduler() const;
+        // The settings below configure the default scheduler and are ignored if a scheduler was set with set_scheduler.
+        // Changing one of them releases the default scheduler, the next get_scheduler creates it again with the new
+        // settings. Copies of the config share the default scheduler until one of them changes a setting. By default the
+        // default scheduler is process-wide, configs with the same thread count, name and affinity share one, it is shut
+        // down once the last config or connection using it is destroyed. Disable sharing to give a config its own scheduler.
+        SIGNALRCLIENT_API void __cdecl set_use_shared_scheduler(bool use_shared_scheduler);
+        SIGNALRCLIENT_API bool __cdecl get_use_shared_scheduler() const noexcept;
+        // The most workers the default scheduler grows to, workers are only started when callbacks need them and exit again
+        // after being idle for a while. A thread count of 0 uses one worker per hardware thread. Shared schedulers are only
+        // shared between configs with the same thread count.
+        SIGNALRCLIENT_API void __cdecl set_scheduler_thread_count(size_t thread_count);
+        SIGNALRCLIENT_API size_t __cdecl get_scheduler_thread_count() const noexcept;
+        // Worker threads are named "<name>-<index>", only supported on Linux. Configs with different names don't share a
+        // scheduler.
+        SIGNALRCLIENT_API void __cdecl set_scheduler_thread_name(const std::string& thread_name);
+        SIGNALRCLIENT_API const std::string& __cdecl get_scheduler_thread_name() const noexcept;
+        // Worker i is pinned to the cpu at index i % cpus.size(), only supported on Linux. Configs pinned differently don't
+        // share a scheduler.
+        SIGNALRCLIENT_API void __cdecl set_scheduler_thread_affinity(const std::vector<int>& cpus);
+        SIGNALRCLIENT_API const std::vector<int>& __cdecl get_scheduler_thread_affinity() const noexcept;
+        // Collects dispatch latency, queue depth, timer lateness and worker busy time on the default scheduler. Off by
+        // default, when off the cost is a relaxed atomic load per callback. Once enabled on the shared scheduler they stay
+        // enabled for every connection using it.
+        SIGNALRCLIENT_API void __cdecl set_scheduler_metrics_enabled(bool enabled);
+        SIGNALRCLIENT_API bool __cdecl get_scheduler_metrics_enabled() const noexcept;
+        // Enables metrics and pushes a snapshot to the callback every interval, on one of the scheduler's threads, starting
+        // when the scheduler is created. The shared scheduler pushes to the callback that was set last.
+        SIGNALRCLIENT_API void __cdecl set_scheduler_metrics_callback(std::function<void(const scheduler_metrics&)> callback, std::chrono::milliseconds interval);
+        SIGNALRCLIENT_API const std::function<void(const scheduler_metrics&)>& __cdecl get_scheduler_metrics_callback() const noexcept;
+        SIGNALRCLIENT_API std::chrono::milliseconds __cdecl get_scheduler_metrics_interval() const noexcept;
+        // Takes a snapshot of the default scheduler's metrics. Returns false if metrics
+        // aren't enabled or a scheduler was set with set_scheduler.
+        SIGNALRCLIENT_API bool __cdecl get_scheduler_metrics(scheduler_metrics& metrics) const;
+        // See callback_mode for the rules handlers have to follow in callback_mode::caller_runs.
+        SIGNALRCLIENT_API void __cdecl set_callback_mode(callback_mode mode);
+        SIGNALRCLIENT_API callback_mode __cdecl get_callback_mode() const noexcept;
         SIGNALRCLIENT_API void set_handshake_timeout(std::chrono::milliseconds);
         SIGNALRCLIENT_API std::chrono::milliseconds get_handshake_timeout() const noexcept;
         SIGNALRCLIENT_API void set_server_timeout(std::chrono::milliseconds);
         SIGNALRCLIENT_API std::chrono::milliseconds get_server_timeout() const noexcept;
         SIGNALRCLIENT_API void set_keepalive_interval(std::chrono::milliseconds);
         SIGNALRCLIENT_API std::chrono::milliseconds get_keepalive_interval() const noexcept;
+        // How long hub_connection::invoke waits for a result before failing the invocation with a timeout_exception, unless a
+        // timeout is passed to invoke. 0 (the default) waits until the connection closes.
+        SIGNALRCLIENT_API void set_invocation_timeout(std::chrono::milliseconds);
+        SIGNALRCLIENT_API std::chrono::milliseconds get_invocation_timeout() const noexcept;
+        // The most invocations that can wait for their result at the same time, 0 (the default) doesn't limit them.
+        SIGNALRCLIENT_API void __cdecl set_max_pending_invocations(size_t max_pending_invocations);
+        SIGNALRCLIENT_API size_t __cdecl get_max_pending_invocations() const noexcept;
+        // Calls are let through while fewer bytes than this have been handed to the websocket without it reporting them
+        // sent, so the limit can be passed by the size of the messages let through last. 0 (the default) doesn't limit them.
+        SIGNALRCLIENT_API void __cdecl set_max_outbound_bytes(size_t max_outbound_bytes);
+        SIGNALRCLIENT_API size_t __cdecl get_max_outbound_bytes() const noexcept;
+        // What invoke and send do while one of the limits above is reached, flow_control_mode::wait by default.
+        SIGNALRCLIENT_API void __cdecl set_flow_control_mode(flow_control_mode mode);
+        SIGNALRCLIENT_API flow_control_mode __cdecl get_flow_control_mode() const noexcept;
+        // The most items a stream keeps while its item callback is catching up, once a stream has this many the connection
+        // stops receiving until it is back to half of it. 64 by default, must be at least 1.
+        SIGNALRCLIENT_API void __cdecl set_stream_buffer_capacity(size_t stream_buffer_capacity);
+        SIGNALRCLIENT_API size_t __cdecl get_stream_buffer_capacity() const noexcept;
+        // Allocates the arrays and maps of the values parsed from a frame from one arena that is released at once when the
+        // frame's messages have been handled, instead of allocating each of them separately. The values handlers receive
+        // must then not be kept past the handler, copying a value makes a copy that can be kept. Off by default.
+        SIGNALRCLIENT_API void __cdecl set_use_message_arena(bool use_message_arena);
+        SIGNALRCLIENT_API bool __cdecl get_use_message_arena() const noexcept;
 
     private:
 #ifdef USE_CPPRESTSDK
@@ -62,9 +127,28 @@ namespace signalr
 #endif
 #endif
         std::map<std::string, std::string> m_http_headers;
-        std::shared_ptr<scheduler> m_scheduler;
+        // holds the scheduler, the default one is created in it on first use
+        struct scheduler_slot;
+        std::shared_ptr<scheduler_slot> m_scheduler;
+        bool m_user_scheduler;
+        bool m_use_shared_scheduler;
+        size_t m_scheduler_thread_count;
+        std::string m_scheduler_thread_name;
+        std::vector<int> m_scheduler_thread_affinity;
+        bool m_scheduler_metrics_enabled;
+        std::function<void(const scheduler_metrics&)> m_scheduler_metrics_callback;
+        std::chrono::milliseconds m_scheduler_metrics_interval;
+        callback_mode m_callback_mode;
         std::chrono::milliseconds m_handshake_timeout;
         std::chrono::milliseconds m_server_timeout;
         std::chrono::milliseconds m_keepalive_interval;
+        std::chrono::milliseconds m_invocation_timeout;
+        size_t m_max_pending_invocations;
+        size_t m_max_outbound_bytes;
+        flow_control_mode m_flow_control_mode;
+        size_t m_stream_buffer_capacity;
+        bool m_use_message_arena;
+
+        void release_default_scheduler();
     };
 }
@@ -8,13 +8,21 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace signalr
 {
     /**
      * An enum defining the types a signalr::value may be.
+     *
+     * Breaking change: integers received from the server are int64, or uint64 when they only fit in a uint64_t. Earlier
+     * versions stored every number as float64, so checks for value_type::float64 or is_double() no longer match them. Use
+     * value::is_number() to accept any number, value::as_double() still reads all three.
      */
     enum class value_type
     {
@@ -22,11 +30,263 @@ namespace signalr
         array,
         string,
         float64,
+        int64,
+        uint64,
         null,
         boolean,
         binary
     };
 
+    class value;
+    class value_arena;
+
+    /**
+     * The arena the containers of values created on the calling thread allocate from, nullptr when they allocate from the
+     * heap. See signalr_client_config::set_use_message_arena.
+     */
+    SIGNALRCLIENT_API value_arena* __cdecl current_value_arena() noexcept;
+
+    SIGNALRCLIENT_API void* __cdecl allocate_from_value_arena(value_arena* arena, size_t size);
+
+    /**
+     * Allocates the elements of arrays and the members of maps, from the arena that was current when the container was
+     * created or from the heap. Memory taken from an arena is only given back when the whole arena is released, and a
+     * copy of a container always allocates from the heap so copying a value is how it outlives its arena.
+     */
+    template <typename T>
+    class value_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        value_allocator() noexcept
+            : m_arena(current_value_arena())
+        {}
+
+        explicit value_allocator(value_arena* arena) noexcept
+            : m_arena(arena)
+        {}
+
+        template <typename U>
+        value_allocator(const value_allocator<U>& other) noexcept
+            : m_arena(other.arena())
+        {}
+
+        T* allocate(size_t count)
+        {
+            const auto size = count * sizeof(T);
+            return static_cast<T*>(m_arena == nullptr ? ::operator new(size) : allocate_from_value_arena(m_arena, size));
+        }
+
+        void deallocate(T* pointer, size_t) noexcept
+        {
+            if (m_arena == nullptr)
+            {
+                ::operator delete(pointer);
+            }
+        }
+
+        value_allocator select_on_container_copy_construction() const noexcept
+        {
+            return value_allocator(nullptr);
+        }
+
+        value_arena* arena() const noexcept
+        {
+            return m_arena;
+        }
+
+    private:
+        value_arena* m_arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const value_allocator<T>& lhs, const value_allocator<U>& rhs) noexcept
+    {
+        return lhs.arena() == rhs.arena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const value_allocator<T>& lhs, const value_allocator<U>& rhs) noexcept
+    {
+        return lhs.arena() != rhs.arena();
+    }
+
+    /**
+     * The vector arrays and maps store their elements and members in, building one and moving it into a value_array or
+     * value_map doesn't copy it.
+     */
+    template <typename T>
+    using value_vector = std::vector<T, value_allocator<T>>;
+
+    /**
+     * The members of a value_type::map value, sorted by name and stored contiguously. It can be used like a const std::map
+     * of property name to signalr::value and converts to one.
+     */
+    class value_map
+    {
+        typedef value_vector<std::pair<std::string, value>> members;
+        friend class value;
+
+    public:
+        typedef std::string key_type;
+        typedef value mapped_type;
+        typedef members::const_iterator const_iterator;
+        typedef const_iterator iterator;
+        typedef size_t size_type;
+
+        /**
+         * Create an empty map.
+         */
+        value_map() noexcept : m_std_map(nullptr) {}
+
+        SIGNALRCLIENT_API value_map(const value_map& other);
+        SIGNALRCLIENT_API value_map(value_map&& other) noexcept;
+        SIGNALRCLIENT_API ~value_map();
+
+        SIGNALRCLIENT_API value_map& operator=(const value_map& rhs);
+        SIGNALRCLIENT_API value_map& operator=(value_map&& rhs) noexcept;
+
+        /**
+         * Create a map with the members of the given map.
+         */
+        SIGNALRCLIENT_API explicit value_map(const std::map<std::string, value>& map);
+
+        /**
+         * Create a map with the given members, in any order. When a name appears more than once the first member is kept.
+         */
+        SIGNALRCLIENT_API explicit value_map(std::vector<std::pair<std::string, value>>&& members);
+
+        /**
+         * Create a map with the given members, in any order. When a name appears more than once the first member is kept.
+         */
+        SIGNALRCLIENT_API explicit value_map(value_vector<std::pair<std::string, value>>&& members);
+
+        /**
+         * Create a map with the members in the given range, in any order. When a name appears more than once the first
+         * member is kept.
+         */
+        template <typename InputIterator>
+        value_map(InputIterator first, InputIterator last)
+            : m_members(first, last), m_std_map(nullptr)
+        {
+            sort_members();
+        }
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+
+        /**
+         * Returns the member with the given name, or end() if there is none.
+         */
+        SIGNALRCLIENT_API const_iterator find(const std::string& name) const;
+
+        /**
+         * Returns 1 if there is a member with the given name, 0 otherwise.
+         */
+        SIGNALRCLIENT_API size_t count(const std::string& name) const;
+
+        /**
+         * Returns the value of the member with the given name. This will throw std::out_of_range if there is none.
+         */
+        SIGNALRCLIENT_API const value& at(const std::string& name) const;
+
+        /**
+         * Copies the members to a std::map.
+         */
+        SIGNALRCLIENT_API operator std::map<std::string, value>() const;
+
+    private:
+        members m_members;
+        // the copy handed out by value::as_map(), made on first use
+        mutable std::atomic<std::map<std::string, value>*> m_std_map;
+
+        SIGNALRCLIENT_API void sort_members();
+        SIGNALRCLIENT_API const std::map<std::string, value>& std_map() const;
+    };
+
+    /**
+     * The elements of a value_type::array value. It can be used like a const std::vector of signalr::value and converts
+     * to one.
+     */
+    class value_array
+    {
+        typedef value_vector<value> elements;
+        friend class value;
+
+    public:
+        typedef elements::const_iterator const_iterator;
+        typedef const_iterator iterator;
+        typedef size_t size_type;
+
+        /**
+         * Create an empty array.
+         */
+        value_array() noexcept : m_std_vector(nullptr) {}
+
+        SIGNALRCLIENT_API value_array(const value_array& other);
+        SIGNALRCLIENT_API value_array(value_array&& other) noexcept;
+        SIGNALRCLIENT_API ~value_array();
+
+        SIGNALRCLIENT_API value_array& operator=(const value_array& rhs);
+        SIGNALRCLIENT_API value_array& operator=(value_array&& rhs) noexcept;
+
+        /**
+         * Create an array with the given elements.
+         */
+        SIGNALRCLIENT_API explicit value_array(const std::vector<value>& values);
+
+        /**
+         * Create an array with the given elements.
+         */
+        SIGNALRCLIENT_API explicit value_array(std::vector<value>&& values);
+
+        /**
+         * Create an array with the given elements.
+         */
+        explicit value_array(value_vector<value>&& values) noexcept
+            : m_values(std::move(values)), m_std_vector(nullptr)
+        {}
+
+        /**
+         * Create an array with the elements in the given range.
+         */
+        template <typename InputIterator>
+        value_array(InputIterator first, InputIterator last)
+            : m_values(first, last), m_std_vector(nullptr)
+        {}
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        const value& operator[](size_t index) const noexcept;
+        const value& front() const noexcept;
+        const value& back() const noexcept;
+
+        /**
+         * Returns the element at the given index. This will throw std::out_of_range if the index is past the end.
+         */
+        SIGNALRCLIENT_API const value& at(size_t index) const;
+
+        /**
+         * Copies the elements to a std::vector.
+         */
+        SIGNALRCLIENT_API operator std::vector<value>() const;
+
+    private:
+        elements m_values;
+        // the copy handed out by value::as_array(), made on first use
+        mutable std::atomic<std::vector<value>*> m_std_vector;
+
+        SIGNALRCLIENT_API const std::vector<value>& std_vector() const;
+    };
+
     /**
      * Represents a value to be provided to a SignalR method as a parameter, or returned as a return value.
      */
@@ -58,6 +318,16 @@ namespace signalr
          */
         SIGNALRCLIENT_API value(double val);
 
+        /**
+         * Create an object representing a value_type::int64 with the given integer value.
+         */
+        SIGNALRCLIENT_API value(int64_t val);
+
+        /**
+         * Create an object representing a value_type::uint64 with the given integer value.
+         */
+        SIGNALRCLIENT_API value(uint64_t val);
+
         /**
          * Create an object representing a value_type::string with the given string value.
          */
@@ -88,6 +358,16 @@ namespace signalr
          */
         SIGNALRCLIENT_API value(std::vector<value>&& val);
 
+        /**
+         * Create an object representing a value_type::array with the given array of value's.
+         */
+        SIGNALRCLIENT_API value(const value_array& val);
+
+        /**
+         * Create an object representing a value_type::array with the given array of value's.
+         */
+        SIGNALRCLIENT_API value(value_array&& val);
+
         /**
          * Create an object representing a value_type::map with the given map of string-value's.
          */
@@ -98,6 +378,16 @@ namespace signalr
          */
         SIGNALRCLIENT_API value(std::map<std::string, value>&& map);
 
+        /**
+         * Create an object representing a value_type::map with the given map of string-value's.
+         */
+        SIGNALRCLIENT_API value(const value_map& map);
+
+        /**
+         * Create an object representing a value_type::map with the given map of string-value's.
+         */
+        SIGNALRCLIENT_API value(value_map&& map);
+
         /**
          * Create an object representing a value_type::binary with the given array of byte's.
          */
@@ -139,10 +429,27 @@ namespace signalr
         SIGNALRCLIENT_API bool is_map() const;
 
         /**
-         * True if the object stored is a double.
+         * True if the object stored is a double. Integers received from the server are stored as a
+         * signalr::type::int64 or signalr::type::uint64 and don't match, use is_number to accept any number.
          */
         SIGNALRCLIENT_API bool is_double() const;
 
+        /**
+         * True if the object stored is a double, an int64_t or a uint64_t, any of which as_double can return.
+         */
+        SIGNALRCLIENT_API bool is_number() const;
+
+        /**
+         * True if the object stored is a signed 64-bit integer. Integers received from the server are stored as one unless
+         * they are only in the range of a uint64_t.
+         */
+        SIGNALRCLIENT_API bool is_int64() const;
+
+        /**
+         * True if the object stored is an unsigned 64-bit integer.
+         */
+        SIGNALRCLIENT_API bool is_uint64() const;
+
         /**
          * True if the object stored is a string.
          */
@@ -169,10 +476,23 @@ namespace signalr
         SIGNALRCLIENT_API bool is_binary() const;
 
         /**
-         * Returns the stored object as a double. This will throw if the underlying object is not a signalr::type::float64.
+         * Returns the stored object as a double. Integers are converted to the nearest double. This will throw if the
+         * underlying object is not a signalr::type::float64, signalr::type::int64 or signalr::type::uint64.
          */
         SIGNALRCLIENT_API double as_double() const;
 
+        /**
+         * Returns the stored object as an int64_t. This will throw if the underlying object is not a signalr::type::int64 or
+         * a signalr::type::uint64 in the range of an int64_t.
+         */
+        SIGNALRCLIENT_API int64_t as_int64() const;
+
+        /**
+         * Returns the stored object as a uint64_t. This will throw if the underlying object is not a signalr::type::uint64
+         * or a signalr::type::int64 that isn't negative.
+         */
+        SIGNALRCLIENT_API uint64_t as_uint64() const;
+
         /**
          * Returns the stored object as a bool. This will throw if the underlying object is not a signalr::type::boolean.
          */
@@ -185,14 +505,26 @@ namespace signalr
 
         /**
          * Returns the stored object as an array of signalr::value's. This will throw if the underlying object is not a signalr::type::array.
+         * The elements are copied to the std::vector on first use, as_value_array() reads them without copying.
          */
         SIGNALRCLIENT_API const std::vector<value>& as_array() const;
 
         /**
          * Returns the stored object as a map of property name to signalr::value. This will throw if the underlying object is not a signalr::type::map.
+         * The members are copied to the std::map on first use, as_value_map() reads them without copying.
          */
         SIGNALRCLIENT_API const std::map<std::string, value>& as_map() const;
 
+        /**
+         * Returns the elements of the stored array as they are stored. This will throw if the underlying object is not a signalr::type::array.
+         */
+        SIGNALRCLIENT_API const value_array& as_value_array() const;
+
+        /**
+         * Returns the members of the stored map as they are stored. This will throw if the underlying object is not a signalr::type::map.
+         */
+        SIGNALRCLIENT_API const value_map& as_value_map() const;
+
         /**
          * Returns the stored object as an array of bytes. This will throw if the underlying object is not a signalr::type::binary.
          */
@@ -212,9 +544,11 @@ namespace signalr
 #pragma warning (disable: 4582)
             bool boolean;
             std::string string;
-            std::vector<value> array;
+            value_array array;
             double number;
-            std::map<std::string, value> map;
+            int64_t int64;
+            uint64_t uint64;
+            value_map map;
             std::vector<uint8_t> binary;
 
             // constructor of types in union are not implicitly called
@@ -238,4 +572,59 @@ namespace signalr
 
         void destruct_internals();
     };
+
+    inline value_map::const_iterator value_map::begin() const noexcept
+    {
+        return m_members.begin();
+    }
+
+    inline value_map::const_iterator value_map::end() const noexcept
+    {
+        return m_members.end();
+    }
+
+    inline size_t value_map::size() const noexcept
+    {
+        return m_members.size();
+    }
+
+    inline bool value_map::empty() const noexcept
+    {
+        return m_members.empty();
+    }
+
+    inline value_array::const_iterator value_array::begin() const noexcept
+    {
+        return m_values.begin();
+    }
+
+    inline value_array::const_iterator value_array::end() const noexcept
+    {
+        return m_values.end();
+    }
+
+    inline size_t value_array::size() const noexcept
+    {
+        return m_values.size();
+    }
+
+    inline bool value_array::empty() const noexcept
+    {
+        return m_values.empty();
+    }
+
+    inline const value& value_array::operator[](size_t index) const noexcept
+    {
+        return m_values[index];
+    }
+
+    inline const value& value_array::front() const noexcept
+    {
+        return m_values.front();
+    }
+
+    inline const value& value_array::back() const noexcept
+    {
+        return m_values.back();
+    }
 }
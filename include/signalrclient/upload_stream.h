@@ -0,0 +1,54 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include "signalr_value.h"
+
+namespace signalr
+{
+    class hub_connection_impl;
+
+    // The items a hub method invoked with hub_connection::upload reads from the client. Items are sent in the order they
+    // are written, behind the invocation and any calls the connection's flow control is holding back. The server only
+    // completes the invocation once the stream completes, so an upload stream that is dropped without being completed
+    // completes itself.
+    class upload_stream
+    {
+    public:
+        SIGNALRCLIENT_API ~upload_stream();
+
+        upload_stream(const upload_stream&) = delete;
+
+        upload_stream& operator=(const upload_stream&) = delete;
+
+        // The callback runs once the item was handed to the transport, or with the error if it couldn't be sent. Writing
+        // fails once the stream or its invocation completed.
+        SIGNALRCLIENT_API void write(const signalr::value& item, std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        // Tells the server there are no more items.
+        SIGNALRCLIENT_API void complete(std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        // Tells the server there are no more items because of the given error, the hub method sees it as an exception.
+        SIGNALRCLIENT_API void cancel(const std::string& error, std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+    private:
+        friend class hub_connection;
+        friend class hub_connection_impl;
+
+        upload_stream(std::weak_ptr<hub_connection_impl> connection, std::string stream_id);
+
+        void end(const std::string& error, std::function<void(std::exception_ptr)> callback) noexcept;
+
+        std::weak_ptr<hub_connection_impl> m_connection;
+        const std::string m_stream_id;
+        std::atomic<bool> m_completed;
+    };
+}
@@ -0,0 +1,67 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include "scheduler.h"
+#include "clock_source.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace signalr
+{
+    // A scheduler with a manually advanced clock, for tests and benchmarks. Callbacks never run on their own, they run on
+    // the thread calling run_until_idle, advance or run_until, ordered by deadline and then by the order they were
+    // scheduled in. The clock starts at zero and only moves when advanced, so handshake and server timeouts, keepalive
+    // pings and other timers fire without waiting and at the same point on every run. Exceptions thrown by callbacks
+    // propagate to the caller.
+    class virtual_scheduler : public scheduler, public clock_source
+    {
+    public:
+        SIGNALRCLIENT_API virtual_scheduler();
+
+        virtual_scheduler(const virtual_scheduler&) = delete;
+        virtual_scheduler& operator=(const virtual_scheduler&) = delete;
+
+        SIGNALRCLIENT_API void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override;
+        SIGNALRCLIENT_API std::chrono::steady_clock::time_point now() const override;
+
+        // runs the callbacks that are due at the current time, including the ones they schedule without a delay, and
+        // returns how many ran
+        SIGNALRCLIENT_API size_t run_until_idle();
+        // moves the clock forward, callbacks that become due run with the clock set to their deadline, returns how many ran
+        SIGNALRCLIENT_API size_t advance(std::chrono::milliseconds duration);
+        // for work that is scheduled from other threads, like a websocket client's receive loop: runs callbacks as they
+        // become due at the current time until the condition returns true or the timeout (in real time) passes, without
+        // moving the clock. Returns the condition's last result.
+        SIGNALRCLIENT_API bool run_until(const std::function<bool()>& condition, std::chrono::milliseconds timeout = std::chrono::seconds(5));
+        // callbacks that haven't run yet, whether they are due or not
+        SIGNALRCLIENT_API size_t pending() const;
+
+    private:
+#pragma warning( push )
+#pragma warning( disable: 4625 5026 4626 5027 )
+        struct entry
+        {
+            std::chrono::steady_clock::time_point deadline;
+            uint64_t sequence;
+            signalr_base_cb callback;
+        };
+#pragma warning( pop )
+
+        mutable std::mutex m_lock;
+        // signaled whenever a callback is scheduled, lets run_until sleep while other threads are busy
+        std::condition_variable m_scheduled_cv;
+        // min-heap on deadline and sequence
+        std::vector<entry> m_entries;
+        uint64_t m_sequence;
+        std::chrono::steady_clock::time_point m_now;
+
+        // runs the earliest callback if it is due by the given time, moving the clock up to its deadline
+        bool run_next(std::chrono::steady_clock::time_point until);
+    };
+}
@@ -7,6 +7,8 @@
 #ifdef USE_MSGPACK
 #include "binary_message_formatter.h"
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <signalrclient/signalr_exception.h>
 
 namespace signalr
@@ -15,11 +17,35 @@ namespace signalr
     {
         void write_length_prefix(std::string& payload)
         {
+            write_length_prefix(payload, 0);
+        }
+
+        size_t length_prefix_length(size_t length)
+        {
+            size_t length_num_bytes = 1;
+            while (length > 0x7f)
+            {
+                length >>= 7;
+                length_num_bytes++;
+            }
+
+            return length_num_bytes;
+        }
+
+        void write_length_prefix(std::string& payload, size_t reserved_length)
+        {
+            assert(payload.length() >= reserved_length);
+
+            size_t length = payload.length() - reserved_length;
+            if (length > INT32_MAX)
+            {
+                throw signalr_exception("messages over 2GB are not supported.");
+            }
+
             // We support payloads up to 2GB so the biggest number we support is 7fffffff which when encoded as
             // VarInt is 0xFF 0xFF 0xFF 0xFF 0x07 - hence the maximum length prefix is 5 bytes.
             char buffer[5];
 
-            size_t length = payload.length();
             size_t length_num_bytes = 0;
             do
             {
@@ -30,14 +56,18 @@ namespace signalr
                     buffer[length_num_bytes] |= 0x80;
                 }
                 length_num_bytes++;
-            } while (length > 0 && length_num_bytes < 5);
+            } while (length > 0);
 
-            if (length_num_bytes == 5 && buffer[4] != 0x07)
+            if (length_num_bytes > reserved_length)
             {
-                throw signalr_exception("messages over 2GB are not supported.");
+                payload.insert(0, length_num_bytes - reserved_length, '\0');
+            }
+            else if (length_num_bytes < reserved_length)
+            {
+                payload.erase(0, reserved_length - length_num_bytes);
             }
 
-            payload.insert(0, buffer, length_num_bytes);
+            std::memcpy(&payload[0], buffer, length_num_bytes);
         }
     }
 }
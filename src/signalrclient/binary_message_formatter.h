@@ -13,6 +13,13 @@ namespace signalr
     namespace binary_message_formatter
     {
         void write_length_prefix(std::string &);
+
+        // the number of bytes the length prefix of a message of the given length takes
+        size_t length_prefix_length(size_t);
+
+        // writes the prefix into the first reserved_length bytes of the payload, which were left for it when the message
+        // was written after them, the message only has to move if they weren't the number of bytes the prefix takes
+        void write_length_prefix(std::string &, size_t reserved_length);
     }
 }
 
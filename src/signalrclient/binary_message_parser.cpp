@@ -19,6 +19,32 @@ namespace signalr
                 return false;
             }
 
+            size_t num_bytes;
+            size_t message_length;
+            // size bytes are missing
+            if (!try_parse_length_prefix(message, length, &num_bytes, &message_length))
+            {
+                throw signalr_exception("partial messages are not supported.");
+            }
+
+            // not enough data with the given length prefix
+            if (length < message_length + num_bytes)
+            {
+                throw signalr_exception("partial messages are not supported.");
+            }
+
+            *length_prefix_length = num_bytes;
+            *length_of_message = message_length;
+            return true;
+        }
+
+        bool try_parse_length_prefix(const unsigned char* message, size_t length, size_t* length_prefix_length, size_t* length_of_message)
+        {
+            if (length == 0)
+            {
+                return false;
+            }
+
             // The payload starts with a length prefix encoded as a VarInt. VarInts use the most significant bit
             // as a marker whether the byte is the last byte of the VarInt or if it spans to the next byte. Bytes
             // appear in the reverse order - i.e. the first byte contains the least significant bits of the value
@@ -45,7 +71,7 @@ namespace signalr
             // size bytes are missing
             if ((byte_read & 0x80) != 0 && (num_bytes < 5))
             {
-                throw signalr_exception("partial messages are not supported.");
+                return false;
             }
 
             if ((byte_read & 0x80) != 0 || (num_bytes == 5 && byte_read > 7))
@@ -53,12 +79,6 @@ namespace signalr
                 throw signalr_exception("messages over 2GB are not supported.");
             }
 
-            // not enough data with the given length prefix
-            if (length < message_length + num_bytes)
-            {
-                throw signalr_exception("partial messages are not supported.");
-            }
-
             *length_prefix_length = num_bytes;
             *length_of_message = message_length;
             return true;
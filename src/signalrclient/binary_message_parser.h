@@ -12,6 +12,9 @@ namespace signalr
     namespace binary_message_parser
     {
         bool try_parse_message(const unsigned char* message, size_t length, size_t* length_prefix_length, size_t* length_of_message);
+
+        // reads the length prefix without requiring the message after it, returns false if the prefix itself is incomplete
+        bool try_parse_length_prefix(const unsigned char* message, size_t length, size_t* length_prefix_length, size_t* length_of_message);
     }
 }
 
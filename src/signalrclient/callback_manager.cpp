@@ -4,14 +4,28 @@
 
 #include "stdafx.h"
 #include "callback_manager.h"
-#include <sstream>
+#include <algorithm>
 
 namespace signalr
 {
+    namespace
+    {
+        const size_t initial_slot_count = 16;
+
+        // std::push_heap/std::pop_heap build a max-heap, inverting the comparison keeps the earliest deadline at the front
+        template <typename Expiry>
+        bool later(const Expiry& lhs, const Expiry& rhs)
+        {
+            return lhs.deadline > rhs.deadline;
+        }
+    }
+
+    const size_t callback_manager::max_callback_id_length;
+
     // dtor_clear_arguments will be passed when closing any pending callbacks when the `callback_manager` is
     // destroyed (i.e. in the dtor)
     callback_manager::callback_manager(const char* dtor_clear_arguments)
-        : m_dtor_clear_arguments(dtor_clear_arguments)
+        : m_slots(initial_slot_count), m_count(0), m_next_id(0), m_dtor_clear_arguments(dtor_clear_arguments)
     { }
 
     callback_manager::~callback_manager()
@@ -20,39 +34,64 @@ namespace signalr
     }
 
     // note: callback must not throw except for the `on_progress` callback which will never be invoked from the dtor
-    std::string callback_manager::register_callback(const std::function<void(const char*, const signalr::value&)>& callback)
+    uint64_t callback_manager::register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+        clock::time_point deadline, std::function<void()> on_expired)
     {
-        auto callback_id = get_callback_id();
+        std::lock_guard<std::mutex> lock(m_lock);
 
+        if ((m_count + 1) * 2 > m_slots.size())
         {
-            std::lock_guard<std::mutex> lock(m_map_lock);
+            grow();
+        }
 
-            m_callbacks.insert(std::make_pair(callback_id, callback));
+        const auto mask = m_slots.size() - 1;
+        while (m_slots[static_cast<size_t>(m_next_id) & mask].occupied)
+        {
+            ++m_next_id;
+        }
+
+        const auto callback_id = m_next_id++;
+        auto& entry = m_slots[static_cast<size_t>(callback_id) & mask];
+        entry.callback_id = callback_id;
+        entry.occupied = true;
+        entry.callback = callback;
+        entry.on_expired = std::move(on_expired);
+        ++m_count;
+
+        if (deadline != clock::time_point::max())
+        {
+            prune_expiries();
+            m_expiries.push_back(expiry{ deadline, callback_id });
+            std::push_heap(m_expiries.begin(), m_expiries.end(), later<expiry>);
         }
 
         return callback_id;
     }
 
-
     // invokes a callback and stops tracking it if remove callback set to true
-    bool callback_manager::invoke_callback(const std::string& callback_id, const char* error, const signalr::value& arguments, bool remove_callback)
+    bool callback_manager::invoke_callback(uint64_t callback_id, const char* error, const signalr::value& arguments, bool remove_callback)
     {
         std::function<void(const char*, const signalr::value& arguments)> callback;
+        std::function<void()> on_expired;
 
         {
-            std::lock_guard<std::mutex> lock(m_map_lock);
+            std::lock_guard<std::mutex> lock(m_lock);
 
-            auto iter = m_callbacks.find(callback_id);
-            if (iter == m_callbacks.end())
+            auto entry = find_slot(callback_id);
+            if (entry == nullptr)
             {
                 return false;
             }
 
-            callback = iter->second;
-
             if (remove_callback)
             {
-                m_callbacks.erase(callback_id);
+                callback = std::move(entry->callback);
+                on_expired = std::move(entry->on_expired);
+                release(*entry);
+            }
+            else
+            {
+                callback = entry->callback;
             }
         }
 
@@ -60,34 +99,218 @@ namespace signalr
         return true;
     }
 
-    bool callback_manager::remove_callback(const std::string& callback_id)
+    bool callback_manager::invoke_callback(const std::string& callback_id, const char* error, const signalr::value& arguments, bool remove_callback)
+    {
+        uint64_t id;
+        return parse_callback_id(callback_id, id) && invoke_callback(id, error, arguments, remove_callback);
+    }
+
+    bool callback_manager::remove_callback(uint64_t callback_id)
     {
+        std::function<void(const char*, const signalr::value& arguments)> callback;
+        std::function<void()> on_expired;
+
         {
-            std::lock_guard<std::mutex> lock(m_map_lock);
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            auto entry = find_slot(callback_id);
+            if (entry == nullptr)
+            {
+                return false;
+            }
 
-            return m_callbacks.erase(callback_id) != 0;
+            callback = std::move(entry->callback);
+            on_expired = std::move(entry->on_expired);
+            release(*entry);
         }
+
+        // the callbacks (and anything they captured) are destroyed outside the lock
+        return true;
+    }
+
+    bool callback_manager::remove_callback(const std::string& callback_id)
+    {
+        uint64_t id;
+        return parse_callback_id(callback_id, id) && remove_callback(id);
     }
 
     void callback_manager::clear(const char* error)
     {
+        std::vector<slot> slots;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            if (m_count == 0)
+            {
+                return;
+            }
+
+            slots.swap(m_slots);
+            m_slots.resize(initial_slot_count);
+            m_count = 0;
+            m_expiries.clear();
+        }
+
+        // callbacks run outside the lock so they can register or invoke other callbacks
+        for (auto& entry : slots)
+        {
+            if (entry.occupied)
+            {
+                entry.callback(error, signalr::value());
+            }
+        }
+    }
+
+    size_t callback_manager::expire(clock::time_point now)
+    {
+        std::vector<slot> expired;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            while (!m_expiries.empty() && m_expiries.front().deadline <= now)
+            {
+                auto entry = find_slot(m_expiries.front().callback_id);
+                std::pop_heap(m_expiries.begin(), m_expiries.end(), later<expiry>);
+                m_expiries.pop_back();
+
+                if (entry != nullptr)
+                {
+                    expired.push_back(slot{ entry->callback_id, false, std::move(entry->callback), std::move(entry->on_expired) });
+                    release(*entry);
+                }
+            }
+        }
+
+        // in deadline order, outside the lock like every other callback
+        for (auto& entry : expired)
+        {
+            if (entry.on_expired)
+            {
+                entry.on_expired();
+            }
+        }
+
+        return expired.size();
+    }
+
+    callback_manager::clock::time_point callback_manager::next_deadline()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        while (!m_expiries.empty() && find_slot(m_expiries.front().callback_id) == nullptr)
         {
-            std::lock_guard<std::mutex> lock(m_map_lock);
+            std::pop_heap(m_expiries.begin(), m_expiries.end(), later<expiry>);
+            m_expiries.pop_back();
+        }
 
-            for (auto& kvp : m_callbacks)
+        return m_expiries.empty() ? clock::time_point::max() : m_expiries.front().deadline;
+    }
+
+    size_t callback_manager::size()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_count;
+    }
+
+    size_t callback_manager::format_callback_id(uint64_t callback_id, char (&buffer)[max_callback_id_length])
+    {
+        char digits[max_callback_id_length];
+        size_t length = 0;
+        do
+        {
+            digits[length++] = static_cast<char>('0' + callback_id % 10);
+            callback_id /= 10;
+        } while (callback_id != 0);
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            buffer[i] = digits[length - i - 1];
+        }
+
+        return length;
+    }
+
+    bool callback_manager::parse_callback_id(const std::string& text, uint64_t& callback_id)
+    {
+        // only the canonical form is accepted so each id has exactly one spelling
+        if (text.empty() || text.size() > max_callback_id_length || (text.size() > 1 && text[0] == '0'))
+        {
+            return false;
+        }
+
+        uint64_t id = 0;
+        for (auto c : text)
+        {
+            if (c < '0' || c > '9')
             {
-                kvp.second(error, signalr::value());
+                return false;
             }
 
-            m_callbacks.clear();
+            const auto digit = static_cast<uint64_t>(c - '0');
+            if (id > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+            id = id * 10 + digit;
+        }
+
+        callback_id = id;
+        return true;
+    }
+
+    callback_manager::slot* callback_manager::find_slot(uint64_t callback_id)
+    {
+        auto& entry = m_slots[static_cast<size_t>(callback_id) & (m_slots.size() - 1)];
+        if (!entry.occupied || entry.callback_id != callback_id)
+        {
+            return nullptr;
+        }
+
+        return &entry;
+    }
+
+    // must be called with m_lock held
+    void callback_manager::release(slot& entry)
+    {
+        entry.callback = nullptr;
+        entry.on_expired = nullptr;
+        entry.occupied = false;
+        --m_count;
+    }
+
+    // must be called with m_lock held, keeps invocations that complete before their deadline from growing the heap without
+    // bound. Rebuilding only once the heap is twice the size of the table makes the cost per registration constant.
+    void callback_manager::prune_expiries()
+    {
+        if (m_expiries.size() < initial_slot_count || m_expiries.size() < m_count * 2)
+        {
+            return;
         }
+
+        m_expiries.erase(std::remove_if(m_expiries.begin(), m_expiries.end(), [this](const expiry& entry)
+            {
+                return find_slot(entry.callback_id) == nullptr;
+            }), m_expiries.end());
+        std::make_heap(m_expiries.begin(), m_expiries.end(), later<expiry>);
     }
 
-    std::string callback_manager::get_callback_id()
+    // must be called with m_lock held
+    void callback_manager::grow()
     {
-        const auto callback_id = m_id++;
-        std::stringstream ss;
-        ss << callback_id;
-        return ss.str();
+        std::vector<slot> slots(m_slots.size() * 2);
+        const auto mask = slots.size() - 1;
+
+        // ids that had different slots still do, the new mask only looks at more bits
+        for (auto& entry : m_slots)
+        {
+            if (entry.occupied)
+            {
+                slots[static_cast<size_t>(entry.callback_id) & mask] = std::move(entry);
+            }
+        }
+
+        m_slots.swap(slots);
     }
 }
@@ -4,10 +4,12 @@
 
 #pragma once
 
-#include <atomic>
-#include <unordered_map>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <mutex>
+#include <string>
+#include <vector>
 #include "signalrclient/signalr_value.h"
 
 namespace signalr
@@ -15,23 +17,73 @@ namespace signalr
     class callback_manager
     {
     public:
+        typedef std::chrono::steady_clock clock;
+
+        // room for the decimal form of any callback id
+        static const size_t max_callback_id_length = 20;
+
         explicit callback_manager(const char* dtor_error);
         ~callback_manager();
 
         callback_manager(const callback_manager&) = delete;
         callback_manager& operator=(const callback_manager&) = delete;
 
-        std::string register_callback(const std::function<void(const char*, const signalr::value&)>& callback);
+        // a callback with a deadline is removed by expire once the deadline has passed, which invokes on_expired (if set)
+        // instead of the callback
+        uint64_t register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+            clock::time_point deadline = clock::time_point::max(), std::function<void()> on_expired = nullptr);
+        bool invoke_callback(uint64_t callback_id, const char* error, const signalr::value& arguments, bool remove_callback);
+        // looks up an id as it arrives on the wire, ids that aren't in the form format_callback_id writes are not found
         bool invoke_callback(const std::string& callback_id, const char* error, const signalr::value& arguments, bool remove_callback);
+        bool remove_callback(uint64_t callback_id);
         bool remove_callback(const std::string& callback_id);
         void clear(const char* error);
 
+        // removes the callbacks whose deadline is at or before now and invokes their on_expired, returns how many expired
+        size_t expire(clock::time_point now);
+        // the earliest deadline of the registered callbacks, clock::time_point::max() if none has a deadline
+        clock::time_point next_deadline();
+        // callbacks that are registered and haven't been invoked for the last time or removed yet
+        size_t size();
+
+        // writes the decimal form of the id to the buffer without a null terminator, returns the number of characters written
+        static size_t format_callback_id(uint64_t callback_id, char (&buffer)[max_callback_id_length]);
+        static bool parse_callback_id(const std::string& text, uint64_t& callback_id);
+
     private:
-        std::atomic<int> m_id { 0 };
-        std::unordered_map<std::string, std::function<void(const char*, const signalr::value&)>> m_callbacks;
-        std::mutex m_map_lock;
+#pragma warning( push )
+#pragma warning( disable: 4625 5026 4626 5027 )
+        struct slot
+        {
+            // the id the slot is occupied by, ids are never reused so an id that is no longer registered can't match a slot
+            // that has since been taken by another callback
+            uint64_t callback_id;
+            bool occupied;
+            std::function<void(const char*, const signalr::value&)> callback;
+            std::function<void()> on_expired;
+        };
+
+        struct expiry
+        {
+            clock::time_point deadline;
+            uint64_t callback_id;
+        };
+#pragma warning( pop )
+
+        std::mutex m_lock;
+        // ids are handed out in order and live at 'id & (m_slots.size() - 1)', ids whose slot is taken by a long running
+        // invocation are skipped. The table doubles before it gets half full so there is always a free slot nearby.
+        std::vector<slot> m_slots;
+        size_t m_count;
+        // min-heap on deadline of the callbacks that have one, entries of callbacks that were invoked or removed are only
+        // dropped once they reach the top or when they outnumber the live ones
+        std::vector<expiry> m_expiries;
+        uint64_t m_next_id;
         std::string m_dtor_clear_arguments;
 
-        std::string get_callback_id();
+        slot* find_slot(uint64_t callback_id);
+        void release(slot& entry);
+        void grow();
+        void prune_expiries();
     };
 }
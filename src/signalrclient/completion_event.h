@@ -8,6 +8,8 @@
 #pragma warning (disable : 5204 4355)
 #include <future>
 #pragma warning (pop)
+#include <functional>
+#include <vector>
 
 namespace signalr
 {
@@ -25,25 +27,63 @@ namespace signalr
         // no op when already set
         void set()
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if (!m_isSet)
+            std::vector<std::function<void(std::exception_ptr)>> continuations;
             {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_isSet)
+                {
+                    return;
+                }
+
                 m_promise.set_value();
                 m_isSet = true;
+                continuations.swap(m_continuations);
+            }
+
+            for (auto& continuation : continuations)
+            {
+                continuation(nullptr);
             }
         }
 
         // no op when already set
         void set(const std::exception_ptr& exception)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if (!m_isSet)
+            std::vector<std::function<void(std::exception_ptr)>> continuations;
             {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_isSet)
+                {
+                    return;
+                }
+
                 m_promise.set_exception(exception);
+                m_exception = exception;
                 m_isSet = true;
+                continuations.swap(m_continuations);
+            }
+
+            for (auto& continuation : continuations)
+            {
+                continuation(exception);
             }
         }
 
+        // runs the continuation on the thread that sets the event, or right away if the event is already set
+        void then(const std::function<void(std::exception_ptr)>& continuation)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_isSet)
+                {
+                    m_continuations.push_back(continuation);
+                    return;
+                }
+            }
+
+            continuation(m_exception);
+        }
+
         // blocks and returns when set or throws when an exception is set
         void get() const
         {
@@ -63,6 +103,8 @@ namespace signalr
 
         std::promise<void> m_promise;
         std::shared_future<void> m_future;
+        std::exception_ptr m_exception;
+        std::vector<std::function<void(std::exception_ptr)>> m_continuations;
         bool m_isSet;
         std::mutex m_mutex;
     };
@@ -97,6 +139,12 @@ namespace signalr
             m_impl->get();
         }
 
+        // runs the continuation on the thread that sets the event, or right away if the event is already set
+        void then(const std::function<void(std::exception_ptr)>& continuation)
+        {
+            m_impl->then(continuation);
+        }
+
         bool is_set() const
         {
             return m_impl->is_set();
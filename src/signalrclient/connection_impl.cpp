@@ -157,14 +157,68 @@ namespace signalr
             m_connection_id = "";
         }
 
-        m_scheduler = m_signalr_client_config.get_scheduler();
-        if (!m_scheduler)
+        auto previous_strand = get_strand();
+        if (!previous_strand)
         {
-            m_scheduler = std::make_shared<signalr_default_scheduler>();
-            m_signalr_client_config.set_scheduler(m_scheduler);
+            set_strand(strand::create(m_signalr_client_config.get_scheduler()));
+            start_negotiate(m_base_url, callback);
+            return;
         }
 
-        start_negotiate(m_base_url, callback);
+        // the previous connection's disconnected callback can still be queued on its strand behind a callback that is
+        // running, the connection starts once it ran so it never runs alongside the callbacks of this connection
+        std::weak_ptr<connection_impl> weak_connection = shared_from_this();
+        auto start_request_done = std::make_shared<std::atomic<bool>>(false);
+
+        // stop waits for the start to complete, which it can't while stop is called from the callback it is queued behind
+        m_disconnect_cts->register_callback([weak_connection, start_request_done, callback]()
+            {
+                if (start_request_done->exchange(true))
+                {
+                    // start_negotiate handles the cancellation
+                    return;
+                }
+
+                auto connection = weak_connection.lock();
+                if (connection)
+                {
+                    connection->m_logger.log(trace_level::info, "starting the connection has been canceled by stop().");
+                    connection->change_state(connection_state::disconnected);
+                    try
+                    {
+                        connection->m_start_completed_event.cancel();
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        if (connection->m_logger.is_enabled(trace_level::warning))
+                        {
+                            connection->m_logger.log(trace_level::warning, std::string("start completed event threw an exception in start: ")
+                                .append(ex.what()));
+                        }
+                    }
+                }
+                callback(std::make_exception_ptr(canceled_exception()));
+            });
+
+        previous_strand->dispatch([weak_connection, start_request_done, callback]()
+            {
+                if (start_request_done->exchange(true))
+                {
+                    // canceled by stop
+                    return;
+                }
+
+                auto connection = weak_connection.lock();
+                if (!connection)
+                {
+                    callback(std::make_exception_ptr(signalr_exception("connection no longer exists")));
+                    return;
+                }
+
+                // a new strand per start so callbacks still queued for the previous connection don't hold up this one
+                connection->set_strand(strand::create(connection->m_signalr_client_config.get_scheduler()));
+                connection->start_negotiate(connection->m_base_url, callback);
+            });
     }
 
     void connection_impl::start_negotiate(const std::string& url, std::function<void(std::exception_ptr)> callback)
@@ -412,6 +466,8 @@ namespace signalr
         auto weak_connection = std::weak_ptr<connection_impl>(connection);
         const auto disconnect_cts = m_disconnect_cts;
         const auto& logger = m_logger;
+        const auto strand = get_strand();
+        const auto caller_runs = m_signalr_client_config.get_callback_mode() == callback_mode::caller_runs;
 
         auto transport = connection->m_transport_factory->create_transport(
             transport_type::websockets, connection->m_logger, connection->m_signalr_client_config);
@@ -431,7 +487,7 @@ namespace signalr
                 connection->stop_connection(exception);
             });
 
-        transport->on_receive([disconnect_cts, logger, weak_connection, transport_started](std::string&& message, std::exception_ptr exception)
+        transport->on_receive([disconnect_cts, logger, weak_connection, transport_started, strand, caller_runs](std::string&& message, std::exception_ptr exception)
             {
                 if (exception == nullptr)
                 {
@@ -446,11 +502,27 @@ namespace signalr
                         return;
                     }
 
-                    auto connection = weak_connection.lock();
-                    if (connection)
+                    if (caller_runs)
                     {
-                        connection->process_response(std::move(message));
+                        // skips the strand, see callback_mode::caller_runs for what handlers give up in exchange
+                        auto connection = weak_connection.lock();
+                        if (connection)
+                        {
+                            connection->process_response(std::move(message));
+                        }
+                        return;
                     }
+
+                    // usually runs right away on the receive thread, it is only queued if another callback for this connection
+                    // is running so messages stay ordered with timers and the disconnected callback
+                    strand->dispatch(std::bind([weak_connection](std::string& message)
+                        {
+                            auto connection = weak_connection.lock();
+                            if (connection)
+                            {
+                                connection->process_response(std::move(message));
+                            }
+                        }, std::move(message)));
                 }
                 else
                 {
@@ -698,6 +770,7 @@ namespace signalr
     // do not use `shared_from_this` as it can be called via the destructor
     void connection_impl::stop_connection(std::exception_ptr error)
     {
+        std::shared_ptr<signalr::strand> strand;
         {
             // the lock prevents a race where the user calls `stop` on a disconnected connection and calls `start`
             // on a different thread at the same time. In this case we must not null out the transport if we are
@@ -725,6 +798,7 @@ namespace signalr
 
             change_state(connection_state::disconnected);
             m_transport = nullptr;
+            strand = get_strand();
         }
 
         if (error)
@@ -746,26 +820,33 @@ namespace signalr
             m_logger.log(trace_level::info, "connection closed");
         }
 
-        try
-        {
-            m_disconnected(error);
-        }
-        catch (const std::exception & e)
-        {
-            if (m_logger.is_enabled(trace_level::error))
+        // runs after any messages that were received before the connection closed, captures copies rather than `this`
+        // since the callback can be queued and this can be called via the destructor
+        auto disconnected = m_disconnected;
+        auto logger = m_logger;
+        strand->dispatch([disconnected, logger, error]()
             {
-                m_logger.log(
-                    trace_level::error,
-                    std::string("disconnected callback threw an exception: ")
-                    .append(e.what()));
-            }
-        }
-        catch (...)
-        {
-            m_logger.log(
-                trace_level::error,
-                "disconnected callback threw an unknown exception");
-        }
+                try
+                {
+                    disconnected(error);
+                }
+                catch (const std::exception & e)
+                {
+                    if (logger.is_enabled(trace_level::error))
+                    {
+                        logger.log(
+                            trace_level::error,
+                            std::string("disconnected callback threw an exception: ")
+                            .append(e.what()));
+                    }
+                }
+                catch (...)
+                {
+                    logger.log(
+                        trace_level::error,
+                        "disconnected callback threw an unknown exception");
+                }
+            });
     }
 
     connection_state connection_impl::get_connection_state() const noexcept
@@ -783,6 +864,24 @@ namespace signalr
         return m_connection_id;
     }
 
+    void connection_impl::pause_receiving() noexcept
+    {
+        auto transport = m_transport;
+        if (transport)
+        {
+            transport->pause_receiving();
+        }
+    }
+
+    void connection_impl::resume_receiving() noexcept
+    {
+        auto transport = m_transport;
+        if (transport)
+        {
+            transport->resume_receiving();
+        }
+    }
+
     void connection_impl::set_message_received(const std::function<void(std::string&&)>& message_received)
     {
         ensure_disconnected("cannot set the callback when the connection is not in the disconnected state. ");
@@ -795,6 +894,18 @@ namespace signalr
         m_signalr_client_config = config;
     }
 
+    std::shared_ptr<strand> connection_impl::get_strand() const
+    {
+        std::lock_guard<std::mutex> lock(m_strand_lock);
+        return m_strand;
+    }
+
+    void connection_impl::set_strand(std::shared_ptr<strand> strand)
+    {
+        std::lock_guard<std::mutex> lock(m_strand_lock);
+        m_strand = std::move(strand);
+    }
+
     void connection_impl::set_disconnected(const std::function<void(std::exception_ptr)>& disconnected)
     {
         ensure_disconnected("cannot set the disconnected callback when the connection is not in the disconnected state. ");
@@ -14,6 +14,7 @@
 #include "logger.h"
 #include "negotiation_response.h"
 #include "cancellation_token_source.h"
+#include "strand.h"
 
 namespace signalr
 {
@@ -44,11 +45,19 @@ namespace signalr
         std::string get_connection_id() const noexcept;
 
         void set_message_received(const std::function<void(std::string&&)>& message_received);
+        // see transport::pause_receiving, no-ops while there is no transport
+        void pause_receiving() noexcept;
+        void resume_receiving() noexcept;
         void set_disconnected(const std::function<void(std::exception_ptr)>& disconnected);
         void set_client_config(const signalr_client_config& config);
 
+        // received messages and the disconnected callback run on this strand, it is created when the connection starts
+        std::shared_ptr<strand> get_strand() const;
+
     private:
-        std::shared_ptr<scheduler> m_scheduler;
+        // replaced by start while callbacks of the previous connection can still read it
+        std::shared_ptr<strand> m_strand;
+        mutable std::mutex m_strand_lock;
         std::string m_base_url;
         std::atomic<connection_state> m_connection_state;
         logger m_logger;
@@ -71,6 +80,7 @@ namespace signalr
         connection_impl(const std::string& url, trace_level trace_level, const std::shared_ptr<log_writer>& log_writer,
             std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory, std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory, bool skip_negotiation);
 
+        void set_strand(std::shared_ptr<strand> strand);
         void start_transport(const std::string& url, std::function<void(std::shared_ptr<transport>, std::exception_ptr)> callback);
         void send_connect_request(const std::shared_ptr<transport>& transport,
             const std::string& url, std::function<void(std::exception_ptr)> callback);
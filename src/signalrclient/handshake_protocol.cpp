@@ -5,6 +5,7 @@
 #include "stdafx.h"
 #include "handshake_protocol.h"
 #include "json_helpers.h"
+#include "json_writer.h"
 #include "signalrclient/signalr_exception.h"
 
 namespace signalr
@@ -13,13 +14,17 @@ namespace signalr
     {
         std::string write_handshake(const std::unique_ptr<hub_protocol>& protocol)
         {
-            auto map = std::map<std::string, signalr::value>
-            {
-                { "protocol", signalr::value(protocol->name()) },
-                { "version", signalr::value((double)protocol->version()) }
-            };
+            std::string handshake;
+            json_writer writer(handshake);
+            writer.write_object_start();
+            writer.write_member_name("protocol");
+            writer.write_string(protocol->name());
+            writer.write_member_name("version");
+            writer.write_int64(protocol->version());
+            writer.write_object_end();
+            handshake.push_back(record_separator);
 
-            return Json::writeString(getJsonWriter(), createJson(signalr::value(std::move(map)))) + record_separator;
+            return handshake;
         }
 
         std::tuple<std::string, signalr::value> parse_handshake(const std::string& response)
@@ -85,6 +85,17 @@ namespace signalr
         return m_pImpl->invoke(method_name, arguments, callback);
     }
 
+    void hub_connection::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception("invoke() cannot be called on destructed hub_connection instance")));
+            return;
+        }
+
+        return m_pImpl->invoke(method_name, arguments, callback, timeout);
+    }
+
     void hub_connection::send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept
     {
         if (!m_pImpl)
@@ -96,6 +107,30 @@ namespace signalr
         m_pImpl->send(method_name, arguments, callback);
     }
 
+    std::function<void()> hub_connection::stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept
+    {
+        if (!m_pImpl)
+        {
+            on_complete(std::make_exception_ptr(signalr_exception("stream() cannot be called on destructed hub_connection instance")));
+            return []() {};
+        }
+
+        return m_pImpl->stream(method_name, arguments, on_item, on_complete);
+    }
+
+    std::shared_ptr<upload_stream> hub_connection::upload(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception("upload() cannot be called on destructed hub_connection instance")));
+            return std::shared_ptr<upload_stream>(new upload_stream(std::weak_ptr<hub_connection_impl>(), ""));
+        }
+
+        return m_pImpl->upload(method_name, arguments, callback);
+    }
+
     connection_state hub_connection::get_connection_state() const
     {
         if (!m_pImpl)
@@ -116,6 +151,16 @@ namespace signalr
         return m_pImpl->get_connection_id();
     }
 
+    size_t hub_connection::get_pending_invocation_count() const
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("get_pending_invocation_count() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->get_pending_invocation_count();
+    }
+
     void hub_connection::set_disconnected(const std::function<void(std::exception_ptr)>& disconnected_callback)
     {
         if (!m_pImpl)
@@ -126,6 +171,16 @@ namespace signalr
         m_pImpl->set_disconnected(disconnected_callback);
     }
 
+    void hub_connection::set_ready_to_send(const std::function<void()>& ready_to_send_callback)
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("set_ready_to_send() cannot be called on destructed hub_connection instance");
+        }
+
+        m_pImpl->set_ready_to_send(ready_to_send_callback);
+    }
+
     void hub_connection::set_client_config(const signalr_client_config& config)
     {
         if (!m_pImpl)
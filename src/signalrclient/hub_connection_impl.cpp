@@ -5,6 +5,7 @@
 #include "stdafx.h"
 #include "hub_connection_impl.h"
 #include "signalrclient/hub_exception.h"
+#include "signalrclient/timeout_exception.h"
 #include "trace_log_writer.h"
 #include "signalrclient/signalr_exception.h"
 #include "json_hub_protocol.h"
@@ -12,12 +13,16 @@
 #include "handshake_protocol.h"
 #include "signalrclient/websocket_client.h"
 #include "signalr_default_scheduler.h"
+#include "timer.h"
+#include "keepalive_manager.h"
 
 namespace signalr
 {
     // unnamed namespace makes it invisble outside this translation unit
     namespace
     {
+        const char invocation_timeout_error[] = "timed out waiting for the server to complete the invocation.";
+
         static std::function<void(const char*, const signalr::value&)> create_hub_invocation_callback(const logger& logger,
             const std::function<void(const signalr::value&)>& set_result,
             const std::function<void(const std::exception_ptr e)>& set_exception);
@@ -41,7 +46,9 @@ namespace signalr
         : m_connection(connection_impl::create(url, trace_level, log_writer, http_client_factory, websocket_factory, skip_negotiation))
             , m_logger(log_writer, trace_level),
         m_callback_manager("connection went out of scope before invocation result was received"),
-        m_handshakeReceived(false), m_disconnected([](std::exception_ptr) noexcept {}), m_protocol(std::move(hub_protocol))
+        m_handshakeReceived(false), m_disconnected([](std::exception_ptr) noexcept {}), m_clock(nullptr), m_protocol(std::move(hub_protocol)),
+        m_framer(m_protocol->transfer_format()), m_keepalive_registration(0), m_invocation_timer_deadline(callback_manager::clock::time_point::max()),
+        m_flow_control_blocked(false), m_draining_held_calls(false), m_outbound_bytes(0), m_full_streams(0), m_next_stream_id(0)
     {
         hub_message ping_msg(signalr::message_type::ping);
         m_cached_ping = m_protocol->write_message(&ping_msg);
@@ -66,6 +73,12 @@ namespace signalr
             auto connection = weak_hub_connection.lock();
             if (connection)
             {
+                auto keepalive_registration = connection->m_keepalive_registration.exchange(0);
+                if (keepalive_registration != 0)
+                {
+                    connection->m_keepalive_manager->remove(keepalive_registration);
+                }
+
                 // start may be waiting on the handshake response so we complete it here, this no-ops if already set
                 connection->m_handshakeTask->set(std::make_exception_ptr(signalr_exception("connection closed while handshake was in progress.")));
                 try
@@ -81,6 +94,8 @@ namespace signalr
                     }
                 }
 
+                connection->stop_invocation_timer();
+                connection->fail_held_calls();
                 connection->m_callback_manager.clear("connection was stopped before invocation result was received");
 
                 connection->m_disconnected(exception);
@@ -121,10 +136,28 @@ namespace signalr
         }
 
         m_connection->set_client_config(m_signalr_client_config);
-        m_handshakeTask = std::make_shared<completion_event>();
-        m_disconnect_cts = std::make_shared<cancellation_token_source>();
-        m_handshakeReceived = false;
         std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+
+        // the previous connection's messages and disconnect handler can still be queued on its strand behind a callback that
+        // is running, they use the state reset here so it's reset after them. The connection doesn't start before this ran
+        // since it waits for the previous strand as well.
+        auto previous_strand = m_connection->get_strand();
+        if (previous_strand)
+        {
+            previous_strand->dispatch([weak_connection]()
+                {
+                    auto connection = weak_connection.lock();
+                    if (connection)
+                    {
+                        connection->reset_for_start();
+                    }
+                });
+        }
+        else
+        {
+            reset_for_start();
+        }
+
         m_connection->start([weak_connection, callback](std::exception_ptr start_exception)
             {
                 auto connection = weak_connection.lock();
@@ -150,6 +183,17 @@ namespace signalr
                 {
                     assert(fromSend ? *handshake_request_done : true);
 
+                    {
+                        std::lock_guard<std::mutex> lock(*handshake_request_lock);
+                        // connection.send will be waiting on the handshake task which has been set by the caller already
+                        if (!fromSend && *handshake_request_done == true)
+                        {
+                            return;
+                        }
+                        *handshake_request_done = true;
+                    }
+
+                    // checked after the request state so that a callback that already ran, and let the connection go, isn't run twice
                     auto connection = weak_connection.lock();
                     if (!connection)
                     {
@@ -158,39 +202,58 @@ namespace signalr
                         return;
                     }
 
+                    auto complete_handshake = [weak_connection, callback](std::exception_ptr exception)
                     {
-                        std::lock_guard<std::mutex> lock(*handshake_request_lock);
-                        // connection.send will be waiting on the handshake task which has been set by the caller already
-                        if (!fromSend && *handshake_request_done == true)
+                        auto connection = weak_connection.lock();
+                        if (!connection)
                         {
+                            // The connection has been destructed
+                            callback(std::make_exception_ptr(signalr_exception("the hub connection has been deconstructed")));
                             return;
                         }
-                        *handshake_request_done = true;
-                    }
 
-                    try
-                    {
-                        if (exception == nullptr)
+                        try
                         {
-                            connection->m_handshakeTask->get();
-                            callback(nullptr);
+                            if (exception == nullptr)
+                            {
+                                // keepalive is running by the time the user hears about the connection, the timer stops
+                                // itself if the connection is stopped from the callback
+                                connection->start_keepalive();
+                                callback(nullptr);
+                            }
+                        }
+                        catch (...)
+                        {
+                            exception = std::current_exception();
                         }
-                    }
-                    catch (...)
-                    {
-                        exception = std::current_exception();
-                    }
 
-                    if (exception != nullptr)
+                        if (exception != nullptr)
+                        {
+                            connection->m_connection->stop([callback, exception](std::exception_ptr)
+                                {
+                                    callback(exception);
+                                }, exception);
+                        }
+                    };
+
+                    if (exception == nullptr)
                     {
-                        connection->m_connection->stop([callback, exception](std::exception_ptr)
+                        // the handshake response may not have arrived yet, finish when it does instead of blocking this thread
+                        // which could be one the response needs in order to be processed. The event is set while the response
+                        // is processed on the connection's strand, finishing is handed to the scheduler so a start callback
+                        // that waits on a message from the server doesn't hold up the strand that would deliver it.
+                        auto scheduler = connection->m_signalr_client_config.get_scheduler();
+                        connection->m_handshakeTask->then([scheduler, complete_handshake](std::exception_ptr exception)
                             {
-                                callback(exception);
-                            }, exception);
+                                scheduler->schedule([complete_handshake, exception]()
+                                    {
+                                        complete_handshake(exception);
+                                    });
+                            });
                     }
                     else
                     {
-                        connection->start_keepalive();
+                        complete_handshake(exception);
                     }
                 };
 
@@ -215,8 +278,10 @@ namespace signalr
                         handle_handshake(nullptr, false);
                     });
 
-                timer(connection->m_signalr_client_config.get_scheduler(),
-                    [handle_handshake, handshake_task, handshake_timeout, handshake_request_lock](std::chrono::milliseconds duration)
+                // timers run on the connection's strand so they never race with received messages
+                auto handshake_timer = timer::create(connection->m_connection->get_strand());
+                handshake_timer->schedule_after(handshake_timeout,
+                    [handle_handshake, handshake_task, handshake_request_lock]()
                     {
                         {
                             std::lock_guard<std::mutex> lock(*handshake_request_lock);
@@ -225,12 +290,7 @@ namespace signalr
                             // or stop has been called and will be handling the callback
                             if (handshake_task->is_set())
                             {
-                                return true;
-                            }
-
-                            if (duration < handshake_timeout)
-                            {
-                                return false;
+                                return;
                             }
                         }
 
@@ -239,7 +299,12 @@ namespace signalr
                         handshake_task->set(exception);
 
                         handle_handshake(exception, false);
-                        return true;
+                    });
+
+                // no need for the timeout once the handshake completed one way or another
+                handshake_task->then([handshake_timer](std::exception_ptr)
+                    {
+                        handshake_timer->cancel();
                     });
 
                 connection->m_connection->send(handshake_request, connection->m_protocol->transfer_format(),
@@ -263,6 +328,17 @@ namespace signalr
             });
     }
 
+    void hub_connection_impl::reset_for_start()
+    {
+        const auto& scheduler = m_signalr_client_config.get_scheduler();
+        m_clock = find_clock(*scheduler);
+        m_keepalive_manager = keepalive_manager::for_scheduler(scheduler);
+        m_handshakeTask = std::make_shared<completion_event>();
+        m_disconnect_cts = std::make_shared<cancellation_token_source>();
+        m_handshakeReceived = false;
+        m_framer.reset();
+    }
+
     void hub_connection_impl::stop(std::function<void(std::exception_ptr)> callback, bool is_dtor) noexcept
     {
         if (get_connection_state() == connection_state::disconnected)
@@ -318,16 +394,24 @@ namespace signalr
         }
     }
 
-    void hub_connection_impl::process_message(std::string&& response)
+    void hub_connection_impl::process_message(std::string&& frame)
     {
+        m_framer.append(std::move(frame));
+        std::string response;
         try
         {
             if (!m_handshakeReceived)
             {
+                if (!m_framer.take_handshake(response))
+                {
+                    // the rest of the handshake response is in the frames to come
+                    return;
+                }
+
                 signalr::value handshake;
                 std::tie(response, handshake) = handshake::parse_handshake(response);
 
-                auto& obj = handshake.as_map();
+                auto& obj = handshake.as_value_map();
                 auto found = obj.find("error");
                 if (found != obj.end())
                 {
@@ -351,16 +435,34 @@ namespace signalr
 
                     m_handshakeReceived = true;
                     m_handshakeTask->set();
-
-                    if (response.size() == 0)
-                    {
-                        return;
-                    }
                 }
             }
 
             reset_server_timeout();
-            auto messages = m_protocol->parse_messages(response);
+            // the messages the frame completed, the frame may end in the middle of one or not even finish the one that
+            // started in an earlier frame
+            response = m_framer.take_messages();
+            if (response.empty())
+            {
+                return;
+            }
+
+            std::vector<std::unique_ptr<hub_message>> messages;
+            if (m_signalr_client_config.get_use_message_arena())
+            {
+                if (!m_message_arena)
+                {
+                    m_message_arena.reset(new value_arena());
+                }
+
+                // only the parsing runs in the scope, what handlers allocate doesn't go to the arena
+                value_arena::scope scope(m_message_arena.get());
+                messages = m_protocol->parse_messages(response);
+            }
+            else
+            {
+                messages = m_protocol->parse_messages(response);
+            }
 
             for (const auto& val : messages)
             {
@@ -391,8 +493,30 @@ namespace signalr
                     // Sent to server only, should not be received by client
                     throw std::runtime_error("Received unexpected message type 'StreamInvocation'");
                 case message_type::stream_item:
-                    // TODO
+                {
+                    auto stream_item = static_cast<stream_item_message*>(val.get());
+                    std::shared_ptr<stream_item_queue> queue;
+                    {
+                        std::lock_guard<std::mutex> lock(m_streams_lock);
+                        auto found = m_streams.find(stream_item->invocation_id);
+                        if (found != m_streams.end())
+                        {
+                            queue = found->second;
+                        }
+                    }
+
+                    if (queue)
+                    {
+                        // the item outlives the frame, copying moves it out of the arena
+                        queue->push(m_message_arena ? signalr::value(stream_item->item) : std::move(stream_item->item));
+                    }
+                    else if (m_logger.is_enabled(trace_level::info))
+                    {
+                        // items the server sent before it saw the stream was canceled
+                        m_logger.log(trace_level::info, std::string("no stream found for id: ").append(stream_item->invocation_id));
+                    }
                     break;
+                }
                 case message_type::completion:
                 {
                     auto completion = static_cast<completion_message*>(val.get());
@@ -430,6 +554,12 @@ namespace signalr
             // TODO: Consider passing "reason" exception to stop
             m_connection->stop([](std::exception_ptr) {}, std::current_exception());
         }
+
+        // the frame's messages are gone, nothing uses what they allocated from the arena anymore
+        if (m_message_arena)
+        {
+            m_message_arena->release();
+        }
     }
 
     bool hub_connection_impl::invoke_callback(completion_message* completion)
@@ -455,42 +585,178 @@ namespace signalr
 
     void hub_connection_impl::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
     {
-        const auto& callback_id = m_callback_manager.register_callback(
-            create_hub_invocation_callback(m_logger, [callback](const signalr::value& result) { callback(result, nullptr); },
-                [callback](const std::exception_ptr e) { callback(signalr::value(), e); }));
+        invoke(method_name, arguments, callback, m_signalr_client_config.get_invocation_timeout());
+    }
+
+    void hub_connection_impl::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback,
+        std::chrono::milliseconds timeout) noexcept
+    {
+        // a held invocation's timeout starts when invoke is called
+        auto deadline = callback_manager::clock::time_point::max();
+        if (timeout > std::chrono::milliseconds::zero())
+        {
+            deadline = clock_now(m_clock) + timeout;
+        }
+
+        admit_invocation(method_name, arguments, std::vector<std::string>(), callback, deadline);
+    }
 
-        invoke_hub_method(method_name, arguments, callback_id, nullptr,
+    void hub_connection_impl::admit_invocation(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        const std::vector<std::string>& stream_ids, const std::function<void(const signalr::value&, std::exception_ptr)>& callback,
+        callback_manager::clock::time_point deadline) noexcept
+    {
+        switch (admit(true))
+        {
+        case admission::reject:
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception(
+                "the invocation was rejected because the connection reached its limit of pending invocations or outbound bytes")));
+            // what was in flight may have completed before the rejection was recorded and nothing would report ready
+            drain_held_calls();
+            return;
+        case admission::hold:
+            // held calls are only made or failed by the connection itself, so they can't outlive it
+            hold(true, std::bind([this](const std::string& method_name, const std::vector<signalr::value>& arguments,
+                const std::vector<std::string>& stream_ids, const std::function<void(const signalr::value&, std::exception_ptr)>& callback,
+                callback_manager::clock::time_point deadline, std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        callback(signalr::value(), exception);
+                    }
+                    else
+                    {
+                        start_invocation(method_name, arguments, stream_ids, callback, deadline);
+                    }
+                }, method_name, arguments, stream_ids, callback, deadline, std::placeholders::_1));
+            return;
+        case admission::now:
+            break;
+        }
+
+        start_invocation(method_name, arguments, stream_ids, callback, deadline);
+    }
+
+    void hub_connection_impl::start_invocation(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        const std::vector<std::string>& stream_ids, const std::function<void(const signalr::value&, std::exception_ptr)>& callback,
+        callback_manager::clock::time_point deadline) noexcept
+    {
+        // a completed invocation may let a held call through
+        std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+        std::function<void(const std::exception_ptr)> set_exception = [callback, weak_connection](const std::exception_ptr e)
+        {
+            callback(signalr::value(), e);
+            auto connection = weak_connection.lock();
+            if (connection)
+            {
+                connection->drain_held_calls();
+            }
+        };
+
+        std::function<void()> on_expired;
+        if (deadline != callback_manager::clock::time_point::max())
+        {
+            on_expired = [set_exception]()
+            {
+                set_exception(std::make_exception_ptr(timeout_exception(invocation_timeout_error)));
+            };
+        }
+
+        const auto callback_id = m_callback_manager.register_callback(
+            create_hub_invocation_callback(m_logger,
+                [callback, weak_connection](const signalr::value& result)
+                {
+                    callback(result, nullptr);
+                    auto connection = weak_connection.lock();
+                    if (connection)
+                    {
+                        connection->drain_held_calls();
+                    }
+                },
+                set_exception), deadline, std::move(on_expired));
+
+        if (deadline != callback_manager::clock::time_point::max())
+        {
+            arm_invocation_timer(deadline);
+        }
+
+        // the id only takes its string form for the message, short enough to not need an allocation
+        char buffer[callback_manager::max_callback_id_length];
+        const std::string invocation_id(buffer, callback_manager::format_callback_id(callback_id, buffer));
+
+        invoke_hub_method(message_type::invocation, method_name, arguments, stream_ids, invocation_id, nullptr,
             [callback](const std::exception_ptr e){ callback(signalr::value(), e); });
     }
 
     void hub_connection_impl::send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept
     {
-        invoke_hub_method(method_name, arguments, "",
+        switch (admit(false))
+        {
+        case admission::reject:
+            callback(std::make_exception_ptr(signalr_exception(
+                "the message was rejected because the connection reached its limit of outbound bytes")));
+            drain_held_calls();
+            return;
+        case admission::hold:
+            hold(false, std::bind([this](const std::string& method_name, const std::vector<signalr::value>& arguments,
+                const std::function<void(std::exception_ptr)>& callback, std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        callback(exception);
+                    }
+                    else
+                    {
+                        invoke_hub_method(message_type::invocation, method_name, arguments, std::vector<std::string>(), "",
+                            [callback]() { callback(nullptr); },
+                            [callback](const std::exception_ptr e){ callback(e); });
+                    }
+                }, method_name, arguments, callback, std::placeholders::_1));
+            return;
+        case admission::now:
+            break;
+        }
+
+        invoke_hub_method(message_type::invocation, method_name, arguments, std::vector<std::string>(), "",
             [callback]() { callback(nullptr); },
             [callback](const std::exception_ptr e){ callback(e); });
     }
 
-    void hub_connection_impl::invoke_hub_method(const std::string& method_name, const std::vector<signalr::value>& arguments,
-        const std::string& callback_id, std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept
+    void hub_connection_impl::invoke_hub_method(signalr::message_type message_type, const std::string& method_name, const std::vector<signalr::value>& arguments,
+        const std::vector<std::string>& stream_ids, const std::string& callback_id, std::function<void()> set_completion,
+        std::function<void(const std::exception_ptr)> set_exception) noexcept
+    {
+        send_hub_message(invocation_message(message_type, callback_id, method_name, arguments, stream_ids), callback_id,
+            std::move(set_completion), std::move(set_exception));
+    }
+
+    void hub_connection_impl::send_hub_message(const hub_message& hub_message, const std::string& callback_id,
+        std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept
     {
         try
         {
-            invocation_message invocation(callback_id, method_name, arguments);
-            auto message = m_protocol->write_message(&invocation);
+            auto message = m_protocol->write_message(&hub_message);
+            const auto message_size = message.size();
+            m_outbound_bytes += message_size;
 
             // weak_ptr prevents a circular dependency leading to memory leak and other problems
             auto weak_hub_connection = std::weak_ptr<hub_connection_impl>(shared_from_this());
 
-            m_connection->send(message, m_protocol->transfer_format(), [set_completion, set_exception, weak_hub_connection, callback_id](std::exception_ptr exception)
+            m_connection->send(message, m_protocol->transfer_format(), [set_completion, set_exception, weak_hub_connection, callback_id, message_size](std::exception_ptr exception)
                 {
+                    auto hub_connection = weak_hub_connection.lock();
+                    if (hub_connection)
+                    {
+                        hub_connection->m_outbound_bytes -= message_size;
+                    }
+
                     if (exception)
                     {
-                        auto hub_connection = weak_hub_connection.lock();
-                        if (hub_connection)
+                        // an invocation that timed out, completed or was cleared by stop or the connection's destructor in
+                        // the meantime already reported its outcome
+                        if (callback_id.empty() || (hub_connection && hub_connection->m_callback_manager.remove_callback(callback_id)))
                         {
-                            hub_connection->m_callback_manager.remove_callback(callback_id);
+                            set_exception(exception);
                         }
-                        set_exception(exception);
                     }
                     else
                     {
@@ -500,21 +766,231 @@ namespace signalr
                             set_completion();
                         }
                     }
+
+                    if (hub_connection)
+                    {
+                        hub_connection->drain_held_calls();
+                    }
                 });
 
             reset_send_ping();
         }
         catch (const std::exception& e)
         {
-            m_callback_manager.remove_callback(callback_id);
             if (m_logger.is_enabled(trace_level::warning))
             {
-                m_logger.log(trace_level::warning, std::string("failed to send invocation: ").append(e.what()));
+                m_logger.log(trace_level::warning, std::string("failed to send message: ").append(e.what()));
+            }
+            if (callback_id.empty() || m_callback_manager.remove_callback(callback_id))
+            {
+                set_exception(std::current_exception());
+            }
+            drain_held_calls();
+        }
+    }
+
+    std::function<void()> hub_connection_impl::stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept
+    {
+        std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+        auto queue = stream_item_queue::create(m_signalr_client_config.get_scheduler(), m_signalr_client_config.get_stream_buffer_capacity(),
+            std::move(on_item), std::move(on_complete), [weak_connection](bool full)
+            {
+                auto connection = weak_connection.lock();
+                if (connection)
+                {
+                    connection->stream_full_changed(full);
+                }
+            });
+
+        // the id is only known once the callback is registered, and the stream can't complete before it is sent
+        auto stream_id = std::make_shared<std::string>();
+        auto end = [weak_connection, queue, stream_id](std::exception_ptr error)
+        {
+            auto connection = weak_connection.lock();
+            if (connection)
+            {
+                connection->end_stream(*stream_id, error);
+            }
+            else
+            {
+                queue->complete(error);
             }
-            set_exception(std::current_exception());
+        };
+
+        const auto callback_id = m_callback_manager.register_callback(
+            create_hub_invocation_callback(m_logger, [end](const signalr::value&) { end(nullptr); }, end));
+
+        char buffer[callback_manager::max_callback_id_length];
+        stream_id->assign(buffer, callback_manager::format_callback_id(callback_id, buffer));
+
+        {
+            std::lock_guard<std::mutex> lock(m_streams_lock);
+            m_streams.emplace(*stream_id, queue);
+        }
+
+        invoke_hub_method(message_type::stream_invocation, method_name, arguments, std::vector<std::string>(), *stream_id, nullptr, end);
+
+        auto id = *stream_id;
+        return [weak_connection, id]()
+        {
+            auto connection = weak_connection.lock();
+            if (connection)
+            {
+                connection->cancel_stream(id);
+            }
+        };
+    }
+
+    void hub_connection_impl::stream_full_changed(bool full)
+    {
+        // the transport counts the pauses so the calls of different streams can interleave
+        if (full)
+        {
+            ++m_full_streams;
+            if (m_logger.is_enabled(trace_level::debug))
+            {
+                m_logger.log(trace_level::debug, "a stream's buffer is full, pausing receive.");
+            }
+            m_connection->pause_receiving();
+        }
+        else
+        {
+            --m_full_streams;
+            if (m_logger.is_enabled(trace_level::debug))
+            {
+                m_logger.log(trace_level::debug, "a stream's buffer has room, resuming receive.");
+            }
+            // whatever the server sent while receiving was paused is about to be read
+            reset_server_timeout();
+            m_connection->resume_receiving();
         }
     }
 
+    void hub_connection_impl::end_stream(const std::string& stream_id, std::exception_ptr error)
+    {
+        std::shared_ptr<stream_item_queue> queue;
+        {
+            std::lock_guard<std::mutex> lock(m_streams_lock);
+            auto found = m_streams.find(stream_id);
+            if (found == m_streams.end())
+            {
+                return;
+            }
+
+            queue = std::move(found->second);
+            m_streams.erase(found);
+        }
+
+        queue->complete(error);
+    }
+
+    void hub_connection_impl::cancel_stream(const std::string& stream_id)
+    {
+        // a stream that completed or failed already has nothing to cancel
+        if (!m_callback_manager.remove_callback(stream_id))
+        {
+            return;
+        }
+
+        std::shared_ptr<stream_item_queue> queue;
+        {
+            std::lock_guard<std::mutex> lock(m_streams_lock);
+            auto found = m_streams.find(stream_id);
+            if (found != m_streams.end())
+            {
+                queue = std::move(found->second);
+                m_streams.erase(found);
+            }
+        }
+
+        if (queue)
+        {
+            queue->cancel(std::make_exception_ptr(signalr_exception("the stream was canceled")));
+        }
+
+        try
+        {
+            cancel_invocation_message cancel_invocation(stream_id);
+            auto message = m_protocol->write_message(&cancel_invocation);
+            std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+            m_connection->send(message, m_protocol->transfer_format(), [weak_connection](std::exception_ptr exception)
+                {
+                    auto connection = weak_connection.lock();
+                    if (connection && exception && connection->m_logger.is_enabled(trace_level::warning))
+                    {
+                        connection->m_logger.log(trace_level::warning, "failed to send stream cancellation.");
+                    }
+                });
+
+            reset_send_ping();
+        }
+        catch (const std::exception& e)
+        {
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to send stream cancellation: ").append(e.what()));
+            }
+        }
+    }
+
+    std::shared_ptr<upload_stream> hub_connection_impl::upload(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
+    {
+        // the server keeps the stream ids apart from the invocation ids
+        auto stream_id = std::to_string(m_next_stream_id++);
+        auto stream = std::shared_ptr<upload_stream>(new upload_stream(shared_from_this(), stream_id));
+
+        std::weak_ptr<upload_stream> weak_stream = stream;
+        auto on_result = [callback, weak_stream](const signalr::value& result, std::exception_ptr exception)
+        {
+            // the server stopped reading the stream, whether the invocation failed or the hub method returned early
+            auto stream = weak_stream.lock();
+            if (stream)
+            {
+                stream->m_completed = true;
+            }
+            callback(result, exception);
+        };
+
+        admit_invocation(method_name, arguments, std::vector<std::string>{ stream_id }, on_result,
+            callback_manager::clock::time_point::max());
+
+        return stream;
+    }
+
+    void hub_connection_impl::send_stream_message(std::shared_ptr<hub_message> message, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        // stream messages are subject to the outbound bytes limit like send, and are held behind the invocation they
+        // belong to when it is held
+        switch (admit(false))
+        {
+        case admission::reject:
+            callback(std::make_exception_ptr(signalr_exception(
+                "the message was rejected because the connection reached its limit of outbound bytes")));
+            drain_held_calls();
+            return;
+        case admission::hold:
+            hold(false, std::bind([this](const std::shared_ptr<hub_message>& message, const std::function<void(std::exception_ptr)>& callback,
+                std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        callback(exception);
+                    }
+                    else
+                    {
+                        send_hub_message(*message, "", [callback]() { callback(nullptr); }, callback);
+                    }
+                }, message, callback, std::placeholders::_1));
+            return;
+        case admission::now:
+            break;
+        }
+
+        send_hub_message(*message, "", [callback]() { callback(nullptr); }, callback);
+    }
+
     connection_state hub_connection_impl::get_connection_state() const noexcept
     {
         return m_connection->get_connection_state();
@@ -525,6 +1001,11 @@ namespace signalr
         return m_connection->get_connection_id();
     }
 
+    size_t hub_connection_impl::get_pending_invocation_count()
+    {
+        return m_callback_manager.size();
+    }
+
     void hub_connection_impl::set_client_config(const signalr_client_config& config)
     {
         m_signalr_client_config = config;
@@ -536,15 +1017,21 @@ namespace signalr
         m_disconnected = disconnected;
     }
 
+    void hub_connection_impl::set_ready_to_send(const std::function<void()>& ready_to_send)
+    {
+        std::lock_guard<std::mutex> lock(m_flow_control_lock);
+        m_ready_to_send = ready_to_send;
+    }
+
     void hub_connection_impl::reset_send_ping()
     {
-        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_keepalive_interval()).time_since_epoch();
+        auto timeMs = (clock_now(m_clock) + m_signalr_client_config.get_keepalive_interval()).time_since_epoch();
         m_nextActivationSendPing.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
     }
 
     void hub_connection_impl::reset_server_timeout()
     {
-        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_server_timeout()).time_since_epoch();
+        auto timeMs = (clock_now(m_clock) + m_signalr_client_config.get_server_timeout()).time_since_epoch();
         m_nextActivationServerTimeout.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
     }
 
@@ -601,56 +1088,289 @@ namespace signalr
         };
 
         send_ping(shared_from_this());
+        // the ping deadline is reset again once the send completes, until then assume it will be
+        reset_send_ping();
         reset_server_timeout();
 
+        // the deadlines live in a timing wheel shared by every connection on the scheduler, the check only runs once the
+        // earlier of them is due. Actions are dispatched to the connection's strand so they never race with received
+        // messages.
+        auto first_check = std::chrono::steady_clock::time_point(std::chrono::milliseconds(
+            std::min(m_nextActivationSendPing.load(), m_nextActivationServerTimeout.load())));
         std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
-        timer(m_signalr_client_config.get_scheduler(),
-            [send_ping, weak_connection](std::chrono::milliseconds)
+        auto keepalive_registration = m_keepalive_manager->add(first_check,
+            [send_ping, weak_connection](std::chrono::steady_clock::time_point now)
             {
                 auto connection = weak_connection.lock();
 
-                if (!connection)
+                if (!connection || connection->get_connection_state() != connection_state::connected)
                 {
-                    return true;
-                }
-
-                if (connection->get_connection_state() != connection_state::connected)
-                {
-                    return true;
+                    return std::chrono::steady_clock::time_point::max();
                 }
 
                 auto timeNowmSeconds =
-                    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+                    std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 
-                if (timeNowmSeconds > connection->m_nextActivationServerTimeout.load())
+                auto nextServerTimeout = connection->m_nextActivationServerTimeout.load();
+                // while a stream holds receiving back the server's messages wait in the transport
+                if (timeNowmSeconds >= nextServerTimeout && connection->m_full_streams.load() <= 0)
                 {
-                    if (connection->get_connection_state() == connection_state::connected)
-                    {
-                        auto error_msg = std::string("server timeout (")
-                            .append(std::to_string(connection->m_signalr_client_config.get_server_timeout().count()))
-                            .append(" ms) elapsed without receiving a message from the server.");
-                        if (connection->m_logger.is_enabled(trace_level::warning))
+                    connection->m_connection->get_strand()->dispatch([connection]()
                         {
-                            connection->m_logger.log(trace_level::warning, error_msg);
-                        }
+                            if (connection->get_connection_state() != connection_state::connected)
+                            {
+                                return;
+                            }
 
-                        connection->m_connection->stop([](std::exception_ptr)
+                            auto error_msg = std::string("server timeout (")
+                                .append(std::to_string(connection->m_signalr_client_config.get_server_timeout().count()))
+                                .append(" ms) elapsed without receiving a message from the server.");
+                            if (connection->m_logger.is_enabled(trace_level::warning))
                             {
-                            }, std::make_exception_ptr(signalr_exception(error_msg)));
-                    }
+                                connection->m_logger.log(trace_level::warning, error_msg);
+                            }
+
+                            connection->m_connection->stop([](std::exception_ptr)
+                                {
+                                }, std::make_exception_ptr(signalr_exception(error_msg)));
+                        });
+
+                    return std::chrono::steady_clock::time_point::max();
+                }
+
+                auto nextSendPing = connection->m_nextActivationSendPing.load();
+                if (timeNowmSeconds >= nextSendPing)
+                {
+                    connection->m_connection->get_strand()->dispatch([send_ping, connection]()
+                        {
+                            if (connection->m_logger.is_enabled(trace_level::debug))
+                            {
+                                connection->m_logger.log(trace_level::debug, "sending ping to server.");
+                            }
+                            send_ping(connection);
+                        });
+
+                    // the ping deadline is reset once the send completes, until then assume it will be
+                    nextSendPing = timeNowmSeconds + std::chrono::duration_cast<std::chrono::milliseconds>(
+                        connection->m_signalr_client_config.get_keepalive_interval()).count();
+                }
+
+                // while a stream holds receiving the server timeout is looked at again on the next ping
+                auto next = std::min(nextSendPing, nextServerTimeout);
+                if (next <= timeNowmSeconds)
+                {
+                    next = nextSendPing;
+                }
+                return std::chrono::steady_clock::time_point(std::chrono::milliseconds(next));
+            });
+
+        auto previous_registration = m_keepalive_registration.exchange(keepalive_registration);
+        if (previous_registration != 0)
+        {
+            m_keepalive_manager->remove(previous_registration);
+        }
+    }
+
+    void hub_connection_impl::arm_invocation_timer(callback_manager::clock::time_point deadline)
+    {
+        std::lock_guard<std::mutex> lock(m_invocation_timer_lock);
+
+        // a timer armed for an earlier deadline re-arms itself for the next one when it fires
+        if (deadline >= m_invocation_timer_deadline)
+        {
+            return;
+        }
+
+        if (!m_invocation_timer)
+        {
+            // expired invocations complete on the strand like every other invocation, the strand only exists once the
+            // connection started
+            std::shared_ptr<scheduler> scheduler = m_connection->get_strand();
+            if (!scheduler)
+            {
+                scheduler = m_signalr_client_config.get_scheduler();
+            }
+            m_invocation_timer = timer::create(scheduler);
+        }
+
+        schedule_invocation_timer(deadline);
+    }
+
+    void hub_connection_impl::expire_invocations()
+    {
+        auto expired = m_callback_manager.expire(clock_now(m_clock));
+        if (expired != 0 && m_logger.is_enabled(trace_level::warning))
+        {
+            m_logger.log(trace_level::warning, std::string("timed out waiting for the result of ")
+                .append(std::to_string(expired))
+                .append(expired == 1 ? " invocation, " : " invocations, ")
+                .append(std::to_string(m_callback_manager.size()))
+                .append(" pending."));
+        }
+
+        // the next deadline is looked up under the lock so an invocation made in the meantime either sees the timer as armed
+        // for the deadline that just passed and relies on this call, or sees the deadline set here
+        std::lock_guard<std::mutex> lock(m_invocation_timer_lock);
+        m_invocation_timer_deadline = callback_manager::clock::time_point::max();
+        if (!m_invocation_timer)
+        {
+            // the connection closed
+            return;
+        }
+
+        auto next_deadline = m_callback_manager.next_deadline();
+        if (next_deadline == callback_manager::clock::time_point::max())
+        {
+            return;
+        }
+
+        schedule_invocation_timer(next_deadline);
+    }
+
+    // must be called with m_invocation_timer_lock held
+    void hub_connection_impl::schedule_invocation_timer(callback_manager::clock::time_point deadline)
+    {
+        m_invocation_timer_deadline = deadline;
+
+        std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+        m_invocation_timer->schedule_at(deadline, [weak_connection]()
+            {
+                auto connection = weak_connection.lock();
+                if (connection)
+                {
+                    connection->expire_invocations();
                 }
+            });
+    }
+
+    void hub_connection_impl::stop_invocation_timer()
+    {
+        std::lock_guard<std::mutex> lock(m_invocation_timer_lock);
+        if (m_invocation_timer)
+        {
+            m_invocation_timer->cancel();
+            // the next start creates a new strand
+            m_invocation_timer = nullptr;
+        }
+        m_invocation_timer_deadline = callback_manager::clock::time_point::max();
+    }
+
+    hub_connection_impl::admission hub_connection_impl::admit(bool is_invocation)
+    {
+        if (m_signalr_client_config.get_max_pending_invocations() == 0 && m_signalr_client_config.get_max_outbound_bytes() == 0)
+        {
+            return admission::now;
+        }
+
+        std::lock_guard<std::mutex> lock(m_flow_control_lock);
+        // calls that are already held go first
+        if (m_held_calls.empty() && !at_limit(is_invocation))
+        {
+            return admission::now;
+        }
 
-                if (timeNowmSeconds > connection->m_nextActivationSendPing.load())
+        m_flow_control_blocked = true;
+        return m_signalr_client_config.get_flow_control_mode() == flow_control_mode::reject ? admission::reject : admission::hold;
+    }
+
+    bool hub_connection_impl::at_limit(bool is_invocation)
+    {
+        const auto max_pending_invocations = m_signalr_client_config.get_max_pending_invocations();
+        if (is_invocation && max_pending_invocations != 0 && m_callback_manager.size() >= max_pending_invocations)
+        {
+            return true;
+        }
+
+        const auto max_outbound_bytes = m_signalr_client_config.get_max_outbound_bytes();
+        return max_outbound_bytes != 0 && m_outbound_bytes >= max_outbound_bytes;
+    }
+
+    void hub_connection_impl::hold(bool is_invocation, std::function<void(std::exception_ptr)>&& call)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_flow_control_lock);
+            held_call held;
+            held.is_invocation = is_invocation;
+            held.call = std::move(call);
+            m_held_calls.push_back(std::move(held));
+        }
+
+        // whatever was in flight when the call was admitted may have completed since
+        drain_held_calls();
+    }
+
+    void hub_connection_impl::drain_held_calls()
+    {
+        if (!m_flow_control_blocked)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_flow_control_lock);
+            // a call made below completes synchronously when the websocket sends synchronously, the loop below picks up
+            // where a nested drain would have
+            if (m_draining_held_calls)
+            {
+                return;
+            }
+            m_draining_held_calls = true;
+        }
+
+        std::function<void()> ready_to_send;
+        while (true)
+        {
+            std::function<void(std::exception_ptr)> call;
+            {
+                std::lock_guard<std::mutex> lock(m_flow_control_lock);
+                if (m_held_calls.empty())
                 {
-                    if (connection->m_logger.is_enabled(trace_level::debug))
+                    // rejected callers only hear about it from the ready to send callback, so it waits for both limits
+                    if (m_flow_control_blocked && !at_limit(true))
                     {
-                        connection->m_logger.log(trace_level::debug, "sending ping to server.");
+                        m_flow_control_blocked = false;
+                        ready_to_send = m_ready_to_send;
                     }
-                    send_ping(connection);
+                    m_draining_held_calls = false;
+                    break;
                 }
 
-                return false;
-            });
+                if (at_limit(m_held_calls.front().is_invocation))
+                {
+                    m_draining_held_calls = false;
+                    break;
+                }
+
+                call = m_held_calls.pop_front().call;
+            }
+
+            call(nullptr);
+        }
+
+        if (ready_to_send)
+        {
+            m_signalr_client_config.get_scheduler()->schedule(ready_to_send);
+        }
+    }
+
+    void hub_connection_impl::fail_held_calls()
+    {
+        while (true)
+        {
+            std::function<void(std::exception_ptr)> call;
+            {
+                std::lock_guard<std::mutex> lock(m_flow_control_lock);
+                if (m_held_calls.empty())
+                {
+                    m_flow_control_blocked = false;
+                    return;
+                }
+
+                call = m_held_calls.pop_front().call;
+            }
+
+            call(std::make_exception_ptr(signalr_exception("the connection was stopped before the call was sent")));
+        }
     }
 
     // unnamed namespace makes it invisble outside this translation unit
@@ -11,8 +11,16 @@
 #include "signalrclient/signalr_value.h"
 #include "hub_protocol.h"
 #include "logger.h"
+#include "message_framer.h"
 #include "cancellation_token_source.h"
 #include "connection_impl.h"
+#include "keepalive_manager.h"
+#include "timer.h"
+#include "scheduler_clock.h"
+#include "ring_queue.h"
+#include "stream_item_queue.h"
+#include "value_arena.h"
+#include "signalrclient/upload_stream.h"
 
 namespace signalr
 {
@@ -36,18 +44,28 @@ namespace signalr
         void on(const std::string& event_name, const std::function<void(const std::vector<signalr::value>&)>& handler);
 
         void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept;
+        void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback,
+            std::chrono::milliseconds timeout) noexcept;
         void send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept;
+        std::function<void()> stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept;
+        std::shared_ptr<upload_stream> upload(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept;
 
         void start(std::function<void(std::exception_ptr)> callback) noexcept;
         void stop(std::function<void(std::exception_ptr)> callback, bool is_dtor = false) noexcept;
 
         connection_state get_connection_state() const noexcept;
         std::string get_connection_id() const;
+        size_t get_pending_invocation_count();
 
         void set_client_config(const signalr_client_config& config);
         void set_disconnected(const std::function<void(std::exception_ptr)>& disconnected);
+        void set_ready_to_send(const std::function<void()>& ready_to_send);
 
     private:
+        friend class upload_stream;
+
         hub_connection_impl(const std::string& url, std::unique_ptr<hub_protocol>&& hub_protocol, trace_level trace_level,
             const std::shared_ptr<log_writer>& log_writer, std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory,
             std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory,
@@ -62,26 +80,103 @@ namespace signalr
         std::function<void(std::exception_ptr)> m_disconnected;
         std::shared_ptr<cancellation_token_source> m_disconnect_cts;
         signalr_client_config m_signalr_client_config;
+        // the clock of the scheduler the connection runs on, resolved when it starts, null for the steady clock
+        std::atomic<const clock_source*> m_clock;
         std::unique_ptr<hub_protocol> m_protocol;
         std::string m_cached_ping;
+        message_framer m_framer;
+        // created by the first frame parsed with signalr_client_config::set_use_message_arena enabled
+        std::unique_ptr<value_arena> m_message_arena;
 
         std::atomic<int64_t> m_nextActivationServerTimeout;
         std::atomic<int64_t> m_nextActivationSendPing;
+        std::shared_ptr<keepalive_manager> m_keepalive_manager;
+        // 0 when keepalive isn't running
+        std::atomic<uint64_t> m_keepalive_registration;
+
+        std::mutex m_invocation_timer_lock;
+        // fires at the earliest invocation deadline, created on the connection's strand the first time an invocation with a
+        // timeout is made after the connection started
+        std::shared_ptr<timer> m_invocation_timer;
+        // when the invocation timer is armed for, time_point::max() when it isn't armed
+        callback_manager::clock::time_point m_invocation_timer_deadline;
+
+#pragma warning( push )
+#pragma warning( disable: 4625 5026 4626 5027 )
+        struct held_call
+        {
+            bool is_invocation;
+            // makes the call when given nullptr, otherwise fails it with the given error
+            std::function<void(std::exception_ptr)> call;
+        };
+#pragma warning( pop )
+
+        enum class admission
+        {
+            now,
+            hold,
+            reject
+        };
+
+        std::mutex m_flow_control_lock;
+        ring_queue<held_call> m_held_calls;
+        // set once a call was held or rejected, cleared when the connection is below its limits again and the ready to send
+        // callback has been scheduled. Read without the lock to keep completions cheap while nothing is held back.
+        std::atomic<bool> m_flow_control_blocked;
+        // a thread is making held calls, calls completing on it or on other threads leave the held calls to it
+        bool m_draining_held_calls;
+        // bytes handed to the connection that it hasn't reported sent yet
+        std::atomic<size_t> m_outbound_bytes;
+        std::function<void()> m_ready_to_send;
+
+        std::mutex m_streams_lock;
+        // the item queues of the streams that haven't completed yet, by invocation id
+        std::unordered_map<std::string, std::shared_ptr<stream_item_queue>> m_streams;
+        // streams whose queue is full, receiving is paused while there are any and the server can't be expected to get a
+        // message through. A stream may report room before it reports being full so this can briefly be negative.
+        std::atomic<int> m_full_streams;
+        std::atomic<uint64_t> m_next_stream_id;
 
         std::mutex m_stop_callback_lock;
         std::vector<std::function<void(std::exception_ptr)>> m_stop_callbacks;
 
         void initialize();
-
-        void process_message(std::string&& message);
-
-        void invoke_hub_method(const std::string& method_name, const std::vector<signalr::value>& arguments, const std::string& callback_id,
-            std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept;
+        void reset_for_start();
+
+        void process_message(std::string&& frame);
+
+        void admit_invocation(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            const std::vector<std::string>& stream_ids, const std::function<void(const signalr::value&, std::exception_ptr)>& callback,
+            callback_manager::clock::time_point deadline) noexcept;
+        void start_invocation(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            const std::vector<std::string>& stream_ids, const std::function<void(const signalr::value&, std::exception_ptr)>& callback,
+            callback_manager::clock::time_point deadline) noexcept;
+        void invoke_hub_method(signalr::message_type message_type, const std::string& method_name, const std::vector<signalr::value>& arguments,
+            const std::vector<std::string>& stream_ids, const std::string& callback_id, std::function<void()> set_completion,
+            std::function<void(const std::exception_ptr)> set_exception) noexcept;
+        void send_hub_message(const hub_message& hub_message, const std::string& callback_id, std::function<void()> set_completion,
+            std::function<void(const std::exception_ptr)> set_exception) noexcept;
+        // sends an item or the completion of an upload_stream
+        void send_stream_message(std::shared_ptr<hub_message> message, std::function<void(std::exception_ptr)> callback) noexcept;
         bool invoke_callback(completion_message* completion);
+        void stream_full_changed(bool full);
+        void end_stream(const std::string& stream_id, std::exception_ptr error);
+        void cancel_stream(const std::string& stream_id);
 
         void reset_send_ping();
         void reset_server_timeout();
 
         void start_keepalive();
+
+        void arm_invocation_timer(callback_manager::clock::time_point deadline);
+        void schedule_invocation_timer(callback_manager::clock::time_point deadline);
+        void expire_invocations();
+        void stop_invocation_timer();
+
+        admission admit(bool is_invocation);
+        bool at_limit(bool is_invocation);
+        void hold(bool is_invocation, std::function<void(std::exception_ptr)>&& call);
+        void drain_held_calls();
+        void fail_held_calls();
     };
 }
@@ -4,13 +4,18 @@
 
 #include "stdafx.h"
 #include "json_helpers.h"
-#include <cmath>
 #include <stdint.h>
 
 namespace signalr
 {
     char record_separator = '\x1e';
 
+    namespace
+    {
+        // the first double past INT64_MAX, as 2 * two_to_the_63 is the first one past UINT64_MAX
+        const double two_to_the_63 = 9223372036854775808.0;
+    }
+
     signalr::value createValue(const Json::Value& v)
     {
         switch (v.type())
@@ -18,28 +23,32 @@ namespace signalr
         case Json::ValueType::booleanValue:
             return signalr::value(v.asBool());
         case Json::ValueType::realValue:
+            return signalr::value(v.asDouble());
         case Json::ValueType::intValue:
         case Json::ValueType::uintValue:
-            return signalr::value(v.asDouble());
+            // jsoncpp reads positive integers past INT_MAX as uintValue, they are int64 unless they don't fit
+            return v.isInt64() ? signalr::value(static_cast<int64_t>(v.asInt64())) : signalr::value(static_cast<uint64_t>(v.asUInt64()));
         case Json::ValueType::stringValue:
             return signalr::value(v.asString());
         case Json::ValueType::arrayValue:
         {
-            std::vector<signalr::value> vec;
+            value_vector<signalr::value> vec;
+            vec.reserve(v.size());
             for (auto& val : v)
             {
                 vec.push_back(createValue(val));
             }
-            return signalr::value(std::move(vec));
+            return signalr::value(value_array(std::move(vec)));
         }
         case Json::ValueType::objectValue:
         {
-            std::map<std::string, signalr::value> map;
-            for (const auto& val : v.getMemberNames())
+            value_vector<std::pair<std::string, signalr::value>> members;
+            members.reserve(v.size());
+            for (auto it = v.begin(); it != v.end(); ++it)
             {
-                map.insert({ val, createValue(v[val]) });
+                members.emplace_back(it.name(), createValue(*it));
             }
-            return signalr::value(std::move(map));
+            return signalr::value(value_map(std::move(members)));
         }
         case Json::ValueType::nullValue:
         default:
@@ -118,45 +127,33 @@ namespace signalr
         case signalr::value_type::float64:
         {
             auto value = v.as_double();
-            double intPart;
             // Workaround for 1.0 being output as 1.0 instead of 1
-            // because the server expects certain values to be 1 instead of 1.0 (like protocol version)
-            if (std::modf(value, &intPart) == 0)
+            // because the server expects certain values to be 1 instead of 1.0 (like integer arguments)
+            if (value >= -two_to_the_63 && value < two_to_the_63)
             {
-                if (value < 0)
+                // in this range the conversion is exact for integral doubles and truncates the others
+                auto integer = static_cast<int64_t>(value);
+                if (static_cast<double>(integer) == value)
                 {
-                    if (value >= (double)INT64_MIN)
-                    {
-                        // Fits within int64_t
-                        return Json::Value(static_cast<int64_t>(intPart));
-                    }
-                    else
-                    {
-                        // Remain as double
-                        return Json::Value(value);
-                    }
-                }
-                else
-                {
-                    if (value <= (double)UINT64_MAX)
-                    {
-                        // Fits within uint64_t
-                        return Json::Value(static_cast<uint64_t>(intPart));
-                    }
-                    else
-                    {
-                        // Remain as double
-                        return Json::Value(value);
-                    }
+                    return Json::Value(static_cast<Json::Int64>(integer));
                 }
             }
-            return Json::Value(v.as_double());
+            // every double this large is integral
+            else if (value >= two_to_the_63 && value < 2 * two_to_the_63)
+            {
+                return Json::Value(static_cast<Json::UInt64>(value));
+            }
+            return Json::Value(value);
         }
+        case signalr::value_type::int64:
+            return Json::Value(static_cast<Json::Int64>(v.as_int64()));
+        case signalr::value_type::uint64:
+            return Json::Value(static_cast<Json::UInt64>(v.as_uint64()));
         case signalr::value_type::string:
             return Json::Value(v.as_string());
         case signalr::value_type::array:
         {
-            const auto& array = v.as_array();
+            const auto& array = v.as_value_array();
             Json::Value vec(Json::ValueType::arrayValue);
             for (auto& val : array)
             {
@@ -166,7 +163,7 @@ namespace signalr
         }
         case signalr::value_type::map:
         {
-            const auto& obj = v.as_map();
+            const auto& obj = v.as_value_map();
             Json::Value object(Json::ValueType::objectValue);
             for (auto& val : obj)
             {
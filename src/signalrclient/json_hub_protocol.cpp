@@ -6,51 +6,277 @@
 #include "json_hub_protocol.h"
 #include "message_type.h"
 #include "json_helpers.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "text_scanner.h"
 #include "signalrclient/signalr_exception.h"
+#include <algorithm>
 
 namespace signalr
 {
+    namespace
+    {
+        bool to_stream_ids(const std::vector<signalr::value>& values, std::vector<std::string>& stream_ids)
+        {
+            stream_ids.reserve(values.size());
+            for (auto& value : values)
+            {
+                if (!value.is_string())
+                {
+                    return false;
+                }
+                stream_ids.push_back(value.as_string());
+            }
+            return true;
+        }
+
+        // Reads a valid message straight from the text into the hub_message. Returns false for anything it doesn't
+        // handle, malformed JSON as well as valid JSON that isn't a valid message, without telling what is wrong with it.
+        bool read_message(const char* begin, size_t length, std::unique_ptr<hub_message>& hub_message)
+        {
+            json_reader reader(begin, length);
+
+            bool end;
+            if (!reader.read_object_start(end))
+            {
+                return false;
+            }
+
+            bool has_type = false;
+            double type = 0;
+            bool has_target = false;
+            std::string target;
+            bool has_arguments = false;
+            std::vector<signalr::value> arguments;
+            bool has_invocation_id = false;
+            std::string invocation_id;
+            bool has_error = false;
+            std::string error;
+            bool has_result = false;
+            signalr::value result;
+            bool has_item = false;
+            signalr::value item;
+            bool has_stream_ids = false;
+            std::vector<signalr::value> stream_id_values;
+            // members the protocol doesn't use are read and dropped, their names are only kept to find duplicates
+            std::vector<std::string> other_names;
+
+            std::string name;
+            while (!end)
+            {
+                if (!reader.read_member_name(name))
+                {
+                    return false;
+                }
+
+                bool read;
+                if (name == "type")
+                {
+                    read = !has_type && reader.read_number(type);
+                    has_type = true;
+                }
+                else if (name == "target")
+                {
+                    read = !has_target && reader.read_string(target);
+                    has_target = true;
+                }
+                else if (name == "arguments")
+                {
+                    read = !has_arguments && reader.read_array(arguments);
+                    has_arguments = true;
+                }
+                else if (name == "invocationId")
+                {
+                    read = !has_invocation_id && reader.read_string(invocation_id);
+                    has_invocation_id = true;
+                }
+                else if (name == "error")
+                {
+                    read = !has_error && reader.read_string(error);
+                    has_error = true;
+                }
+                else if (name == "result")
+                {
+                    read = !has_result && reader.read_value(result);
+                    has_result = true;
+                }
+                else if (name == "item")
+                {
+                    read = !has_item && reader.read_value(item);
+                    has_item = true;
+                }
+                else if (name == "streamIds")
+                {
+                    read = !has_stream_ids && reader.read_array(stream_id_values);
+                    has_stream_ids = true;
+                }
+                else
+                {
+                    signalr::value ignored;
+                    read = std::find(other_names.begin(), other_names.end(), name) == other_names.end() && reader.read_value(ignored);
+                    other_names.push_back(name);
+                }
+
+                if (!read || !reader.read_member_separator(end))
+                {
+                    return false;
+                }
+            }
+
+            if (!reader.at_end() || !has_type)
+            {
+                return false;
+            }
+
+#pragma warning (push)
+            // not all cases handled (we have a default so it's fine)
+#pragma warning (disable: 4061)
+            switch (static_cast<message_type>(static_cast<int>(type)))
+            {
+            case message_type::invocation:
+            {
+                std::vector<std::string> stream_ids;
+                if (!has_target || !has_arguments || !to_stream_ids(stream_id_values, stream_ids))
+                {
+                    return false;
+                }
+
+                hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(std::move(invocation_id),
+                    std::move(target), std::move(arguments), std::move(stream_ids)));
+                return true;
+            }
+            case message_type::completion:
+                if (!has_invocation_id || (!error.empty() && has_result))
+                {
+                    return false;
+                }
+
+                hub_message = std::unique_ptr<signalr::hub_message>(new completion_message(std::move(invocation_id),
+                    std::move(error), std::move(result), has_result));
+                return true;
+            case message_type::stream_item:
+                if (!has_invocation_id || !has_item)
+                {
+                    return false;
+                }
+
+                hub_message = std::unique_ptr<signalr::hub_message>(new stream_item_message(std::move(invocation_id), std::move(item)));
+                return true;
+            case message_type::stream_invocation:
+            {
+                std::vector<std::string> stream_ids;
+                if (!has_invocation_id || !has_target || !has_arguments || !to_stream_ids(stream_id_values, stream_ids))
+                {
+                    return false;
+                }
+
+                hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(message_type::stream_invocation,
+                    invocation_id, target, arguments, stream_ids));
+                return true;
+            }
+            case message_type::cancel_invocation:
+                if (!has_invocation_id)
+                {
+                    return false;
+                }
+
+                hub_message = std::unique_ptr<signalr::hub_message>(new cancel_invocation_message(invocation_id));
+                return true;
+            case message_type::ping:
+                hub_message = std::unique_ptr<signalr::hub_message>(new ping_message());
+                return true;
+            default:
+                // ignored like parse_message does
+                return true;
+            }
+#pragma warning (pop)
+        }
+    }
+
     std::string signalr::json_hub_protocol::write_message(const hub_message* hub_message) const
     {
-        Json::Value object(Json::ValueType::objectValue);
+        std::string payload;
+        write_message(hub_message, payload);
+        return payload;
+    }
+
+    void json_hub_protocol::write_message(const hub_message* hub_message, std::string& payload) const
+    {
+        json_writer writer(payload);
+        writer.write_object_start();
 
+        // members are written in alphabetical order, like jsoncpp did
 #pragma warning (push)
 #pragma warning (disable: 4061)
         switch (hub_message->message_type)
         {
         case message_type::invocation:
+        case message_type::stream_invocation:
         {
             auto invocation = static_cast<invocation_message const*>(hub_message);
-            object["type"] = static_cast<int>(invocation->message_type);
+            writer.write_member_name("arguments");
+            writer.write_array(invocation->arguments);
             if (!invocation->invocation_id.empty())
             {
-                object["invocationId"] = invocation->invocation_id;
+                writer.write_member_name("invocationId");
+                writer.write_string(invocation->invocation_id);
             }
-            object["target"] = invocation->target;
-            object["arguments"] = createJson(invocation->arguments);
-            // TODO: streamIds
+            if (!invocation->stream_ids.empty())
+            {
+                writer.write_member_name("streamIds");
+                writer.write_array(invocation->stream_ids);
+            }
+            writer.write_member_name("target");
+            writer.write_string(invocation->target);
+            writer.write_member_name("type");
+            writer.write_int64(static_cast<int64_t>(invocation->message_type));
 
             break;
         }
         case message_type::completion:
         {
             auto completion = static_cast<completion_message const*>(hub_message);
-            object["type"] = static_cast<int>(completion->message_type);
-            object["invocationId"] = completion->invocation_id;
             if (!completion->error.empty())
             {
-                object["error"] = completion->error;
+                writer.write_member_name("error");
+                writer.write_string(completion->error);
             }
-            else if (completion->has_result)
+            writer.write_member_name("invocationId");
+            writer.write_string(completion->invocation_id);
+            if (completion->error.empty() && completion->has_result)
             {
-                object["result"] = createJson(completion->result);
+                writer.write_member_name("result");
+                writer.write_value(completion->result);
             }
+            writer.write_member_name("type");
+            writer.write_int64(static_cast<int64_t>(completion->message_type));
+            break;
+        }
+        case message_type::stream_item:
+        {
+            auto stream_item = static_cast<stream_item_message const*>(hub_message);
+            writer.write_member_name("invocationId");
+            writer.write_string(stream_item->invocation_id);
+            writer.write_member_name("item");
+            writer.write_value(stream_item->item);
+            writer.write_member_name("type");
+            writer.write_int64(static_cast<int64_t>(stream_item->message_type));
+            break;
+        }
+        case message_type::cancel_invocation:
+        {
+            auto cancel_invocation = static_cast<cancel_invocation_message const*>(hub_message);
+            writer.write_member_name("invocationId");
+            writer.write_string(cancel_invocation->invocation_id);
+            writer.write_member_name("type");
+            writer.write_int64(static_cast<int64_t>(cancel_invocation->message_type));
             break;
         }
         case message_type::ping:
         {
             auto ping = static_cast<ping_message const*>(hub_message);
-            object["type"] = static_cast<int>(ping->message_type);
+            writer.write_member_name("type");
+            writer.write_int64(static_cast<int64_t>(ping->message_type));
             break;
         }
         // TODO: other message types
@@ -59,15 +285,22 @@ namespace signalr
         }
 #pragma warning (pop)
 
-        return Json::writeString(getJsonWriter(), object) + record_separator;
+        writer.write_object_end();
+        payload.push_back(record_separator);
     }
 
     std::vector<std::unique_ptr<hub_message>> json_hub_protocol::parse_messages(const std::string& message) const
     {
+        std::vector<size_t> separators;
+        if (!text_scanner::scan(message.data(), message.size(), record_separator, separators))
+        {
+            throw signalr_exception("message is not valid UTF-8");
+        }
+
         std::vector<std::unique_ptr<hub_message>> vec;
+        vec.reserve(separators.size());
         size_t offset = 0;
-        auto pos = message.find(record_separator, offset);
-        while (pos != std::string::npos)
+        for (auto pos : separators)
         {
             auto hub_message = parse_message(message.c_str() + offset, pos - offset);
             if (hub_message != nullptr)
@@ -76,15 +309,21 @@ namespace signalr
             }
 
             offset = pos + 1;
-            pos = message.find(record_separator, offset);
         }
-        // if offset < message.size()
-        // log or close connection because we got an incomplete message
+        // message_framer only passes on complete messages so nothing comes after the last separator
         return vec;
     }
 
     std::unique_ptr<hub_message> json_hub_protocol::parse_message(const char* begin, size_t length) const
     {
+        std::unique_ptr<hub_message> message;
+        if (read_message(begin, length, message))
+        {
+            return message;
+        }
+
+        // read_message doesn't handle this message, most likely because it is invalid. Going through jsoncpp reports the
+        // error the same way it always has, or parses the message if it is valid after all.
         Json::Value root;
         auto reader = getJsonReader();
         std::string errors;
@@ -94,7 +333,6 @@ namespace signalr
             throw signalr_exception(errors);
         }
 
-        // TODO: manually go through the json object to avoid short-lived allocations
         auto value = createValue(root);
 
         if (!value.is_map())
@@ -102,7 +340,7 @@ namespace signalr
             throw signalr_exception("Message was not a 'map' type");
         }
 
-        const auto& obj = value.as_map();
+        const auto& obj = value.as_value_map();
 
         auto found = obj.find("type");
         if (found == obj.end())
@@ -115,14 +353,17 @@ namespace signalr
 #pragma warning (push)
         // not all cases handled (we have a default so it's fine)
 #pragma warning (disable: 4061)
-        switch (static_cast<message_type>(static_cast<int>(found->second.as_double())))
+        auto type = static_cast<message_type>(static_cast<int>(found->second.as_double()));
+        switch (type)
         {
         case message_type::invocation:
+        case message_type::stream_invocation:
         {
+            const char* type_name = type == message_type::invocation ? "invocation" : "stream_invocation";
             found = obj.find("target");
             if (found == obj.end())
             {
-                throw signalr_exception("Field 'target' not found for 'invocation' message");
+                throw signalr_exception(std::string("Field 'target' not found for '").append(type_name).append("' message"));
             }
             if (!found->second.is_string())
             {
@@ -132,7 +373,7 @@ namespace signalr
             found = obj.find("arguments");
             if (found == obj.end())
             {
-                throw signalr_exception("Field 'arguments' not found for 'invocation' message");
+                throw signalr_exception(std::string("Field 'arguments' not found for '").append(type_name).append("' message"));
             }
             if (!found->second.is_array())
             {
@@ -143,6 +384,10 @@ namespace signalr
             found = obj.find("invocationId");
             if (found == obj.end())
             {
+                if (type == message_type::stream_invocation)
+                {
+                    throw signalr_exception("Field 'invocationId' not found for 'stream_invocation' message");
+                }
                 invocation_id = "";
             }
             else
@@ -154,9 +399,52 @@ namespace signalr
                 invocation_id = found->second.as_string();
             }
 
-            hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(invocation_id,
-                obj.find("target")->second.as_string(), obj.find("arguments")->second.as_array()));
+            std::vector<std::string> stream_ids;
+            found = obj.find("streamIds");
+            if (found != obj.end())
+            {
+                if (!found->second.is_array())
+                {
+                    throw signalr_exception("Expected 'streamIds' to be of type 'array'");
+                }
+                if (!to_stream_ids(found->second.as_value_array(), stream_ids))
+                {
+                    throw signalr_exception("Expected 'streamIds' to only contain values of type 'string'");
+                }
+            }
+
+            hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(type, invocation_id,
+                obj.find("target")->second.as_string(), obj.find("arguments")->second.as_value_array(), stream_ids));
+
+            break;
+        }
+        case message_type::stream_item:
+        case message_type::cancel_invocation:
+        {
+            const char* type_name = type == message_type::stream_item ? "stream_item" : "cancel_invocation";
+            found = obj.find("invocationId");
+            if (found == obj.end())
+            {
+                throw signalr_exception(std::string("Field 'invocationId' not found for '").append(type_name).append("' message"));
+            }
+            if (!found->second.is_string())
+            {
+                throw signalr_exception("Expected 'invocationId' to be of type 'string'");
+            }
+
+            if (type == message_type::cancel_invocation)
+            {
+                hub_message = std::unique_ptr<signalr::hub_message>(new cancel_invocation_message(found->second.as_string()));
+                break;
+            }
+
+            auto item = obj.find("item");
+            if (item == obj.end())
+            {
+                throw signalr_exception("Field 'item' not found for 'stream_item' message");
+            }
 
+            hub_message = std::unique_ptr<signalr::hub_message>(new stream_item_message(found->second.as_string(), item->second));
             break;
         }
         case message_type::completion:
@@ -13,6 +13,8 @@ namespace signalr
     {
     public:
         std::string write_message(const hub_message*) const;
+        // appends the message to the payload, which lets a caller build several messages into one buffer or reuse it
+        void write_message(const hub_message*, std::string& payload) const;
         std::vector<std::unique_ptr<hub_message>> parse_messages(const std::string&) const;
 
         const std::string& name() const
@@ -0,0 +1,642 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "json_reader.h"
+#include <sstream>
+
+namespace signalr
+{
+    namespace
+    {
+        // same as the default stackLimit of the jsoncpp reader
+        const size_t max_depth = 1000;
+
+        // the most significant digits of a number that are kept exactly, 10^19 - 1 still fits in a uint64_t
+        const int max_significant_digits = 19;
+
+        // powers of ten that are exact as doubles, a double that is exact multiplied or divided by one of them is rounded
+        // once so the result is the same as parsing the text with correct rounding
+        const double exact_powers_of_ten[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const int max_exact_power_of_ten = 22;
+        const uint64_t max_exact_mantissa = uint64_t(1) << 53;
+
+        bool is_digit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        void append_utf8(std::string& str, uint32_t code_point)
+        {
+            if (code_point < 0x80)
+            {
+                str.push_back(static_cast<char>(code_point));
+            }
+            else if (code_point < 0x800)
+            {
+                str.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                str.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else if (code_point < 0x10000)
+            {
+                str.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                str.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else
+            {
+                str.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                str.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+        }
+    }
+
+    json_reader::json_reader(const char* begin, size_t length)
+        : m_current(begin), m_end(begin + length)
+    { }
+
+    bool json_reader::read_object_start(bool& end)
+    {
+        skip_whitespace();
+        if (!consume('{'))
+        {
+            return false;
+        }
+
+        skip_whitespace();
+        end = consume('}');
+        return true;
+    }
+
+    bool json_reader::read_member_name(std::string& name)
+    {
+        skip_whitespace();
+        if (!read_string(name))
+        {
+            return false;
+        }
+
+        skip_whitespace();
+        return consume(':');
+    }
+
+    bool json_reader::read_member_separator(bool& end)
+    {
+        skip_whitespace();
+        if (consume(','))
+        {
+            end = false;
+            return true;
+        }
+
+        end = true;
+        return consume('}');
+    }
+
+    bool json_reader::read_value(signalr::value& value)
+    {
+        return read_value(value, 1);
+    }
+
+    bool json_reader::read_array(std::vector<signalr::value>& array)
+    {
+        skip_whitespace();
+        const auto first = m_elements.size();
+        if (!read_elements(1))
+        {
+            return false;
+        }
+
+        array.assign(std::make_move_iterator(m_elements.begin() + first), std::make_move_iterator(m_elements.end()));
+        m_elements.erase(m_elements.begin() + first, m_elements.end());
+        return true;
+    }
+
+    bool json_reader::at_end()
+    {
+        skip_whitespace();
+        return m_current == m_end;
+    }
+
+    bool json_reader::read_value(signalr::value& value, size_t depth)
+    {
+        if (depth > max_depth)
+        {
+            return false;
+        }
+
+        skip_whitespace();
+        if (m_current == m_end)
+        {
+            return false;
+        }
+
+        switch (*m_current)
+        {
+        case '{':
+        {
+            value_map map;
+            if (!read_map(map, depth))
+            {
+                return false;
+            }
+            value = signalr::value(std::move(map));
+            return true;
+        }
+        case '[':
+        {
+            const auto first = m_elements.size();
+            if (!read_elements(depth))
+            {
+                return false;
+            }
+
+            value = signalr::value(value_array(
+                std::make_move_iterator(m_elements.begin() + first), std::make_move_iterator(m_elements.end())));
+            m_elements.erase(m_elements.begin() + first, m_elements.end());
+            return true;
+        }
+        case '"':
+        {
+            std::string str;
+            if (!read_string(str))
+            {
+                return false;
+            }
+            value = signalr::value(std::move(str));
+            return true;
+        }
+        case 't':
+            value = signalr::value(true);
+            return read_literal("true", 4);
+        case 'f':
+            value = signalr::value(false);
+            return read_literal("false", 5);
+        case 'n':
+            value = signalr::value();
+            return read_literal("null", 4);
+        default:
+        {
+            if (read_integer(value))
+            {
+                return true;
+            }
+
+            double number;
+            if (!read_number(number))
+            {
+                return false;
+            }
+            value = signalr::value(number);
+            return true;
+        }
+        }
+    }
+
+    bool json_reader::read_elements(size_t depth)
+    {
+        if (!consume('['))
+        {
+            return false;
+        }
+
+        skip_whitespace();
+        if (consume(']'))
+        {
+            return true;
+        }
+
+        if (m_elements.capacity() == 0)
+        {
+            // enough for most messages without growing
+            m_elements.reserve(16);
+        }
+
+        while (true)
+        {
+            // read on the side, nested arrays grow m_elements
+            signalr::value value;
+            if (!read_value(value, depth + 1))
+            {
+                return false;
+            }
+
+            m_elements.push_back(std::move(value));
+
+            skip_whitespace();
+            if (consume(']'))
+            {
+                return true;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+        }
+    }
+
+    bool json_reader::read_map(value_map& map, size_t depth)
+    {
+        bool end;
+        if (!read_object_start(end))
+        {
+            return false;
+        }
+
+        if (m_members.capacity() == 0)
+        {
+            // enough for most messages without growing
+            m_members.reserve(16);
+        }
+
+        const auto first = m_members.size();
+        std::string name;
+        while (!end)
+        {
+            signalr::value value;
+            if (!read_member_name(name) || !read_value(value, depth + 1))
+            {
+                return false;
+            }
+
+            m_members.emplace_back(std::move(name), std::move(value));
+            if (!read_member_separator(end))
+            {
+                return false;
+            }
+        }
+
+        const auto count = m_members.size() - first;
+        map = value_map(std::make_move_iterator(m_members.begin() + first), std::make_move_iterator(m_members.end()));
+        m_members.erase(m_members.begin() + first, m_members.end());
+
+        // duplicate keys are an error for jsoncpp in strict mode
+        return map.size() == count;
+    }
+
+    bool json_reader::read_string(std::string& str)
+    {
+        if (!consume('"'))
+        {
+            return false;
+        }
+
+        str.clear();
+        // characters are copied in runs between escape sequences, a string without any is copied in one go
+        auto run = m_current;
+        while (m_current != m_end)
+        {
+            auto c = static_cast<unsigned char>(*m_current);
+            if (c == '"')
+            {
+                str.append(run, m_current);
+                ++m_current;
+                return true;
+            }
+
+            if (c < 0x20)
+            {
+                return false;
+            }
+
+            if (c == '\\')
+            {
+                str.append(run, m_current);
+                ++m_current;
+                if (!read_escape(str))
+                {
+                    return false;
+                }
+                run = m_current;
+            }
+            else
+            {
+                ++m_current;
+            }
+        }
+
+        return false;
+    }
+
+    bool json_reader::read_escape(std::string& str)
+    {
+        if (m_current == m_end)
+        {
+            return false;
+        }
+
+        switch (*m_current++)
+        {
+        case '"':
+            str.push_back('"');
+            return true;
+        case '\\':
+            str.push_back('\\');
+            return true;
+        case '/':
+            str.push_back('/');
+            return true;
+        case 'b':
+            str.push_back('\b');
+            return true;
+        case 'f':
+            str.push_back('\f');
+            return true;
+        case 'n':
+            str.push_back('\n');
+            return true;
+        case 'r':
+            str.push_back('\r');
+            return true;
+        case 't':
+            str.push_back('\t');
+            return true;
+        case 'u':
+        {
+            uint32_t code_point;
+            if (!read_code_unit(code_point) || (code_point >= 0xDC00 && code_point <= 0xDFFF))
+            {
+                return false;
+            }
+
+            if (code_point >= 0xD800 && code_point <= 0xDBFF)
+            {
+                // characters outside of the BMP are escaped as a surrogate pair
+                uint32_t low_surrogate;
+                if (!consume('\\') || !consume('u') || !read_code_unit(low_surrogate) ||
+                    low_surrogate < 0xDC00 || low_surrogate > 0xDFFF)
+                {
+                    return false;
+                }
+
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+            }
+
+            append_utf8(str, code_point);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    bool json_reader::read_code_unit(uint32_t& code_unit)
+    {
+        if (m_end - m_current < 4)
+        {
+            return false;
+        }
+
+        code_unit = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto c = *m_current++;
+            code_unit <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                code_unit += static_cast<uint32_t>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                code_unit += static_cast<uint32_t>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                code_unit += static_cast<uint32_t>(c - 'A' + 10);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Integers that fit in 64 bits are read exactly, as a value_type::int64 or as a value_type::uint64 when they are only in
+    // the range of a uint64_t. Returns false without consuming anything for other numbers, which read_number reads as a
+    // double.
+    bool json_reader::read_integer(signalr::value& value)
+    {
+        auto current = m_current;
+        auto negative = current != m_end && *current == '-';
+        if (negative)
+        {
+            ++current;
+        }
+
+        // leading zeros are left for read_number to reject
+        if (current == m_end || !is_digit(*current) || (*current == '0' && current + 1 != m_end && is_digit(current[1])))
+        {
+            return false;
+        }
+
+        // 19 digits always fit, a 20th only if the number doesn't pass UINT64_MAX
+        uint64_t magnitude = 0;
+        auto digits_end = m_end - current > max_significant_digits ? current + max_significant_digits : m_end;
+        for (; current != digits_end && is_digit(*current); ++current)
+        {
+            magnitude = magnitude * 10 + static_cast<uint64_t>(*current - '0');
+        }
+        if (current != m_end && is_digit(*current))
+        {
+            auto digit = static_cast<uint64_t>(*current - '0');
+            if (magnitude > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+            ++current;
+        }
+
+        if (current != m_end && (is_digit(*current) || *current == '.' || *current == 'e' || *current == 'E'))
+        {
+            return false;
+        }
+
+        if (!negative)
+        {
+            value = magnitude <= static_cast<uint64_t>(INT64_MAX) ? signalr::value(static_cast<int64_t>(magnitude)) : signalr::value(magnitude);
+        }
+        else if (magnitude <= static_cast<uint64_t>(INT64_MAX))
+        {
+            // jsoncpp reads "-0" as the integer 0 as well
+            value = signalr::value(-static_cast<int64_t>(magnitude));
+        }
+        else if (magnitude == static_cast<uint64_t>(INT64_MAX) + 1)
+        {
+            value = signalr::value(INT64_MIN);
+        }
+        else
+        {
+            return false;
+        }
+
+        m_current = current;
+        return true;
+    }
+
+    // Numbers are rounded to the nearest double like jsoncpp's asDouble() does. Numbers with up to 19 significant digits
+    // and a small exponent are computed directly, the rest go through the same stream extraction jsoncpp uses.
+    bool json_reader::read_number(double& number)
+    {
+        skip_whitespace();
+        auto start = m_current;
+        auto negative = consume('-');
+        if (m_current == m_end || !is_digit(*m_current))
+        {
+            return false;
+        }
+
+        uint64_t mantissa = 0;
+        int significant_digits = 0;
+        int exponent = 0;
+        bool is_integer = true;
+        bool truncated = false;
+
+        if (*m_current == '0')
+        {
+            ++m_current;
+            if (m_current != m_end && is_digit(*m_current))
+            {
+                // leading zeros aren't valid JSON
+                return false;
+            }
+        }
+        else
+        {
+            for (; m_current != m_end && is_digit(*m_current); ++m_current)
+            {
+                if (significant_digits < max_significant_digits)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*m_current - '0');
+                    ++significant_digits;
+                }
+                else
+                {
+                    truncated = true;
+                }
+            }
+        }
+
+        if (consume('.'))
+        {
+            is_integer = false;
+            if (m_current == m_end || !is_digit(*m_current))
+            {
+                return false;
+            }
+
+            for (; m_current != m_end && is_digit(*m_current); ++m_current)
+            {
+                if (mantissa == 0 && *m_current == '0')
+                {
+                    --exponent;
+                }
+                else if (significant_digits < max_significant_digits)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*m_current - '0');
+                    ++significant_digits;
+                    --exponent;
+                }
+                else
+                {
+                    truncated = true;
+                }
+            }
+        }
+
+        if (m_current != m_end && (*m_current == 'e' || *m_current == 'E'))
+        {
+            ++m_current;
+            is_integer = false;
+            auto negative_exponent = consume('-');
+            if (!negative_exponent)
+            {
+                consume('+');
+            }
+            if (m_current == m_end || !is_digit(*m_current))
+            {
+                return false;
+            }
+
+            int explicit_exponent = 0;
+            for (; m_current != m_end && is_digit(*m_current); ++m_current)
+            {
+                // anything this large under- or overflows either way, stop before the int does
+                if (explicit_exponent < 100000)
+                {
+                    explicit_exponent = explicit_exponent * 10 + (*m_current - '0');
+                }
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+
+        if (!truncated)
+        {
+            if (is_integer)
+            {
+                // jsoncpp reads "-0" as the integer 0, which converts to a positive zero
+                number = negative && mantissa != 0 ? -static_cast<double>(mantissa) : static_cast<double>(mantissa);
+                return true;
+            }
+
+            if (mantissa == 0)
+            {
+                number = negative ? -0.0 : 0.0;
+                return true;
+            }
+
+            if (mantissa <= max_exact_mantissa && exponent >= -max_exact_power_of_ten && exponent <= max_exact_power_of_ten)
+            {
+                number = static_cast<double>(mantissa);
+                number = exponent < 0 ? number / exact_powers_of_ten[-exponent] : number * exact_powers_of_ten[exponent];
+                if (negative)
+                {
+                    number = -number;
+                }
+                return true;
+            }
+        }
+
+        std::istringstream stream(std::string(start, m_current));
+        return static_cast<bool>(stream >> number);
+    }
+
+    bool json_reader::read_literal(const char* literal, size_t length)
+    {
+        if (static_cast<size_t>(m_end - m_current) < length || std::char_traits<char>::compare(m_current, literal, length) != 0)
+        {
+            return false;
+        }
+
+        m_current += length;
+        return true;
+    }
+
+    bool json_reader::consume(char c)
+    {
+        if (m_current == m_end || *m_current != c)
+        {
+            return false;
+        }
+
+        ++m_current;
+        return true;
+    }
+
+    void json_reader::skip_whitespace()
+    {
+        while (m_current != m_end && (*m_current == ' ' || *m_current == '\t' || *m_current == '\n' || *m_current == '\r'))
+        {
+            ++m_current;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/signalr_value.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // Reads JSON text straight into signalr::value's in a single pass, without building a Json::Value tree first. It
+    // accepts a subset of what the jsoncpp reader accepts in strict mode and produces the same values for it. Every read
+    // function returns false on input it doesn't handle (malformed JSON, but also lone surrogates, duplicate keys, ...)
+    // and the position is unspecified afterwards, callers are expected to fall back to jsoncpp which reports the error.
+    class json_reader
+    {
+    public:
+        json_reader(const char* begin, size_t length);
+
+        json_reader(const json_reader&) = delete;
+        json_reader& operator=(const json_reader&) = delete;
+
+        // consumes the '{' opening an object, end is set if the object has no members
+        bool read_object_start(bool& end);
+        // consumes a member name and the ':' that follows it
+        bool read_member_name(std::string& name);
+        // consumes the ',' between two members or the '}' closing the object, end is set for the latter
+        bool read_member_separator(bool& end);
+
+        bool read_value(signalr::value& value);
+        bool read_string(std::string& str);
+        bool read_number(double& number);
+        bool read_array(std::vector<signalr::value>& array);
+
+        // true if nothing but whitespace is left
+        bool at_end();
+
+    private:
+        const char* m_current;
+        const char* m_end;
+        // the members of the objects and the elements of the arrays being read, nested ones are read on top of their
+        // parents' so each object and array only allocates once it is complete and knows its size
+        std::vector<std::pair<std::string, signalr::value>, value_allocator<std::pair<std::string, signalr::value>>> m_members;
+        std::vector<signalr::value, value_allocator<signalr::value>> m_elements;
+
+        bool read_value(signalr::value& value, size_t depth);
+        // reads a number without a fraction or exponent that fits in an int64_t or a uint64_t, anything else is left for
+        // read_number
+        bool read_integer(signalr::value& value);
+        // reads the elements onto m_elements
+        bool read_elements(size_t depth);
+        bool read_map(value_map& map, size_t depth);
+        bool read_escape(std::string& str);
+        bool read_code_unit(uint32_t& code_unit);
+        bool read_literal(const char* literal, size_t length);
+        bool consume(char c);
+        void skip_whitespace();
+    };
+}
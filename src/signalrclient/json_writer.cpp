@@ -0,0 +1,364 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "json_writer.h"
+#include "json_helpers.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+
+namespace signalr
+{
+    namespace
+    {
+        const char hex_digits[] = "0123456789abcdef";
+
+        // 17 significant digits always read back as the same double, most doubles that came from decimal text need
+        // far fewer and 15 is the most that any text with that many digits is guaranteed to survive the round trip with
+        const int min_round_trip_precision = 15;
+        const int max_round_trip_precision = 17;
+
+        // the first double past INT64_MAX, as 2 * two_to_the_63 is the first one past UINT64_MAX
+        const double two_to_the_63 = 9223372036854775808.0;
+
+        void append_integer(std::string& output, uint64_t number, bool negative)
+        {
+            char digits[20];
+            size_t length = 0;
+            do
+            {
+                digits[length++] = static_cast<char>('0' + number % 10);
+                number /= 10;
+            } while (number != 0);
+
+            if (negative)
+            {
+                output.push_back('-');
+            }
+            while (length != 0)
+            {
+                output.push_back(digits[--length]);
+            }
+        }
+
+        // decodes one character the way jsoncpp does before escaping it, advances past all but the last byte of it
+        unsigned int read_code_point(const char*& current, const char* end)
+        {
+            const unsigned int replacement_character = 0xFFFD;
+            auto first_byte = static_cast<unsigned char>(*current);
+
+            if (first_byte < 0xE0)
+            {
+                if (end - current < 2)
+                {
+                    return replacement_character;
+                }
+
+                unsigned int code_point = ((first_byte & 0x1Fu) << 6) | (static_cast<unsigned char>(current[1]) & 0x3Fu);
+                current += 1;
+                // overlong encodings are invalid
+                return code_point < 0x80 ? replacement_character : code_point;
+            }
+
+            if (first_byte < 0xF0)
+            {
+                if (end - current < 3)
+                {
+                    return replacement_character;
+                }
+
+                unsigned int code_point = ((first_byte & 0x0Fu) << 12) | ((static_cast<unsigned char>(current[1]) & 0x3Fu) << 6) |
+                    (static_cast<unsigned char>(current[2]) & 0x3Fu);
+                current += 2;
+                // surrogates aren't characters and overlong encodings are invalid
+                return (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point < 0x800 ? replacement_character : code_point;
+            }
+
+            if (first_byte < 0xF8)
+            {
+                if (end - current < 4)
+                {
+                    return replacement_character;
+                }
+
+                unsigned int code_point = ((first_byte & 0x07u) << 18) | ((static_cast<unsigned char>(current[1]) & 0x3Fu) << 12) |
+                    ((static_cast<unsigned char>(current[2]) & 0x3Fu) << 6) | (static_cast<unsigned char>(current[3]) & 0x3Fu);
+                current += 3;
+                return code_point < 0x10000 ? replacement_character : code_point;
+            }
+
+            return replacement_character;
+        }
+    }
+
+    json_writer::json_writer(std::string& output)
+        : m_output(output), m_first_member(true)
+    { }
+
+    void json_writer::write_object_start()
+    {
+        m_output.push_back('{');
+        m_first_member = true;
+    }
+
+    void json_writer::write_member_name(const char* name)
+    {
+        if (!m_first_member)
+        {
+            m_output.push_back(',');
+        }
+        m_first_member = false;
+
+        // names are protocol field names which never need escaping
+        m_output.push_back('"');
+        m_output.append(name);
+        m_output.append("\":", 2);
+    }
+
+    void json_writer::write_object_end()
+    {
+        m_output.push_back('}');
+    }
+
+    void json_writer::write_value(const signalr::value& value)
+    {
+        switch (value.type())
+        {
+        case signalr::value_type::boolean:
+            value.as_bool() ? m_output.append("true", 4) : m_output.append("false", 5);
+            break;
+        case signalr::value_type::float64:
+            write_number(value.as_double());
+            break;
+        case signalr::value_type::int64:
+            write_int64(value.as_int64());
+            break;
+        case signalr::value_type::uint64:
+            write_uint64(value.as_uint64());
+            break;
+        case signalr::value_type::string:
+            write_string(value.as_string());
+            break;
+        case signalr::value_type::array:
+            write_array(value.as_value_array());
+            break;
+        case signalr::value_type::map:
+        {
+            // std::map keeps the keys in the same order jsoncpp wrote them in
+            m_output.push_back('{');
+            bool first = true;
+            for (auto& member : value.as_value_map())
+            {
+                if (!first)
+                {
+                    m_output.push_back(',');
+                }
+                first = false;
+                write_string(member.first);
+                m_output.push_back(':');
+                write_value(member.second);
+            }
+            m_output.push_back('}');
+            break;
+        }
+        case signalr::value_type::binary:
+            write_string(base64Encode(value.as_binary()));
+            break;
+        case signalr::value_type::null:
+        default:
+            m_output.append("null", 4);
+            break;
+        }
+    }
+
+    void json_writer::write_array(const std::vector<signalr::value>& array)
+    {
+        write_values(array);
+    }
+
+    void json_writer::write_array(const value_array& array)
+    {
+        write_values(array);
+    }
+
+    template <typename Array>
+    void json_writer::write_values(const Array& array)
+    {
+        m_output.push_back('[');
+        bool first = true;
+        for (auto& element : array)
+        {
+            if (!first)
+            {
+                m_output.push_back(',');
+            }
+            first = false;
+            write_value(element);
+        }
+        m_output.push_back(']');
+    }
+
+    void json_writer::write_array(const std::vector<std::string>& array)
+    {
+        m_output.push_back('[');
+        bool first = true;
+        for (auto& element : array)
+        {
+            if (!first)
+            {
+                m_output.push_back(',');
+            }
+            first = false;
+            write_string(element);
+        }
+        m_output.push_back(']');
+    }
+
+    // Characters are escaped like jsoncpp does by default: control characters and anything that isn't ASCII are
+    // written as \u escapes, so the output is always ASCII whatever the encoding of the string is.
+    void json_writer::write_string(const std::string& str)
+    {
+        m_output.push_back('"');
+
+        auto current = str.data();
+        auto end = current + str.size();
+        // characters that don't need escaping are copied in runs
+        auto run = current;
+        for (; current != end; ++current)
+        {
+            auto c = static_cast<unsigned char>(*current);
+            if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\')
+            {
+                continue;
+            }
+
+            m_output.append(run, current);
+            switch (c)
+            {
+            case '"':
+                m_output.append("\\\"", 2);
+                break;
+            case '\\':
+                m_output.append("\\\\", 2);
+                break;
+            case '\b':
+                m_output.append("\\b", 2);
+                break;
+            case '\f':
+                m_output.append("\\f", 2);
+                break;
+            case '\n':
+                m_output.append("\\n", 2);
+                break;
+            case '\r':
+                m_output.append("\\r", 2);
+                break;
+            case '\t':
+                m_output.append("\\t", 2);
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    write_code_unit(c);
+                }
+                else
+                {
+                    auto code_point = read_code_point(current, end);
+                    if (code_point < 0x10000)
+                    {
+                        write_code_unit(code_point);
+                    }
+                    else
+                    {
+                        code_point -= 0x10000;
+                        write_code_unit(0xD800 + ((code_point >> 10) & 0x3FF));
+                        write_code_unit(0xDC00 + (code_point & 0x3FF));
+                    }
+                }
+                break;
+            }
+            run = current + 1;
+        }
+
+        m_output.append(run, end);
+        m_output.push_back('"');
+    }
+
+    void json_writer::write_number(double number)
+    {
+        // Workaround for 1.0 being output as 1.0 instead of 1
+        // because the server expects certain values to be 1 instead of 1.0 (like integer arguments)
+        if (number >= -two_to_the_63 && number < two_to_the_63)
+        {
+            // in this range the conversion is exact for integral doubles and truncates the others
+            auto integer = static_cast<int64_t>(number);
+            if (static_cast<double>(integer) == number)
+            {
+                write_int64(integer);
+                return;
+            }
+        }
+        // every double this large is integral
+        else if (number >= two_to_the_63 && number < 2 * two_to_the_63)
+        {
+            append_integer(m_output, static_cast<uint64_t>(number), false);
+            return;
+        }
+
+        if (std::isnan(number))
+        {
+            m_output.append("null", 4);
+            return;
+        }
+
+        if (std::isinf(number))
+        {
+            number < 0 ? m_output.append("-1e+9999", 8) : m_output.append("1e+9999", 7);
+            return;
+        }
+
+        char buffer[32];
+        int length = 0;
+        for (int precision = min_round_trip_precision; precision <= max_round_trip_precision; ++precision)
+        {
+            length = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, number);
+            if (std::strtod(buffer, nullptr) == number)
+            {
+                break;
+            }
+        }
+
+        // snprintf uses the decimal separator of the current locale
+        for (int i = 0; i < length; ++i)
+        {
+            if (buffer[i] == ',')
+            {
+                buffer[i] = '.';
+            }
+        }
+
+        m_output.append(buffer, static_cast<size_t>(length));
+    }
+
+    void json_writer::write_int64(int64_t number)
+    {
+        // negated as unsigned so INT64_MIN doesn't overflow
+        append_integer(m_output, number < 0 ? 0 - static_cast<uint64_t>(number) : static_cast<uint64_t>(number), number < 0);
+    }
+
+    void json_writer::write_uint64(uint64_t number)
+    {
+        append_integer(m_output, number, false);
+    }
+
+    void json_writer::write_code_unit(unsigned int code_unit)
+    {
+        char escape[6] = { '\\', 'u',
+            hex_digits[(code_unit >> 12) & 0xF], hex_digits[(code_unit >> 8) & 0xF],
+            hex_digits[(code_unit >> 4) & 0xF], hex_digits[code_unit & 0xF] };
+        m_output.append(escape, sizeof(escape));
+    }
+}
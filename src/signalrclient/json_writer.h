@@ -0,0 +1,50 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/signalr_value.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // Writes signalr::value's as JSON straight to a string without building a Json::Value first. Output is appended to
+    // whatever the string already holds so a whole message is written into one buffer, which can be reused.
+    //
+    // The output is what jsoncpp wrote for the same value with the settings from getJsonWriter(), except for doubles
+    // that aren't integral: they are written with the fewest digits that read back as the same double instead of
+    // always using 17 significant digits.
+    class json_writer
+    {
+    public:
+        explicit json_writer(std::string& output);
+
+        json_writer(const json_writer&) = delete;
+        json_writer& operator=(const json_writer&) = delete;
+
+        // members are written one object at a time, values that are objects themselves are written with write_value
+        void write_object_start();
+        void write_member_name(const char* name);
+        void write_object_end();
+
+        void write_value(const signalr::value& value);
+        void write_array(const std::vector<signalr::value>& array);
+        void write_array(const value_array& array);
+        void write_array(const std::vector<std::string>& array);
+        void write_string(const std::string& str);
+        void write_number(double number);
+        void write_int64(int64_t number);
+        void write_uint64(uint64_t number);
+
+    private:
+        std::string& m_output;
+        bool m_first_member;
+
+        void write_code_unit(unsigned int code_unit);
+        template <typename Array>
+        void write_values(const Array& array);
+    };
+}
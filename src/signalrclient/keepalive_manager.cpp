@@ -0,0 +1,287 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include <assert.h>
+#include <algorithm>
+#include "keepalive_manager.h"
+
+namespace signalr
+{
+    namespace
+    {
+        // 512 slots of 100ms cover 51.2 seconds, enough for the default keepalive interval and server timeout to be found
+        // on the first turn of the wheel
+        constexpr size_t slot_count = 512;
+    }
+
+    constexpr std::chrono::milliseconds keepalive_manager::resolution;
+
+    std::shared_ptr<keepalive_manager> keepalive_manager::create(std::shared_ptr<scheduler> scheduler)
+    {
+        return std::shared_ptr<keepalive_manager>(new keepalive_manager(std::move(scheduler)));
+    }
+
+    std::shared_ptr<keepalive_manager> keepalive_manager::for_scheduler(const std::shared_ptr<scheduler>& scheduler)
+    {
+        // managers are only weakly referenced so they go away with the last connection using them, a manager holds on to
+        // its scheduler so the address can't be reused by another scheduler while the entry is alive
+        static std::mutex managers_lock;
+        static std::unordered_map<const signalr::scheduler*, std::weak_ptr<keepalive_manager>> managers;
+
+        std::lock_guard<std::mutex> lock(managers_lock);
+        for (auto it = managers.begin(); it != managers.end();)
+        {
+            if (it->second.expired())
+            {
+                it = managers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        auto& entry = managers[scheduler.get()];
+        auto manager = entry.lock();
+        if (!manager)
+        {
+            manager = create(scheduler);
+            entry = manager;
+        }
+
+        return manager;
+    }
+
+    keepalive_manager::keepalive_manager(std::shared_ptr<scheduler> scheduler)
+        : m_scheduler(std::move(scheduler)), m_timer(timer::create(m_scheduler)), m_origin(clock_now(*m_scheduler)), m_slots(slot_count), m_next_id(0),
+        m_current_tick(0), m_armed_deadline(clock::time_point::max())
+    { }
+
+    uint64_t keepalive_manager::add(clock::time_point deadline, check_callback check)
+    {
+        assert(check);
+
+        auto entry = std::make_shared<registration>();
+        entry->check = std::move(check);
+        entry->removed = false;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        entry->id = ++m_next_id;
+        m_registrations.insert({ entry->id, entry });
+        insert(entry, deadline);
+
+        if (entry->deadline < m_armed_deadline)
+        {
+            arm();
+        }
+
+        return entry->id;
+    }
+
+    void keepalive_manager::remove(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto found = m_registrations.find(id);
+        if (found == m_registrations.end())
+        {
+            return;
+        }
+
+        auto entry = found->second;
+        m_registrations.erase(found);
+        entry->removed = true;
+        // a registration that is being checked isn't in a slot
+        erase_from_slot(entry);
+        // the timer is left armed, if it finds nothing to do it re-arms for the next registration or stops
+    }
+
+    size_t keepalive_manager::size()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_registrations.size();
+    }
+
+    uint64_t keepalive_manager::tick_for(clock::time_point deadline) const
+    {
+        if (deadline <= m_origin)
+        {
+            return 0;
+        }
+
+        // rounds up so a registration is never checked before its deadline
+        auto elapsed = deadline - m_origin;
+        auto tick = static_cast<uint64_t>(elapsed / resolution);
+        if (resolution * tick < elapsed)
+        {
+            ++tick;
+        }
+        return tick;
+    }
+
+    // must be called with m_lock held
+    void keepalive_manager::insert(const std::shared_ptr<registration>& entry, clock::time_point deadline)
+    {
+        // ticks that have already been processed won't be looked at again
+        entry->deadline = deadline;
+        entry->tick = std::max(tick_for(deadline), m_current_tick + 1);
+        m_slots[entry->tick % slot_count].push_back(entry);
+    }
+
+    // must be called with m_lock held
+    void keepalive_manager::erase_from_slot(const std::shared_ptr<registration>& entry)
+    {
+        auto& slot = m_slots[entry->tick % slot_count];
+        auto found = std::find(slot.begin(), slot.end(), entry);
+        if (found != slot.end())
+        {
+            *found = std::move(slot.back());
+            slot.pop_back();
+        }
+    }
+
+    // must be called with m_lock held, the timer is armed under the lock so concurrent calls can't leave it armed for a later
+    // slot than the earliest one that is occupied
+    void keepalive_manager::arm()
+    {
+        auto next_deadline = clock::time_point::max();
+        for (uint64_t tick = m_current_tick + 1; tick <= m_current_tick + slot_count; ++tick)
+        {
+            for (auto& entry : m_slots[tick % slot_count])
+            {
+                // registrations for later turns of the wheel share the slot
+                if (entry->tick == tick)
+                {
+                    next_deadline = std::min(next_deadline, entry->deadline);
+                }
+            }
+
+            if (next_deadline != clock::time_point::max())
+            {
+                break;
+            }
+        }
+
+        if (next_deadline == clock::time_point::max() && !m_registrations.empty())
+        {
+            // every registration is more than a turn of the wheel away, wake up at the end of this turn to look again
+            next_deadline = m_origin + resolution * (m_current_tick + slot_count);
+        }
+
+        if (next_deadline == m_armed_deadline)
+        {
+            return;
+        }
+
+        m_armed_deadline = next_deadline;
+        if (next_deadline == clock::time_point::max())
+        {
+            m_timer->cancel();
+            return;
+        }
+
+        std::weak_ptr<keepalive_manager> weak_manager = shared_from_this();
+        m_timer->schedule_at(next_deadline, [weak_manager]()
+            {
+                auto manager = weak_manager.lock();
+                if (manager)
+                {
+                    manager->on_tick();
+                }
+            });
+    }
+
+    void keepalive_manager::on_tick()
+    {
+        auto now = clock_now(*m_scheduler);
+        std::vector<std::shared_ptr<registration>> due;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_armed_deadline = clock::time_point::max();
+
+            auto now_tick = static_cast<uint64_t>((now - m_origin) / resolution);
+            if (now_tick > m_current_tick)
+            {
+                // if the timer was late by more than a turn of the wheel every slot is visited once
+                auto count = std::min<uint64_t>(now_tick - m_current_tick, slot_count);
+                for (uint64_t tick = m_current_tick + 1; tick <= m_current_tick + count; ++tick)
+                {
+                    auto& slot = m_slots[tick % slot_count];
+                    for (size_t i = 0; i < slot.size();)
+                    {
+                        if (slot[i]->tick <= now_tick)
+                        {
+                            due.push_back(std::move(slot[i]));
+                            slot[i] = std::move(slot.back());
+                            slot.pop_back();
+                        }
+                        else
+                        {
+                            // waiting for a later turn of the wheel
+                            ++i;
+                        }
+                    }
+                }
+
+                m_current_tick = now_tick;
+            }
+
+            // the slot now falls into has been reached only partly, the registrations in it whose deadline has passed are due
+            auto& partial = m_slots[(m_current_tick + 1) % slot_count];
+            for (size_t i = 0; i < partial.size();)
+            {
+                if (partial[i]->tick == m_current_tick + 1 && partial[i]->deadline <= now)
+                {
+                    due.push_back(std::move(partial[i]));
+                    partial[i] = std::move(partial.back());
+                    partial.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        } // unlock
+
+        // checks run outside of the lock, they are free to add or remove registrations
+        std::vector<clock::time_point> next_deadlines;
+        next_deadlines.reserve(due.size());
+        for (auto& entry : due)
+        {
+            auto next = clock::time_point::max();
+            try
+            {
+                next = entry->check(now);
+            }
+            catch (...)
+            {
+                // checks aren't expected to throw, drop the registration rather than keep calling it
+                assert(false);
+            }
+            next_deadlines.push_back(next);
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (size_t i = 0; i < due.size(); ++i)
+        {
+            auto& entry = due[i];
+            if (entry->removed)
+            {
+                continue;
+            }
+
+            if (next_deadlines[i] == clock::time_point::max())
+            {
+                entry->removed = true;
+                m_registrations.erase(entry->id);
+                continue;
+            }
+
+            insert(entry, next_deadlines[i]);
+        }
+
+        arm();
+    }
+}
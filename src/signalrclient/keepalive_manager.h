@@ -0,0 +1,95 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include "timer.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace signalr
+{
+    // Keeps the keepalive and server timeout deadlines of every connection on a scheduler in one timing wheel driven by a
+    // single timer. The timer is armed for the earliest deadline in the first slot that holds a registration, so
+    // registrations are checked when they are due and only the registrations in that slot are looked at to arm it.
+    // Registrations due at the same time share a wakeup, and a registration is only looked at once its deadline is
+    // reached, so connections that aren't due cost nothing. Deadlines that move later, like the ping
+    // deadline being pushed back by every send, don't need to touch the wheel: the check callback reports the new deadline
+    // when the old one is reached and the registration is moved to the matching slot.
+    //
+    // Note:
+    // Factory methods and private constructors prevent from using this class incorrectly. Because this class
+    // derives from `std::enable_shared_from_this` the instance has to be owned by a `std::shared_ptr` whenever
+    // a member method calls `std::shared_from_this()` otherwise the behavior is undefined.
+    class keepalive_manager : public std::enable_shared_from_this<keepalive_manager>
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        // invoked on the scheduler once the registration's deadline has been reached, returns the next deadline or
+        // clock::time_point::max() to drop the registration. Deadlines and now are in the scheduler's clock.
+        typedef std::function<clock::time_point(clock::time_point now)> check_callback;
+
+        // the width of a slot of the wheel
+        static constexpr std::chrono::milliseconds resolution = std::chrono::milliseconds(100);
+
+        static std::shared_ptr<keepalive_manager> create(std::shared_ptr<scheduler> scheduler);
+
+        // connections using the same scheduler share one manager, and with it one timer
+        static std::shared_ptr<keepalive_manager> for_scheduler(const std::shared_ptr<scheduler>& scheduler);
+
+        keepalive_manager(const keepalive_manager&) = delete;
+        keepalive_manager& operator=(const keepalive_manager&) = delete;
+
+        // returns an id that can be used to remove the registration, never 0
+        uint64_t add(clock::time_point deadline, check_callback check);
+        // a check that is already running finishes but the registration isn't put back on the wheel
+        void remove(uint64_t id);
+
+        size_t size();
+
+    private:
+        explicit keepalive_manager(std::shared_ptr<scheduler> scheduler);
+
+#ifdef _WIN32
+#pragma warning (push)
+#pragma warning (disable: 4625 5026 4626 5027)
+#endif
+        struct registration
+        {
+            uint64_t id;
+            check_callback check;
+            clock::time_point deadline;
+            // the wheel tick the registration is waiting for, it may be several turns of the wheel away
+            uint64_t tick;
+            bool removed;
+        };
+#ifdef _WIN32
+#pragma warning (pop)
+#endif
+
+        std::shared_ptr<scheduler> m_scheduler;
+        std::shared_ptr<timer> m_timer;
+        std::mutex m_lock;
+        clock::time_point m_origin;
+        std::vector<std::vector<std::shared_ptr<registration>>> m_slots;
+        std::unordered_map<uint64_t, std::shared_ptr<registration>> m_registrations;
+        uint64_t m_next_id;
+        // every tick up to and including this one has been processed
+        uint64_t m_current_tick;
+        // the deadline the timer is armed for, clock::time_point::max() when it isn't armed
+        clock::time_point m_armed_deadline;
+
+        uint64_t tick_for(clock::time_point deadline) const;
+        void insert(const std::shared_ptr<registration>& entry, clock::time_point deadline);
+        void erase_from_slot(const std::shared_ptr<registration>& entry);
+        void arm();
+        void on_tick();
+    };
+}
@@ -0,0 +1,51 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "latency_recorder.h"
+
+namespace signalr
+{
+    latency_recorder::latency_recorder()
+        : m_count(0), m_total_us(0), m_max_us(0)
+    {
+        for (auto& bucket : m_buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void latency_recorder::record(std::chrono::steady_clock::duration latency) noexcept
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        auto value = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+        // the bucket is the number of significant bits, e.g. 5us (0b101) goes to bucket 3 which covers [4, 8)
+        size_t bucket = 0;
+        for (auto remaining = value; remaining != 0 && bucket < latency_histogram::bucket_count - 1; remaining >>= 1)
+        {
+            ++bucket;
+        }
+
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total_us.fetch_add(value, std::memory_order_relaxed);
+
+        auto max = m_max_us.load(std::memory_order_relaxed);
+        while (value > max && !m_max_us.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void latency_recorder::snapshot(latency_histogram& histogram) const
+    {
+        for (size_t i = 0; i < latency_histogram::bucket_count; ++i)
+        {
+            histogram.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        }
+        histogram.count = m_count.load(std::memory_order_relaxed);
+        histogram.total = std::chrono::microseconds(m_total_us.load(std::memory_order_relaxed));
+        histogram.max = std::chrono::microseconds(m_max_us.load(std::memory_order_relaxed));
+    }
+}
@@ -0,0 +1,30 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/scheduler_metrics.h"
+#include <atomic>
+
+namespace signalr
+{
+    // Lock-free histogram behind latency_histogram, samples can be recorded from any number of threads while a snapshot is
+    // taken. A snapshot isn't a consistent cut across the counters, which is fine for monitoring.
+    class latency_recorder
+    {
+    public:
+        latency_recorder();
+        latency_recorder(const latency_recorder&) = delete;
+        latency_recorder& operator=(const latency_recorder&) = delete;
+
+        void record(std::chrono::steady_clock::duration latency) noexcept;
+        void snapshot(latency_histogram& histogram) const;
+
+    private:
+        std::atomic<uint64_t> m_buckets[latency_histogram::bucket_count];
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_total_us;
+        std::atomic<uint64_t> m_max_us;
+    };
+}
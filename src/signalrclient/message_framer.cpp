@@ -0,0 +1,133 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "message_framer.h"
+#include "json_helpers.h"
+#ifdef USE_MSGPACK
+#include "binary_message_parser.h"
+#endif
+
+namespace signalr
+{
+    message_framer::message_framer(signalr::transfer_format transfer_format)
+        : m_transfer_format(transfer_format), m_scanned(0)
+    { }
+
+    void message_framer::append(std::string&& frame)
+    {
+        if (m_buffer.empty())
+        {
+            m_buffer = std::move(frame);
+        }
+        else
+        {
+            m_buffer.append(frame);
+        }
+    }
+
+    bool message_framer::take_handshake(std::string& handshake)
+    {
+        auto pos = m_buffer.find(record_separator, m_scanned);
+        if (pos == std::string::npos)
+        {
+            m_scanned = m_buffer.size();
+            return false;
+        }
+
+        handshake = take_front(pos + 1);
+        m_scanned = 0;
+        return true;
+    }
+
+    std::string message_framer::take_messages()
+    {
+        if (m_transfer_format == signalr::transfer_format::text)
+        {
+            // only the bytes that arrived since the last time are searched, from the end since all the messages up to the
+            // last record separator are complete
+            for (auto end = m_buffer.size(); end > m_scanned; --end)
+            {
+                if (m_buffer[end - 1] == record_separator)
+                {
+                    auto messages = take_front(end);
+                    // the rest is what came after the last separator
+                    m_scanned = m_buffer.size();
+                    return messages;
+                }
+            }
+
+            m_scanned = m_buffer.size();
+            return std::string();
+        }
+
+#ifdef USE_MSGPACK
+        // still waiting for the rest of the first message
+        if (m_scanned != 0 && m_buffer.size() < m_scanned)
+        {
+            return std::string();
+        }
+
+        // only the length prefixes are read, from one to the next
+        auto data = reinterpret_cast<const unsigned char*>(m_buffer.data());
+        size_t complete_length = 0;
+        size_t incomplete_message_length = 0;
+        while (complete_length < m_buffer.size())
+        {
+            size_t length_prefix_length;
+            size_t length_of_message;
+            if (!binary_message_parser::try_parse_length_prefix(data + complete_length, m_buffer.size() - complete_length,
+                &length_prefix_length, &length_of_message))
+            {
+                break;
+            }
+
+            if (m_buffer.size() - complete_length < length_prefix_length + length_of_message)
+            {
+                incomplete_message_length = length_prefix_length + length_of_message;
+                break;
+            }
+
+            complete_length += length_prefix_length + length_of_message;
+        }
+
+        auto messages = take_front(complete_length);
+        m_scanned = incomplete_message_length;
+        return messages;
+#else
+        // only the MessagePack protocol uses the binary transfer format
+        return take_front(m_buffer.size());
+#endif
+    }
+
+    size_t message_framer::incomplete_length() const
+    {
+        return m_buffer.size();
+    }
+
+    void message_framer::reset()
+    {
+        m_buffer.clear();
+        m_scanned = 0;
+    }
+
+    std::string message_framer::take_front(size_t length)
+    {
+        std::string front;
+        if (length == m_buffer.size())
+        {
+            front.swap(m_buffer);
+        }
+        else if (length != 0)
+        {
+            // only the incomplete message at the end is copied
+            std::string rest(m_buffer, length);
+            m_buffer.resize(length);
+            front.swap(m_buffer);
+            m_buffer.swap(rest);
+        }
+
+        return front;
+    }
+}
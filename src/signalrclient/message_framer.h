@@ -0,0 +1,44 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/transfer_format.h"
+#include <string>
+
+namespace signalr
+{
+    // Splits what the server sends into complete messages however the transport split it into frames. A frame can hold
+    // any number of messages and end in the middle of one, the end of the message is kept until the frames with the
+    // rest of it arrive. Frames that end where a message ends, which is what servers normally send, aren't copied.
+    class message_framer
+    {
+    public:
+        explicit message_framer(signalr::transfer_format transfer_format);
+
+        void append(std::string&& frame);
+
+        // The handshake response comes first and is text whatever the transfer format is. Returns false until all of it
+        // arrived, then takes it out including its record separator.
+        bool take_handshake(std::string& handshake);
+
+        // takes out all the complete messages received, in the format the protocol parses, empty if there aren't any
+        std::string take_messages();
+
+        // the bytes received that aren't part of a complete message yet
+        size_t incomplete_length() const;
+
+        // forgets everything received, for when the connection starts again
+        void reset();
+
+    private:
+        signalr::transfer_format m_transfer_format;
+        std::string m_buffer;
+        // text: the start of the buffer that is known not to have a record separator
+        // binary: the length, with its prefix, of the message the buffer starts with, 0 if the prefix wasn't all received
+        size_t m_scanned;
+
+        std::string take_front(size_t length);
+    };
+}
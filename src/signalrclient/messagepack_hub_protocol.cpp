@@ -11,10 +11,92 @@
 #include <msgpack.hpp>
 #include "binary_message_parser.h"
 #include "binary_message_formatter.h"
-#include <cmath>
+#include <cassert>
 
 namespace signalr
 {
+    namespace
+    {
+        // the first double past INT64_MAX, as 2 * two_to_the_63 is the first one past UINT64_MAX
+        const double two_to_the_63 = 9223372036854775808.0;
+
+        // the messages outlive the objects decoded from them so nothing has to be copied out of them while decoding
+        bool reference_in_place(msgpack::type::object_type, size_t, void*)
+        {
+            return true;
+        }
+
+        // the bytes of the strings and binary data in a value, a lower bound of its packed size which is close to it for
+        // the values that are big enough for the size of the length prefix to matter
+        size_t bulk_size(const signalr::value& v)
+        {
+            switch (v.type())
+            {
+            case signalr::value_type::string:
+                return v.as_string().size();
+            case signalr::value_type::binary:
+                return v.as_binary().size();
+            case signalr::value_type::array:
+            {
+                size_t size = 0;
+                for (auto& val : v.as_value_array())
+                {
+                    size += bulk_size(val);
+                }
+                return size;
+            }
+            case signalr::value_type::map:
+            {
+                size_t size = 0;
+                for (auto& val : v.as_value_map())
+                {
+                    size += val.first.size() + bulk_size(val.second);
+                }
+                return size;
+            }
+            default:
+                return 0;
+            }
+        }
+
+        size_t bulk_size(const hub_message* hub_message)
+        {
+#pragma warning (push)
+#pragma warning (disable: 4061)
+            switch (hub_message->message_type)
+            {
+            case message_type::invocation:
+            case message_type::stream_invocation:
+            {
+                auto invocation = static_cast<invocation_message const*>(hub_message);
+                size_t size = invocation->invocation_id.size() + invocation->target.size();
+                for (auto& val : invocation->arguments)
+                {
+                    size += bulk_size(val);
+                }
+                for (auto& stream_id : invocation->stream_ids)
+                {
+                    size += stream_id.size();
+                }
+                return size;
+            }
+            case message_type::completion:
+            {
+                auto completion = static_cast<completion_message const*>(hub_message);
+                return completion->invocation_id.size() + completion->error.size() + bulk_size(completion->result);
+            }
+            case message_type::stream_item:
+            {
+                auto stream_item = static_cast<stream_item_message const*>(hub_message);
+                return stream_item->invocation_id.size() + bulk_size(stream_item->item);
+            }
+            default:
+                return 0;
+            }
+#pragma warning (pop)
+        }
+    }
+
     // replaces use of msgpack::sbuffer when packing so that we can write directly to the string instead of writing to another buffer and copying to a string later
     class string_wrapper
     {
@@ -38,29 +120,31 @@ namespace signalr
         case msgpack::type::object_type::FLOAT32:
             return signalr::value(v.via.f64);
         case msgpack::type::object_type::POSITIVE_INTEGER:
-            return signalr::value((double)v.via.u64);
+            // integers are int64 unless they don't fit, whichever way they were packed
+            return v.via.u64 <= static_cast<uint64_t>(INT64_MAX) ? signalr::value(static_cast<int64_t>(v.via.u64)) : signalr::value(v.via.u64);
         case msgpack::type::object_type::NEGATIVE_INTEGER:
-            return signalr::value((double)v.via.i64);
+            return signalr::value(v.via.i64);
         case msgpack::type::object_type::STR:
             return signalr::value(v.via.str.ptr, v.via.str.size);
         case msgpack::type::object_type::ARRAY:
         {
-            std::vector<signalr::value> vec;
+            value_vector<signalr::value> vec;
+            vec.reserve(v.via.array.size);
             for (size_t i = 0; i < v.via.array.size; ++i)
             {
                 vec.push_back(createValue(*(v.via.array.ptr + i)));
             }
-            return signalr::value(std::move(vec));
+            return signalr::value(value_array(std::move(vec)));
         }
         case msgpack::type::object_type::MAP:
         {
-            std::map<std::string, signalr::value> map;
+            value_vector<std::pair<std::string, signalr::value>> members;
+            members.reserve(v.via.map.size);
             for (size_t i = 0; i < v.via.map.size; ++i)
             {
-                auto key = (v.via.map.ptr + i)->key.as<std::string>();
-                map.insert({ key, createValue((v.via.map.ptr + i)->val) });
+                members.emplace_back((v.via.map.ptr + i)->key.as<std::string>(), createValue((v.via.map.ptr + i)->val));
             }
-            return signalr::value(std::move(map));
+            return signalr::value(value_map(std::move(members)));
         }
         case msgpack::type::object_type::BIN:
         {
@@ -94,45 +178,33 @@ namespace signalr
         case signalr::value_type::float64:
         {
             auto value = v.as_double();
-            double intPart;
             // Workaround for 1.0 being output as 1.0 instead of 1
-            // because the server expects certain values to be 1 instead of 1.0 (like protocol version)
-            if (std::modf(value, &intPart) == 0)
+            // because the server expects certain values to be 1 instead of 1.0 (like integer arguments)
+            if (value >= -two_to_the_63 && value < two_to_the_63)
             {
-                if (value < 0)
-                {
-                    if (value >= (double)INT64_MIN)
-                    {
-                        // Fits within int64_t
-                        packer.pack_int64(static_cast<int64_t>(intPart));
-                        return;
-                    }
-                    else
-                    {
-                        // Remain as double
-                        packer.pack_double(value);
-                        return;
-                    }
-                }
-                else
+                // in this range the conversion is exact for integral doubles and truncates the others
+                auto integer = static_cast<int64_t>(value);
+                if (static_cast<double>(integer) == value)
                 {
-                    if (value <= (double)UINT64_MAX)
-                    {
-                        // Fits within uint64_t
-                        packer.pack_uint64(static_cast<uint64_t>(intPart));
-                        return;
-                    }
-                    else
-                    {
-                        // Remain as double
-                        packer.pack_double(value);
-                        return;
-                    }
+                    packer.pack_int64(integer);
+                    return;
                 }
             }
-            packer.pack_double(v.as_double());
+            // every double this large is integral
+            else if (value >= two_to_the_63 && value < 2 * two_to_the_63)
+            {
+                packer.pack_uint64(static_cast<uint64_t>(value));
+                return;
+            }
+            packer.pack_double(value);
             return;
         }
+        case signalr::value_type::int64:
+            packer.pack_int64(v.as_int64());
+            return;
+        case signalr::value_type::uint64:
+            packer.pack_uint64(v.as_uint64());
+            return;
         case signalr::value_type::string:
         {
             auto length = v.as_string().length();
@@ -142,7 +214,7 @@ namespace signalr
         }
         case signalr::value_type::array:
         {
-            const auto& array = v.as_array();
+            const auto& array = v.as_value_array();
             packer.pack_array(static_cast<uint32_t>(array.size()));
             for (auto& val : array)
             {
@@ -152,7 +224,7 @@ namespace signalr
         }
         case signalr::value_type::map:
         {
-            const auto& obj = v.as_map();
+            const auto& obj = v.as_value_map();
             packer.pack_map(static_cast<uint32_t>(obj.size()));
             for (auto& val : obj)
             {
@@ -180,7 +252,16 @@ namespace signalr
 
     std::string signalr::messagepack_hub_protocol::write_message(const hub_message* hub_message) const
     {
+        // The length prefix goes in front of the message but depends on its length, so space is left for it based on
+        // the guessed length and filled in once the message is written, the guess is only wrong when the length is close
+        // to a multiple of a power of 128, in which case the message has to move.
+        auto bulk = bulk_size(hub_message);
+        auto expected_length = bulk + m_typical_overhead.load(std::memory_order_relaxed);
+        auto reserved_length = binary_message_formatter::length_prefix_length(expected_length);
+
         string_wrapper str;
+        str.str.reserve(reserved_length + expected_length);
+        str.str.resize(reserved_length);
         msgpack::packer<string_wrapper> packer(str);
 
 #pragma warning (push)
@@ -188,12 +269,13 @@ namespace signalr
         switch (hub_message->message_type)
         {
         case message_type::invocation:
+        case message_type::stream_invocation:
         {
             auto invocation = static_cast<invocation_message const*>(hub_message);
 
             packer.pack_array(6);
 
-            packer.pack_int(static_cast<int>(message_type::invocation));
+            packer.pack_int(static_cast<int>(invocation->message_type));
             // Headers
             packer.pack_map(0);
 
@@ -216,8 +298,12 @@ namespace signalr
                 pack_messagepack(val, packer);
             }
 
-            // StreamIds
-            packer.pack_array(0);
+            packer.pack_array(static_cast<uint32_t>(invocation->stream_ids.size()));
+            for (auto& stream_id : invocation->stream_ids)
+            {
+                packer.pack_str(static_cast<uint32_t>(stream_id.length()));
+                packer.pack_str_body(stream_id.data(), static_cast<uint32_t>(stream_id.length()));
+            }
 
             break;
         }
@@ -252,6 +338,40 @@ namespace signalr
 
             break;
         }
+        case message_type::stream_item:
+        {
+            auto stream_item = static_cast<stream_item_message const*>(hub_message);
+
+            packer.pack_array(4);
+
+            packer.pack_int(static_cast<int>(message_type::stream_item));
+
+            // Headers
+            packer.pack_map(0);
+
+            packer.pack_str(static_cast<uint32_t>(stream_item->invocation_id.length()));
+            packer.pack_str_body(stream_item->invocation_id.data(), static_cast<uint32_t>(stream_item->invocation_id.length()));
+
+            pack_messagepack(stream_item->item, packer);
+
+            break;
+        }
+        case message_type::cancel_invocation:
+        {
+            auto cancel_invocation = static_cast<cancel_invocation_message const*>(hub_message);
+
+            packer.pack_array(3);
+
+            packer.pack_int(static_cast<int>(message_type::cancel_invocation));
+
+            // Headers
+            packer.pack_map(0);
+
+            packer.pack_str(static_cast<uint32_t>(cancel_invocation->invocation_id.length()));
+            packer.pack_str_body(cancel_invocation->invocation_id.data(), static_cast<uint32_t>(cancel_invocation->invocation_id.length()));
+
+            break;
+        }
         case message_type::ping:
         {
             // If we need the ping this is how you get it
@@ -267,13 +387,19 @@ namespace signalr
         }
 #pragma warning (pop)
 
-        binary_message_formatter::write_length_prefix(str.str);
-        return str.str;
+        auto overhead = str.str.length() - reserved_length - bulk;
+        m_typical_overhead.store((m_typical_overhead.load(std::memory_order_relaxed) * 3 + overhead) / 4, std::memory_order_relaxed);
+
+        binary_message_formatter::write_length_prefix(str.str, reserved_length);
+        return std::move(str.str);
     }
 
     std::vector<std::unique_ptr<hub_message>> messagepack_hub_protocol::parse_messages(const std::string& message) const
     {
         std::vector<std::unique_ptr<hub_message>> vec;
+        // one per thread rather than one per message, the receive loop parses all the messages of a connection on
+        // whichever thread it runs on
+        static thread_local msgpack::zone zone;
 
         size_t length_prefix_length;
         size_t length_of_message;
@@ -287,19 +413,20 @@ namespace signalr
             remaining_message_length -= length_prefix_length;
             assert(remaining_message_length >= length_of_message);
 
-            msgpack::unpacker pac;
-            pac.reserve_buffer(length_of_message);
-            memcpy(pac.buffer(), remaining_message, length_of_message);
-            pac.buffer_consumed(length_of_message);
-            msgpack::object_handle obj_handle;
-
-            if (!pac.next(obj_handle))
+            // the message is decoded where it is, strings and binary data in the objects point into the message and
+            // anything else the objects need comes from the zone, which keeps its memory from one message to the next
+            zone.clear();
+            msgpack::object msgpack_obj;
+            try
+            {
+                size_t offset = 0;
+                msgpack_obj = msgpack::unpack(zone, remaining_message, length_of_message, offset, &reference_in_place);
+            }
+            catch (const msgpack::insufficient_bytes&)
             {
                 throw signalr_exception("messagepack object was incomplete");
             }
 
-            auto& msgpack_obj = obj_handle.get();
-
             if (msgpack_obj.type != msgpack::type::ARRAY)
             {
                 throw signalr_exception("Message was not an 'array' type");
@@ -324,10 +451,12 @@ namespace signalr
             switch (static_cast<message_type>(type))
             {
             case message_type::invocation:
+            case message_type::stream_invocation:
             {
                 if (num_elements_of_message < 5)
                 {
-                    throw signalr_exception("invocation message has too few properties");
+                    throw signalr_exception(static_cast<message_type>(type) == message_type::invocation
+                        ? "invocation message has too few properties" : "stream_invocation message has too few properties");
                 }
 
                 // HEADERS
@@ -359,6 +488,7 @@ namespace signalr
 
                 std::vector<signalr::value> args;
                 auto size = msgpack_obj_index->via.array.size;
+                args.reserve(size);
                 auto arg_array_index = msgpack_obj_index->via.array.ptr;
                 for (uint32_t i = 0; i < size; ++i)
                 {
@@ -366,13 +496,39 @@ namespace signalr
                     ++arg_array_index;
                 }
 
-                vec.emplace_back(std::unique_ptr<hub_message>(
-                    new invocation_message(std::move(invocation_id), std::move(target), std::move(args))));
-
+                std::vector<std::string> stream_ids;
                 if (num_elements_of_message > 5)
                 {
-                    // This is for the StreamIds when they are supported
                     ++msgpack_obj_index;
+                    if (msgpack_obj_index->type != msgpack::type::ARRAY)
+                    {
+                        throw signalr_exception("reading 'streamIds' as array failed");
+                    }
+                    stream_ids.reserve(msgpack_obj_index->via.array.size);
+                    for (uint32_t i = 0; i < msgpack_obj_index->via.array.size; ++i)
+                    {
+                        auto& stream_id = msgpack_obj_index->via.array.ptr[i];
+                        if (stream_id.type != msgpack::type::STR)
+                        {
+                            throw signalr_exception("reading 'streamIds' as array of strings failed");
+                        }
+                        stream_ids.emplace_back(stream_id.via.str.ptr, stream_id.via.str.size);
+                    }
+                }
+
+                if (static_cast<message_type>(type) == message_type::invocation)
+                {
+                    vec.emplace_back(std::unique_ptr<hub_message>(
+                        new invocation_message(std::move(invocation_id), std::move(target), std::move(args), std::move(stream_ids))));
+                }
+                else
+                {
+                    if (invocation_id.empty())
+                    {
+                        throw signalr_exception("reading 'invocationId' as string failed");
+                    }
+                    vec.emplace_back(std::unique_ptr<hub_message>(
+                        new invocation_message(message_type::stream_invocation, invocation_id, target, args, stream_ids)));
                 }
 
                 break;
@@ -428,6 +584,36 @@ namespace signalr
                     new completion_message(std::move(invocation_id), std::move(error), std::move(result), result_kind == 3)));
                 break;
             }
+            case message_type::stream_item:
+            case message_type::cancel_invocation:
+            {
+                if (num_elements_of_message < (static_cast<message_type>(type) == message_type::stream_item ? 4U : 3U))
+                {
+                    throw signalr_exception(static_cast<message_type>(type) == message_type::stream_item
+                        ? "stream_item message has too few properties" : "cancel_invocation message has too few properties");
+                }
+
+                // HEADERS
+                ++msgpack_obj_index;
+
+                if (msgpack_obj_index->type != msgpack::type::STR)
+                {
+                    throw signalr_exception("reading 'invocationId' as string failed");
+                }
+                std::string invocation_id(msgpack_obj_index->via.str.ptr, msgpack_obj_index->via.str.size);
+                ++msgpack_obj_index;
+
+                if (static_cast<message_type>(type) == message_type::stream_item)
+                {
+                    vec.emplace_back(std::unique_ptr<hub_message>(
+                        new stream_item_message(std::move(invocation_id), createValue(*msgpack_obj_index))));
+                }
+                else
+                {
+                    vec.emplace_back(std::unique_ptr<hub_message>(new cancel_invocation_message(invocation_id)));
+                }
+                break;
+            }
             case message_type::ping:
             {
                 vec.emplace_back(std::unique_ptr<hub_message>(new ping_message()));
@@ -8,6 +8,7 @@
 
 #include "signalrclient/signalr_value.h"
 #include "hub_protocol.h"
+#include <atomic>
 
 namespace signalr
 {
@@ -35,6 +36,9 @@ namespace signalr
         ~messagepack_hub_protocol() {}
     private:
         std::string m_protocol_name = "messagepack";
+        // how many bytes the messages written recently took beyond their strings and binary data, to guess the size of
+        // the next one before writing it
+        mutable std::atomic<size_t> m_typical_overhead{ 0 };
     };
 }
 
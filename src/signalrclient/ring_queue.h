@@ -0,0 +1,80 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <assert.h>
+#include <utility>
+#include <vector>
+
+namespace signalr
+{
+    // A FIFO queue over a growable ring buffer. Unlike std::deque, which allocates and frees a block every few elements as
+    // items flow through it, the buffer only grows and is reused, so a queue that has reached its working size doesn't
+    // allocate. T must be default constructible and movable.
+    template <typename T>
+    class ring_queue
+    {
+    public:
+        ring_queue()
+            : m_head(0), m_size(0)
+        { }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        void push_back(T&& item)
+        {
+            if (m_size == m_items.size())
+            {
+                grow();
+            }
+
+            m_items[(m_head + m_size) % m_items.size()] = std::move(item);
+            ++m_size;
+        }
+
+        T& front()
+        {
+            assert(m_size != 0);
+
+            return m_items[m_head];
+        }
+
+        // moves the front item out, leaving a moved-from item in its slot
+        T pop_front()
+        {
+            assert(m_size != 0);
+
+            T item = std::move(m_items[m_head]);
+            m_head = (m_head + 1) % m_items.size();
+            --m_size;
+            return item;
+        }
+
+    private:
+        std::vector<T> m_items;
+        size_t m_head;
+        size_t m_size;
+
+        void grow()
+        {
+            std::vector<T> items(m_items.empty() ? 16 : m_items.size() * 2);
+            for (size_t i = 0; i < m_size; ++i)
+            {
+                items[i] = std::move(m_items[(m_head + i) % m_items.size()]);
+            }
+
+            m_items.swap(items);
+            m_head = 0;
+        }
+    };
+}
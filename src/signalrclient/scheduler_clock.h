@@ -0,0 +1,29 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include "../include/signalrclient/clock_source.h"
+#include <chrono>
+
+namespace signalr
+{
+    // the scheduler's clock_source interface, or null when it uses the steady clock
+    inline const clock_source* find_clock(const scheduler& scheduler)
+    {
+        return dynamic_cast<const clock_source*>(&scheduler);
+    }
+
+    inline std::chrono::steady_clock::time_point clock_now(const clock_source* clock)
+    {
+        return clock != nullptr ? clock->now() : std::chrono::steady_clock::now();
+    }
+
+    // the time delays on the scheduler are measured against
+    inline std::chrono::steady_clock::time_point clock_now(const scheduler& scheduler)
+    {
+        return clock_now(find_clock(scheduler));
+    }
+}
@@ -5,10 +5,17 @@
 #include "stdafx.h"
 #include "signalrclient/signalr_client_config.h"
 #include "signalr_default_scheduler.h"
+#include <mutex>
 #include <stdexcept>
 
 namespace signalr
 {
+    struct signalr_client_config::scheduler_slot
+    {
+        std::mutex lock;
+        std::shared_ptr<signalr::scheduler> scheduler;
+    };
+
 #ifdef USE_CPPRESTSDK
     void signalr_client_config::set_proxy(const web::web_proxy &proxy)
     {
@@ -50,11 +57,23 @@ namespace signalr
 #endif
 
     signalr_client_config::signalr_client_config()
-        : m_handshake_timeout(std::chrono::seconds(15))
+        : m_scheduler(std::make_shared<scheduler_slot>())
+        , m_user_scheduler(false)
+        , m_use_shared_scheduler(true)
+        , m_scheduler_thread_count(0)
+        , m_scheduler_metrics_enabled(false)
+        , m_scheduler_metrics_interval(std::chrono::milliseconds::zero())
+        , m_callback_mode(callback_mode::scheduled)
+        , m_handshake_timeout(std::chrono::seconds(15))
         , m_server_timeout(std::chrono::seconds(30))
         , m_keepalive_interval(std::chrono::seconds(15))
+        , m_invocation_timeout(std::chrono::milliseconds::zero())
+        , m_max_pending_invocations(0)
+        , m_max_outbound_bytes(0)
+        , m_flow_control_mode(flow_control_mode::wait)
+        , m_stream_buffer_capacity(64)
+        , m_use_message_arena(false)
     {
-        m_scheduler = std::make_shared<signalr_default_scheduler>();
     }
 
     const std::map<std::string, std::string>& signalr_client_config::get_http_headers() const noexcept
@@ -79,12 +98,138 @@ namespace signalr
             return;
         }
 
-        m_scheduler = std::move(scheduler);
+        m_scheduler = std::make_shared<scheduler_slot>();
+        m_scheduler->scheduler = std::move(scheduler);
+        m_user_scheduler = true;
+    }
+
+    const std::shared_ptr<scheduler>& signalr_client_config::get_scheduler() const
+    {
+        // copies of the config share the slot, so the ones made before the first call end up with the same scheduler
+        std::lock_guard<std::mutex> lock(m_scheduler->lock);
+        if (!m_scheduler->scheduler)
+        {
+            m_scheduler->scheduler = create_default_scheduler(*this);
+        }
+        return m_scheduler->scheduler;
+    }
+
+    void signalr_client_config::release_default_scheduler()
+    {
+        if (!m_user_scheduler)
+        {
+            // copies keep the old slot and the scheduler in it, a shared scheduler that was only used by this config shuts
+            // down before the next get_scheduler creates one with the new settings
+            m_scheduler = std::make_shared<scheduler_slot>();
+        }
+    }
+
+    void signalr_client_config::set_use_shared_scheduler(bool use_shared_scheduler)
+    {
+        m_use_shared_scheduler = use_shared_scheduler;
+        release_default_scheduler();
+    }
+
+    bool signalr_client_config::get_use_shared_scheduler() const noexcept
+    {
+        return m_use_shared_scheduler;
+    }
+
+    void signalr_client_config::set_scheduler_thread_count(size_t thread_count)
+    {
+        m_scheduler_thread_count = thread_count;
+        release_default_scheduler();
+    }
+
+    size_t signalr_client_config::get_scheduler_thread_count() const noexcept
+    {
+        return m_scheduler_thread_count;
+    }
+
+    void signalr_client_config::set_scheduler_thread_name(const std::string& thread_name)
+    {
+        m_scheduler_thread_name = thread_name;
+        release_default_scheduler();
+    }
+
+    const std::string& signalr_client_config::get_scheduler_thread_name() const noexcept
+    {
+        return m_scheduler_thread_name;
+    }
+
+    void signalr_client_config::set_scheduler_thread_affinity(const std::vector<int>& cpus)
+    {
+        for (auto cpu : cpus)
+        {
+            if (cpu < 0)
+            {
+                throw std::runtime_error("cpu index must not be negative.");
+            }
+        }
+
+        m_scheduler_thread_affinity = cpus;
+        release_default_scheduler();
+    }
+
+    const std::vector<int>& signalr_client_config::get_scheduler_thread_affinity() const noexcept
+    {
+        return m_scheduler_thread_affinity;
+    }
+
+    void signalr_client_config::set_scheduler_metrics_enabled(bool enabled)
+    {
+        m_scheduler_metrics_enabled = enabled;
+        release_default_scheduler();
+    }
+
+    bool signalr_client_config::get_scheduler_metrics_enabled() const noexcept
+    {
+        return m_scheduler_metrics_enabled;
+    }
+
+    void signalr_client_config::set_scheduler_metrics_callback(std::function<void(const scheduler_metrics&)> callback, std::chrono::milliseconds interval)
+    {
+        if (interval <= std::chrono::seconds(0))
+        {
+            throw std::runtime_error("interval must be greater than 0.");
+        }
+
+        m_scheduler_metrics_enabled = true;
+        m_scheduler_metrics_callback = std::move(callback);
+        m_scheduler_metrics_interval = interval;
+        release_default_scheduler();
+    }
+
+    const std::function<void(const scheduler_metrics&)>& signalr_client_config::get_scheduler_metrics_callback() const noexcept
+    {
+        return m_scheduler_metrics_callback;
+    }
+
+    std::chrono::milliseconds signalr_client_config::get_scheduler_metrics_interval() const noexcept
+    {
+        return m_scheduler_metrics_interval;
+    }
+
+    bool signalr_client_config::get_scheduler_metrics(scheduler_metrics& metrics) const
+    {
+        if (m_user_scheduler || !m_scheduler_metrics_enabled)
+        {
+            return false;
+        }
+
+        // the scheduler is only something other than signalr_default_scheduler when the user provided it
+        auto& scheduler = static_cast<signalr_default_scheduler&>(*get_scheduler());
+        return scheduler.get_metrics(metrics);
     }
 
-    const std::shared_ptr<scheduler>& signalr_client_config::get_scheduler() const noexcept
+    void signalr_client_config::set_callback_mode(callback_mode mode)
     {
-        return m_scheduler;
+        m_callback_mode = mode;
+    }
+
+    callback_mode signalr_client_config::get_callback_mode() const noexcept
+    {
+        return m_callback_mode;
     }
 
     void signalr_client_config::set_handshake_timeout(std::chrono::milliseconds timeout)
@@ -131,4 +276,74 @@ namespace signalr
     {
         return m_keepalive_interval;
     }
+
+    void signalr_client_config::set_invocation_timeout(std::chrono::milliseconds timeout)
+    {
+        if (timeout < std::chrono::seconds(0))
+        {
+            throw std::runtime_error("timeout must not be negative.");
+        }
+
+        m_invocation_timeout = timeout;
+    }
+
+    std::chrono::milliseconds signalr_client_config::get_invocation_timeout() const noexcept
+    {
+        return m_invocation_timeout;
+    }
+
+    void signalr_client_config::set_max_pending_invocations(size_t max_pending_invocations)
+    {
+        m_max_pending_invocations = max_pending_invocations;
+    }
+
+    size_t signalr_client_config::get_max_pending_invocations() const noexcept
+    {
+        return m_max_pending_invocations;
+    }
+
+    void signalr_client_config::set_max_outbound_bytes(size_t max_outbound_bytes)
+    {
+        m_max_outbound_bytes = max_outbound_bytes;
+    }
+
+    size_t signalr_client_config::get_max_outbound_bytes() const noexcept
+    {
+        return m_max_outbound_bytes;
+    }
+
+    void signalr_client_config::set_flow_control_mode(flow_control_mode mode)
+    {
+        m_flow_control_mode = mode;
+    }
+
+    flow_control_mode signalr_client_config::get_flow_control_mode() const noexcept
+    {
+        return m_flow_control_mode;
+    }
+
+    void signalr_client_config::set_stream_buffer_capacity(size_t stream_buffer_capacity)
+    {
+        if (stream_buffer_capacity == 0)
+        {
+            throw std::runtime_error("capacity must be greater than 0.");
+        }
+
+        m_stream_buffer_capacity = stream_buffer_capacity;
+    }
+
+    size_t signalr_client_config::get_stream_buffer_capacity() const noexcept
+    {
+        return m_stream_buffer_capacity;
+    }
+
+    void signalr_client_config::set_use_message_arena(bool use_message_arena)
+    {
+        m_use_message_arena = use_message_arena;
+    }
+
+    bool signalr_client_config::get_use_message_arena() const noexcept
+    {
+        return m_use_message_arena;
+    }
 }
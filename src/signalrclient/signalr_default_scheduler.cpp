@@ -5,120 +5,138 @@
 #include "stdafx.h"
 #include <assert.h>
 #include "signalr_default_scheduler.h"
+#include "signalrclient/signalr_client_config.h"
+#include <algorithm>
+#include <map>
 #include <thread>
+#include <tuple>
 
 namespace signalr
 {
-    thread::thread()
-        : m_internals(std::make_shared<internals>())
+    void signalr_default_scheduler::schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay)
     {
-        auto internals = m_internals;
-
-        m_thread = std::thread([=]()
-            {
-                while (true)
-                {
-                    {
-                        signalr_base_cb cb;
-                        {
-                            std::unique_lock<std::mutex> lock(internals->m_callback_lock);
-                            auto& callback = internals->m_callback;
-                            const auto& closed = internals->m_closed;
-
-                            if (closed && callback == nullptr)
-                            {
-                                return;
-                            }
+        schedule_task(task(cb), delay);
+    }
 
-                            if (callback == nullptr)
-                            {
-                                internals->m_callback_cv.wait(lock,
-                                    [&callback, &closed]
-                                    {
-                                        return closed || callback != nullptr;
-                                    });
-                            }
+    void signalr_default_scheduler::schedule_task(task&& t, std::chrono::milliseconds delay)
+    {
+        if (delay <= std::chrono::milliseconds::zero())
+        {
+            // no reason to go through the dispatcher, a worker can pick the callback up right away
+            m_internals->m_pool.submit(std::move(t));
+            return;
+        }
 
-                            if (closed && callback == nullptr)
-                            {
-                                assert(callback == nullptr);
-                                return;
-                            }
+        bool is_earliest;
+        {
+            std::lock_guard<std::mutex> lock(m_internals->m_callback_lock);
+            assert(m_internals->m_closed == false);
+            is_earliest = add_timer(*m_internals, std::move(t), delay);
+        } // unlock
 
-                            cb = callback;
-                            internals->m_callback = nullptr;
-                        } // unlock
+        // the dispatcher is already sleeping until an earlier deadline, only wake it if this callback is now first in line
+        if (is_earliest)
+        {
+            m_internals->m_callback_cv.notify_one();
+        }
+    }
 
-                        try
-                        {
-                            cb();
-                        }
-                        catch (...)
-                        {
-                            // ignore exceptions?
-                            assert(false);
-                        }
-                    } // destruct cb, otherwise it's possible a shared_ptr is being held by the lambda/function and on destruction it could schedule work which could be
-                    // added to this thread and if it then blocks waiting for completion it would deadlock. If we destruct before setting the m_busy flag,
-                    // another thread will run the work instead.
+    bool signalr_default_scheduler::add_timer(internals& internals, task&& t, std::chrono::milliseconds delay)
+    {
+        auto& timers = internals.m_timers;
+        auto sequence = internals.m_timer_sequence++;
+        timers.push_back(timer_entry{ std::chrono::steady_clock::now() + delay, sequence, std::move(t) });
+        std::push_heap(timers.begin(), timers.end(), timer_entry_later());
 
-                    internals->m_busy = false;
-                }
+        return timers.front().sequence == sequence;
+    }
 
-                assert(internals->m_callback == nullptr);
-            });
+    void signalr_default_scheduler::enable_metrics()
+    {
+        m_internals->m_pool.enable_metrics();
     }
 
-    void thread::add(signalr_base_cb cb)
+    bool signalr_default_scheduler::get_metrics(scheduler_metrics& metrics) const
     {
+        if (!m_internals->m_pool.metrics_enabled())
         {
-            assert(m_internals->m_closed == false);
-            assert(m_internals->m_busy == false);
+            return false;
+        }
 
-            std::lock_guard<std::mutex> lock(m_internals->m_callback_lock);
-            m_internals->m_callback = cb;
-            m_internals->m_busy = true;
-        } // unlock
+        collect_metrics(*m_internals, metrics);
+        return true;
     }
 
-    void thread::start()
+    void signalr_default_scheduler::set_metrics_callback(std::function<void(const scheduler_metrics&)> callback, std::chrono::milliseconds interval)
     {
-        m_internals->m_callback_cv.notify_one();
-    }
+        assert(interval > std::chrono::milliseconds::zero());
+        enable_metrics();
 
-    void thread::shutdown()
-    {
         {
-            std::unique_lock<std::mutex> lock(m_internals->m_callback_lock);
-            m_internals->m_closed = true;
-        }
+            std::lock_guard<std::mutex> lock(m_internals->m_callback_lock);
+            m_internals->m_metrics_callback = std::move(callback);
+            m_internals->m_metrics_interval = interval;
+            if (m_internals->m_metrics_push_scheduled || !m_internals->m_metrics_callback)
+            {
+                // the scheduled push picks up the new callback, and stops if there is none
+                return;
+            }
+
+            schedule_metrics_push(m_internals);
+        } // unlock
+
         m_internals->m_callback_cv.notify_one();
-        m_thread.join();
     }
 
-    bool thread::is_free() const
+    void signalr_default_scheduler::collect_metrics(internals& internals, scheduler_metrics& metrics)
     {
-        return !m_internals->m_busy;
+        internals.m_pool.collect_metrics(metrics);
+        internals.m_timer_lateness.snapshot(metrics.timer_lateness);
+
+        std::lock_guard<std::mutex> lock(internals.m_callback_lock);
+        // the pending metrics push isn't a user callback
+        metrics.pending_timers = internals.m_timers.size() - (internals.m_metrics_push_scheduled ? 1 : 0);
     }
 
-    thread::~thread()
+    void signalr_default_scheduler::schedule_metrics_push(const std::shared_ptr<internals>& internals)
     {
-        shutdown();
+        internals->m_metrics_push_scheduled = true;
+        internals->m_metrics_push_sequence = internals->m_timer_sequence;
+        // the entry holds a strong reference, close() removes it so the dispatcher can exit
+        add_timer(*internals, [internals]()
+            {
+                push_metrics(internals);
+            }, internals->m_metrics_interval);
     }
 
-    void signalr_default_scheduler::schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay)
+    void signalr_default_scheduler::push_metrics(const std::shared_ptr<internals>& internals)
     {
+        std::function<void(const scheduler_metrics&)> callback;
         {
-            std::lock_guard<std::mutex> lock(m_internals->m_callback_lock);
-            assert(m_internals->m_closed == false);
-            m_internals->m_callbacks.push_back(std::make_pair(cb, std::chrono::steady_clock::now() + delay));
+            std::lock_guard<std::mutex> lock(internals->m_callback_lock);
+            internals->m_metrics_push_scheduled = false;
+            callback = internals->m_metrics_callback;
         } // unlock
 
-        // If callback has a delay, no point in running the logic to check if it should run early
-        if (delay == std::chrono::milliseconds::zero())
+        if (callback)
         {
-            m_internals->m_callback_cv.notify_one();
+            scheduler_metrics metrics;
+            collect_metrics(*internals, metrics);
+            callback(metrics);
         }
+
+        {
+            std::lock_guard<std::mutex> lock(internals->m_callback_lock);
+            if (internals->m_closed || !internals->m_metrics_callback || internals->m_metrics_push_scheduled)
+            {
+                return;
+            }
+
+            schedule_metrics_push(internals);
+        } // unlock
+
+        // wakes the dispatcher in case the push is now the earliest timer
+        internals->m_callback_cv.notify_one();
     }
 
     void signalr_default_scheduler::run()
@@ -127,75 +145,79 @@ namespace signalr
 
         std::thread([=]()
             {
-                std::vector<thread> threads{ 5 };
-
-                std::unique_lock<std::mutex> lock(internals->m_callback_lock);
-
-                auto prev_callback_count = size_t{ 0 };
-
-                while (true)
+                std::vector<task> due;
                 {
-                    auto& callbacks = internals->m_callbacks;
+                    std::unique_lock<std::mutex> lock(internals->m_callback_lock);
+                    auto& timers = internals->m_timers;
                     const auto& closed = internals->m_closed;
 
-                    if (closed && callbacks.empty())
+                    while (!(closed && timers.empty()))
                     {
-                        return;
-                    }
+                        if (timers.empty())
+                        {
+                            internals->m_callback_cv.wait(lock);
+                            continue;
+                        }
 
-                    internals->m_callback_cv.wait_for(lock, std::chrono::milliseconds(15),
-                        [&callbacks, &closed, &prev_callback_count]
+                        // sleep exactly until the earliest deadline, schedule() wakes us early if an earlier deadline is added
+                        auto deadline = timers.front().deadline;
+                        if (std::chrono::steady_clock::now() < deadline)
                         {
-                            return closed || prev_callback_count != callbacks.size();
-                        });
+                            internals->m_callback_cv.wait_until(lock, deadline);
+                            continue;
+                        }
 
-                    // find the first callback that is ready to run, find a thread to run it and remove it from the list
-                    auto curr_time = std::chrono::steady_clock::now();
-                    auto it = callbacks.begin();
-                    while (it != callbacks.end())
-                    {
-                        auto found = false;
-                        if (it->second <= curr_time)
+                        auto curr_time = std::chrono::steady_clock::now();
+                        auto metrics_enabled = internals->m_pool.metrics_enabled();
+                        while (!timers.empty() && timers.front().deadline <= curr_time)
                         {
-                            for (auto& thread : threads)
-                            {
-                                if (thread.is_free())
-                                {
-                                    {
-                                        thread.add((*it).first);
-                                        (*it).first = nullptr;
-                                        // destruct callback in case the destructor can schedule a job which would throw on recursive lock acquisition
-                                    }
-                                    thread.start();
-                                    found = true;
-                                    break;
-                                }
-                            }
-                            if (!found)
+                            if (metrics_enabled)
                             {
-                                break;
+                                internals->m_timer_lateness.record(curr_time - timers.front().deadline);
                             }
+                            std::pop_heap(timers.begin(), timers.end(), timer_entry_later());
+                            due.push_back(std::move(timers.back().callback));
+                            timers.pop_back();
                         }
-                        if (found)
-                        {
-                            it = callbacks.erase(it);
-                        }
-                        else
+
+                        // hand the callbacks to the pool without holding the lock so schedule() isn't blocked behind it
+                        lock.unlock();
+                        for (auto& cb : due)
                         {
-                            ++it;
+                            internals->m_pool.submit(std::move(cb));
                         }
+                        due.clear();
+                        lock.lock();
                     }
+                } // unlock
 
-                    prev_callback_count = callbacks.size();
-                }
+                // runs whatever is still queued and joins the workers
+                internals->m_pool.shutdown();
 
-                assert(internals->m_callbacks.empty());
+                assert(internals->m_timers.empty());
             }).detach();
     }
 
     void signalr_default_scheduler::close()
     {
-        m_internals->m_closed = true;
+        {
+            std::lock_guard<std::mutex> lock(m_internals->m_callback_lock);
+            m_internals->m_closed = true;
+
+            if (m_internals->m_metrics_push_scheduled)
+            {
+                // the next push would keep the dispatcher running for up to an interval after the scheduler went away
+                auto& timers = m_internals->m_timers;
+                auto sequence = m_internals->m_metrics_push_sequence;
+                timers.erase(std::remove_if(timers.begin(), timers.end(), [sequence](const timer_entry& entry)
+                    {
+                        return entry.sequence == sequence;
+                    }), timers.end());
+                std::make_heap(timers.begin(), timers.end(), timer_entry_later());
+                m_internals->m_metrics_push_scheduled = false;
+            }
+        } // unlock
+
         m_internals->m_callback_cv.notify_one();
     }
 
@@ -204,22 +226,53 @@ namespace signalr
         close();
     }
 
-    // This will schedule the given func to run every second until the func returns true.
-    void timer(const std::shared_ptr<scheduler>& scheduler, std::function<bool(std::chrono::milliseconds)> func)
+    std::shared_ptr<scheduler> create_default_scheduler(const signalr_client_config& config)
     {
-        timer_internal(scheduler, func, std::chrono::milliseconds::zero());
-    }
+        thread_pool_options options;
+        options.thread_count = config.get_scheduler_thread_count();
+        options.thread_name = config.get_scheduler_thread_name();
+        options.cpu_affinity = config.get_scheduler_thread_affinity();
 
-    void timer_internal(const std::shared_ptr<scheduler>& scheduler, std::function<bool(std::chrono::milliseconds)> func, std::chrono::milliseconds duration)
-    {
-        constexpr auto tick = std::chrono::seconds(1);
-        duration += tick;
-        scheduler->schedule([func, scheduler, duration]()
+        auto apply_metrics = [&config](signalr_default_scheduler& scheduler)
+        {
+            if (config.get_scheduler_metrics_callback())
             {
-                if (!func(duration))
-                {
-                    timer_internal(scheduler, func, duration);
-                }
-            }, tick);
+                scheduler.set_metrics_callback(config.get_scheduler_metrics_callback(), config.get_scheduler_metrics_interval());
+            }
+            else if (config.get_scheduler_metrics_enabled())
+            {
+                scheduler.enable_metrics();
+            }
+        };
+
+        if (!config.get_use_shared_scheduler())
+        {
+            auto scheduler = std::make_shared<signalr_default_scheduler>(options);
+            apply_metrics(*scheduler);
+            return scheduler;
+        }
+
+        // configs share the scheduler created with the same thread settings, so a config never gets threads configured
+        // differently than it asked for. Only weak references are kept here so a scheduler shuts down (and its threads
+        // exit) when the last config or connection using it goes away, a connection started after that creates a new one
+        static std::mutex shared_schedulers_lock;
+        static std::map<std::tuple<size_t, std::string, std::vector<int>>, std::weak_ptr<signalr_default_scheduler>> shared_schedulers;
+
+        std::lock_guard<std::mutex> lock(shared_schedulers_lock);
+        for (auto it = shared_schedulers.begin(); it != shared_schedulers.end();)
+        {
+            it = it->second.expired() ? shared_schedulers.erase(it) : std::next(it);
+        }
+
+        auto& shared_scheduler = shared_schedulers[std::make_tuple(options.thread_count, options.thread_name, options.cpu_affinity)];
+        auto scheduler = shared_scheduler.lock();
+        if (!scheduler)
+        {
+            scheduler = std::make_shared<signalr_default_scheduler>(options);
+            shared_scheduler = scheduler;
+        }
+        apply_metrics(*scheduler);
+
+        return scheduler;
     }
 }
@@ -5,73 +5,109 @@
 #pragma once
 
 #include "../include/signalrclient/scheduler.h"
+#include "thread_pool.h"
+#include "latency_recorder.h"
+#include "task.h"
+#include "signalrclient/scheduler_metrics.h"
 #include <thread>
 #include <mutex>
 #include <vector>
 #include <condition_variable>
+#include <cstdint>
 
 namespace signalr
 {
-    struct thread
-    {
-    public:
-        thread();
-        thread(const thread&) = delete;
-        thread& operator=(const thread&) = delete;
-
-        void add(signalr_base_cb);
-        void start();
-        bool is_free() const;
-        void shutdown();
-        ~thread();
-    private:
-#pragma warning( push )
-#pragma warning( disable: 4625 5026 4626 5027 )
-        struct internals
-        {
-            signalr_base_cb m_callback;
-            std::mutex m_callback_lock;
-            std::condition_variable m_callback_cv;
-            bool m_closed;
-            bool m_busy;
-        };
-#pragma warning( pop )
-
-        std::shared_ptr<internals> m_internals;
-        std::thread m_thread;
-    };
+    class signalr_client_config;
 
-    struct signalr_default_scheduler : scheduler
+    struct signalr_default_scheduler : scheduler, task_scheduler
     {
-        signalr_default_scheduler() : m_internals(std::make_shared<internals>())
+        explicit signalr_default_scheduler(const thread_pool_options& options = thread_pool_options())
+            : m_internals(std::make_shared<internals>(options))
         {
             run();
         }
         signalr_default_scheduler(const signalr_default_scheduler&) = delete;
         signalr_default_scheduler& operator=(const signalr_default_scheduler&) = delete;
 
-        void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero());
+        void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override;
+        // doesn't allocate when the task's callable fits the task's inline storage, other than to grow the queues
+        void schedule_task(task&& t, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override;
         ~signalr_default_scheduler();
 
+        // metrics are off until enabled and can't be turned off again, the cost while they are off is a relaxed atomic load
+        // per callback
+        void enable_metrics();
+        // returns false if metrics aren't enabled
+        bool get_metrics(scheduler_metrics& metrics) const;
+        // enables metrics and pushes a snapshot to the callback every interval from one of the workers, replaces the
+        // previous callback
+        void set_metrics_callback(std::function<void(const scheduler_metrics&)> callback, std::chrono::milliseconds interval);
+
     private:
         void run();
 
+        typedef std::chrono::time_point<std::chrono::steady_clock, std::chrono::nanoseconds> time_point;
+
+        struct timer_entry
+        {
+            time_point deadline;
+            // breaks ties between equal deadlines so callbacks scheduled for the same time run in the order they were scheduled
+            uint64_t sequence;
+            task callback;
+        };
+
+        // std::push_heap/std::pop_heap build a max-heap, inverting the comparison keeps the earliest deadline at the front
+        struct timer_entry_later
+        {
+            bool operator()(const timer_entry& lhs, const timer_entry& rhs) const
+            {
+                if (lhs.deadline != rhs.deadline)
+                {
+                    return lhs.deadline > rhs.deadline;
+                }
+                return lhs.sequence > rhs.sequence;
+            }
+        };
+
 #pragma warning( push )
 #pragma warning( disable: 4625 5026 4626 5027 )
         struct internals
         {
-            std::vector<std::pair<signalr_base_cb, std::chrono::time_point<std::chrono::steady_clock, std::chrono::nanoseconds>>> m_callbacks;
+            explicit internals(const thread_pool_options& options) : m_pool(options)
+            { }
+
+            // delayed callbacks, kept as a min-heap on the deadline so the dispatcher only ever looks at the front
+            std::vector<timer_entry> m_timers;
+            uint64_t m_timer_sequence = 0;
             std::mutex m_callback_lock;
+            // wakes the dispatcher when a new earliest deadline is added or the scheduler is closed
             std::condition_variable m_callback_cv;
-            bool m_closed;
+            bool m_closed = false;
+            // runs callbacks once they are due, shut down by the dispatcher after the last timer has been handed off
+            thread_pool m_pool;
+
+            latency_recorder m_timer_lateness;
+            std::function<void(const scheduler_metrics&)> m_metrics_callback;
+            std::chrono::milliseconds m_metrics_interval{ 0 };
+            // the timer entry of the next push, removed on close so the dispatcher doesn't wait for it
+            bool m_metrics_push_scheduled = false;
+            uint64_t m_metrics_push_sequence = 0;
         };
 #pragma warning( pop )
 
         std::shared_ptr<internals> m_internals;
 
         void close();
+
+        // must be called with m_callback_lock held, returns true if the callback is now the earliest one
+        static bool add_timer(internals& internals, task&& t, std::chrono::milliseconds delay);
+        static void collect_metrics(internals& internals, scheduler_metrics& metrics);
+        static void push_metrics(const std::shared_ptr<internals>& internals);
+        // must be called with m_callback_lock held
+        static void schedule_metrics_push(const std::shared_ptr<internals>& internals);
     };
 
-    void timer_internal(const std::shared_ptr<scheduler>& scheduler, std::function<bool(std::chrono::milliseconds)> func, std::chrono::milliseconds duration);
-    void timer(const std::shared_ptr<scheduler>& scheduler, std::function<bool(std::chrono::milliseconds)> func);
-}
\ No newline at end of file
+    // returns the scheduler used when the user didn't provide one, either the process-wide shared scheduler or a new one
+    // configured with the config's scheduler settings
+    std::shared_ptr<scheduler> create_default_scheduler(const signalr_client_config& config);
+}
@@ -5,6 +5,9 @@
 #include "stdafx.h"
 #include "signalrclient/signalr_value.h"
 #include "signalrclient/signalr_exception.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
 namespace signalr
@@ -21,6 +24,10 @@ namespace signalr
             return "string";
         case signalr::value_type::float64:
             return "float64";
+        case signalr::value_type::int64:
+            return "int64";
+        case signalr::value_type::uint64:
+            return "uint64";
         case signalr::value_type::null:
             return "null";
         case signalr::value_type::boolean:
@@ -32,6 +39,241 @@ namespace signalr
         }
     }
 
+    namespace
+    {
+        // maps up to this size are sorted by insertion and searched linearly
+        const size_t small_map_size = 16;
+
+        bool member_name_less(const std::pair<std::string, value>& member, const std::string& name)
+        {
+            return member.first < name;
+        }
+    }
+
+    value_map::value_map(const std::map<std::string, value>& map)
+        : m_members(map.begin(), map.end()), m_std_map(nullptr)
+    {}
+
+    value_map::value_map(std::vector<std::pair<std::string, value>>&& members)
+        : m_members(std::make_move_iterator(members.begin()), std::make_move_iterator(members.end())), m_std_map(nullptr)
+    {
+        sort_members();
+    }
+
+    value_map::value_map(value_vector<std::pair<std::string, value>>&& members)
+        : m_members(std::move(members)), m_std_map(nullptr)
+    {
+        sort_members();
+    }
+
+    value_map::value_map(const value_map& other)
+        : m_members(other.m_members), m_std_map(nullptr)
+    {}
+
+    value_map::value_map(value_map&& other) noexcept
+        : m_members(std::move(other.m_members)), m_std_map(other.m_std_map.exchange(nullptr))
+    {}
+
+    value_map::~value_map()
+    {
+        delete m_std_map.load(std::memory_order_acquire);
+    }
+
+    value_map& value_map::operator=(const value_map& rhs)
+    {
+        if (this != &rhs)
+        {
+            m_members = rhs.m_members;
+            delete m_std_map.exchange(nullptr);
+        }
+        return *this;
+    }
+
+    value_map& value_map::operator=(value_map&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            m_members = std::move(rhs.m_members);
+            delete m_std_map.exchange(rhs.m_std_map.exchange(nullptr));
+        }
+        return *this;
+    }
+
+    void value_map::sort_members()
+    {
+        auto name_less = [](const std::pair<std::string, value>& lhs, const std::pair<std::string, value>& rhs)
+        {
+            return lhs.first < rhs.first;
+        };
+
+        // members usually come in the order the server declared them, the sort is stable to keep the first of duplicate
+        // names in front of the others. Objects are mostly small enough for an insertion sort, which unlike
+        // std::stable_sort doesn't allocate.
+        if (m_members.size() > small_map_size)
+        {
+            std::stable_sort(m_members.begin(), m_members.end(), name_less);
+        }
+        else
+        {
+            for (auto it = m_members.begin(); it != m_members.end(); ++it)
+            {
+                if (it == m_members.begin() || !name_less(*it, *(it - 1)))
+                {
+                    continue;
+                }
+
+                auto member = std::move(*it);
+                auto hole = it;
+                do
+                {
+                    *hole = std::move(*(hole - 1));
+                    --hole;
+                } while (hole != m_members.begin() && name_less(member, *(hole - 1)));
+                *hole = std::move(member);
+            }
+        }
+
+        auto last = std::unique(m_members.begin(), m_members.end(),
+            [](const std::pair<std::string, value>& lhs, const std::pair<std::string, value>& rhs)
+            {
+                return lhs.first == rhs.first;
+            });
+        m_members.erase(last, m_members.end());
+    }
+
+    value_map::const_iterator value_map::find(const std::string& name) const
+    {
+        if (m_members.size() <= small_map_size)
+        {
+            // names mostly differ in length, comparing those first is cheaper than the string comparisons of a binary search
+            for (auto it = m_members.begin(); it != m_members.end(); ++it)
+            {
+                if (it->first.size() == name.size() && it->first == name)
+                {
+                    return it;
+                }
+            }
+            return m_members.end();
+        }
+
+        auto found = std::lower_bound(m_members.begin(), m_members.end(), name, member_name_less);
+        if (found == m_members.end() || found->first != name)
+        {
+            return m_members.end();
+        }
+
+        return found;
+    }
+
+    size_t value_map::count(const std::string& name) const
+    {
+        return find(name) == end() ? 0 : 1;
+    }
+
+    const value& value_map::at(const std::string& name) const
+    {
+        auto found = find(name);
+        if (found == end())
+        {
+            throw std::out_of_range("value_map::at");
+        }
+
+        return found->second;
+    }
+
+    value_map::operator std::map<std::string, value>() const
+    {
+        return std::map<std::string, value>(m_members.begin(), m_members.end());
+    }
+
+    const std::map<std::string, value>& value_map::std_map() const
+    {
+        auto std_map = m_std_map.load(std::memory_order_acquire);
+        if (std_map == nullptr)
+        {
+            // threads reading the same value may race to make the copy, the first one to finish is kept
+            std::unique_ptr<std::map<std::string, value>> copy(new std::map<std::string, value>(m_members.begin(), m_members.end()));
+            if (m_std_map.compare_exchange_strong(std_map, copy.get(), std::memory_order_acq_rel))
+            {
+                std_map = copy.release();
+            }
+        }
+
+        return *std_map;
+    }
+
+    value_array::value_array(const std::vector<value>& values)
+        : m_values(values.begin(), values.end()), m_std_vector(nullptr)
+    {}
+
+    value_array::value_array(std::vector<value>&& values)
+        : m_values(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end())), m_std_vector(nullptr)
+    {}
+
+    value_array::value_array(const value_array& other)
+        : m_values(other.m_values), m_std_vector(nullptr)
+    {}
+
+    value_array::value_array(value_array&& other) noexcept
+        : m_values(std::move(other.m_values)), m_std_vector(other.m_std_vector.exchange(nullptr))
+    {}
+
+    value_array::~value_array()
+    {
+        delete m_std_vector.load(std::memory_order_acquire);
+    }
+
+    value_array& value_array::operator=(const value_array& rhs)
+    {
+        if (this != &rhs)
+        {
+            m_values = rhs.m_values;
+            delete m_std_vector.exchange(nullptr);
+        }
+        return *this;
+    }
+
+    value_array& value_array::operator=(value_array&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            m_values = std::move(rhs.m_values);
+            delete m_std_vector.exchange(rhs.m_std_vector.exchange(nullptr));
+        }
+        return *this;
+    }
+
+    const value& value_array::at(size_t index) const
+    {
+        if (index >= m_values.size())
+        {
+            throw std::out_of_range("value_array::at");
+        }
+
+        return m_values[index];
+    }
+
+    value_array::operator std::vector<value>() const
+    {
+        return std::vector<value>(m_values.begin(), m_values.end());
+    }
+
+    const std::vector<value>& value_array::std_vector() const
+    {
+        auto std_vector = m_std_vector.load(std::memory_order_acquire);
+        if (std_vector == nullptr)
+        {
+            // threads reading the same value may race to make the copy, the first one to finish is kept
+            std::unique_ptr<std::vector<value>> copy(new std::vector<value>(m_values.begin(), m_values.end()));
+            if (m_std_vector.compare_exchange_strong(std_vector, copy.get(), std::memory_order_acq_rel))
+            {
+                std_vector = copy.release();
+            }
+        }
+
+        return *std_vector;
+    }
+
     value::value() : mType(value_type::null) {}
 
     value::value(std::nullptr_t) : mType(value_type::null) {}
@@ -41,7 +283,7 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            new (&mStorage.array) std::vector<value>();
+            new (&mStorage.array) value_array();
             break;
         case value_type::string:
             new (&mStorage.string) std::string();
@@ -49,11 +291,17 @@ namespace signalr
         case value_type::float64:
             mStorage.number = 0;
             break;
+        case value_type::int64:
+            mStorage.int64 = 0;
+            break;
+        case value_type::uint64:
+            mStorage.uint64 = 0;
+            break;
         case value_type::boolean:
             mStorage.boolean = false;
             break;
         case value_type::map:
-            new (&mStorage.map) std::map<std::string, value>();
+            new (&mStorage.map) value_map();
             break;
         case value_type::binary:
             new (&mStorage.binary) std::vector<uint8_t>();
@@ -74,6 +322,16 @@ namespace signalr
         mStorage.number = val;
     }
 
+    value::value(int64_t val) : mType(value_type::int64)
+    {
+        mStorage.int64 = val;
+    }
+
+    value::value(uint64_t val) : mType(value_type::uint64)
+    {
+        mStorage.uint64 = val;
+    }
+
     value::value(const std::string& val) : mType(value_type::string)
     {
         new (&mStorage.string) std::string(val);
@@ -96,22 +354,43 @@ namespace signalr
 
     value::value(const std::vector<value>& val) : mType(value_type::array)
     {
-        new (&mStorage.array) std::vector<value>(val);
+        new (&mStorage.array) value_array(val);
     }
 
     value::value(std::vector<value>&& val) : mType(value_type::array)
     {
-        new (&mStorage.array) std::vector<value>(std::move(val));
+        new (&mStorage.array) value_array(std::move(val));
+    }
+
+    value::value(const value_array& val) : mType(value_type::array)
+    {
+        new (&mStorage.array) value_array(val);
+    }
+
+    value::value(value_array&& val) : mType(value_type::array)
+    {
+        new (&mStorage.array) value_array(std::move(val));
     }
 
     value::value(const std::map<std::string, value>& map) : mType(value_type::map)
     {
-        new (&mStorage.map) std::map<std::string, value>(map);
+        new (&mStorage.map) value_map(map);
     }
 
     value::value(std::map<std::string, value>&& map) : mType(value_type::map)
     {
-        new (&mStorage.map) std::map<std::string, value>(std::move(map));
+        // the values are moved out of the nodes, the names can't be
+        new (&mStorage.map) value_map(std::make_move_iterator(map.begin()), std::make_move_iterator(map.end()));
+    }
+
+    value::value(const value_map& map) : mType(value_type::map)
+    {
+        new (&mStorage.map) value_map(map);
+    }
+
+    value::value(value_map&& map) : mType(value_type::map)
+    {
+        new (&mStorage.map) value_map(std::move(map));
     }
 
     value::value(const std::vector<uint8_t>& bin) : mType(value_type::binary)
@@ -130,7 +409,7 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            new (&mStorage.array) std::vector<value>(rhs.mStorage.array);
+            new (&mStorage.array) value_array(rhs.mStorage.array);
             break;
         case value_type::string:
             new (&mStorage.string) std::string(rhs.mStorage.string);
@@ -138,11 +417,17 @@ namespace signalr
         case value_type::float64:
             mStorage.number = rhs.mStorage.number;
             break;
+        case value_type::int64:
+            mStorage.int64 = rhs.mStorage.int64;
+            break;
+        case value_type::uint64:
+            mStorage.uint64 = rhs.mStorage.uint64;
+            break;
         case value_type::boolean:
             mStorage.boolean = rhs.mStorage.boolean;
             break;
         case value_type::map:
-            new (&mStorage.map) std::map<std::string, value>(rhs.mStorage.map);
+            new (&mStorage.map) value_map(rhs.mStorage.map);
             break;
         case value_type::binary:
             new (&mStorage.binary) std::vector<uint8_t>(rhs.mStorage.binary);
@@ -159,7 +444,7 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            new (&mStorage.array) std::vector<signalr::value>(std::move(rhs.mStorage.array));
+            new (&mStorage.array) value_array(std::move(rhs.mStorage.array));
             break;
         case value_type::string:
             new (&mStorage.string) std::string(std::move(rhs.mStorage.string));
@@ -167,11 +452,17 @@ namespace signalr
         case value_type::float64:
             mStorage.number = std::move(rhs.mStorage.number);
             break;
+        case value_type::int64:
+            mStorage.int64 = rhs.mStorage.int64;
+            break;
+        case value_type::uint64:
+            mStorage.uint64 = rhs.mStorage.uint64;
+            break;
         case value_type::boolean:
             mStorage.boolean = std::move(rhs.mStorage.boolean);
             break;
         case value_type::map:
-            new (&mStorage.map) std::map<std::string, signalr::value>(std::move(rhs.mStorage.map));
+            new (&mStorage.map) value_map(std::move(rhs.mStorage.map));
             break;
         case value_type::binary:
             new (&mStorage.binary) std::vector<uint8_t>(std::move(rhs.mStorage.binary));
@@ -192,19 +483,21 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            mStorage.array.~vector();
+            mStorage.array.~value_array();
             break;
         case value_type::string:
             mStorage.string.~basic_string();
             break;
         case value_type::map:
-            mStorage.map.~map();
+            mStorage.map.~value_map();
             break;
         case value_type::binary:
             mStorage.binary.~vector();
             break;
         case value_type::null:
         case value_type::float64:
+        case value_type::int64:
+        case value_type::uint64:
         case value_type::boolean:
         default:
             break;
@@ -219,7 +512,7 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            new (&mStorage.array) std::vector<value>(rhs.mStorage.array);
+            new (&mStorage.array) value_array(rhs.mStorage.array);
             break;
         case value_type::string:
             new (&mStorage.string) std::string(rhs.mStorage.string);
@@ -227,11 +520,17 @@ namespace signalr
         case value_type::float64:
             mStorage.number = rhs.mStorage.number;
             break;
+        case value_type::int64:
+            mStorage.int64 = rhs.mStorage.int64;
+            break;
+        case value_type::uint64:
+            mStorage.uint64 = rhs.mStorage.uint64;
+            break;
         case value_type::boolean:
             mStorage.boolean = rhs.mStorage.boolean;
             break;
         case value_type::map:
-            new (&mStorage.map) std::map<std::string, value>(rhs.mStorage.map);
+            new (&mStorage.map) value_map(rhs.mStorage.map);
             break;
         case value_type::binary:
             new (&mStorage.binary) std::vector<uint8_t>(rhs.mStorage.binary);
@@ -252,7 +551,7 @@ namespace signalr
         switch (mType)
         {
         case value_type::array:
-            new (&mStorage.array) std::vector<value>(std::move(rhs.mStorage.array));
+            new (&mStorage.array) value_array(std::move(rhs.mStorage.array));
             break;
         case value_type::string:
             new (&mStorage.string) std::string(std::move(rhs.mStorage.string));
@@ -260,11 +559,17 @@ namespace signalr
         case value_type::float64:
             mStorage.number = std::move(rhs.mStorage.number);
             break;
+        case value_type::int64:
+            mStorage.int64 = rhs.mStorage.int64;
+            break;
+        case value_type::uint64:
+            mStorage.uint64 = rhs.mStorage.uint64;
+            break;
         case value_type::boolean:
             mStorage.boolean = std::move(rhs.mStorage.boolean);
             break;
         case value_type::map:
-            new (&mStorage.map) std::map<std::string, value>(std::move(rhs.mStorage.map));
+            new (&mStorage.map) value_map(std::move(rhs.mStorage.map));
             break;
         case value_type::binary:
             new (&mStorage.binary) std::vector<uint8_t>(std::move(rhs.mStorage.binary));
@@ -287,6 +592,22 @@ namespace signalr
         return mType == signalr::value_type::float64;
     }
 
+    bool value::is_number() const
+    {
+        return mType == signalr::value_type::float64 || mType == signalr::value_type::int64 ||
+            mType == signalr::value_type::uint64;
+    }
+
+    bool value::is_int64() const
+    {
+        return mType == signalr::value_type::int64;
+    }
+
+    bool value::is_uint64() const
+    {
+        return mType == signalr::value_type::uint64;
+    }
+
     bool value::is_string() const
     {
         return mType == signalr::value_type::string;
@@ -314,12 +635,45 @@ namespace signalr
 
     double value::as_double() const
     {
-        if (!is_double())
+        switch (mType)
         {
-            throw signalr_exception("object is a '" + value_type_to_string(mType) + "' expected it to be a 'float64'");
+        case value_type::float64:
+            return mStorage.number;
+        case value_type::int64:
+            return static_cast<double>(mStorage.int64);
+        case value_type::uint64:
+            return static_cast<double>(mStorage.uint64);
+        default:
+            throw signalr_exception("object is a '" + value_type_to_string(mType) + "' expected it to be a number");
         }
+    }
 
-        return mStorage.number;
+    int64_t value::as_int64() const
+    {
+        if (is_int64())
+        {
+            return mStorage.int64;
+        }
+        if (is_uint64() && mStorage.uint64 <= static_cast<uint64_t>(INT64_MAX))
+        {
+            return static_cast<int64_t>(mStorage.uint64);
+        }
+
+        throw signalr_exception("object is a '" + value_type_to_string(mType) + "' expected it to be a 'int64'");
+    }
+
+    uint64_t value::as_uint64() const
+    {
+        if (is_uint64())
+        {
+            return mStorage.uint64;
+        }
+        if (is_int64() && mStorage.int64 >= 0)
+        {
+            return static_cast<uint64_t>(mStorage.int64);
+        }
+
+        throw signalr_exception("object is a '" + value_type_to_string(mType) + "' expected it to be a 'uint64'");
     }
 
     bool value::as_bool() const
@@ -343,6 +697,16 @@ namespace signalr
     }
 
     const std::vector<value>& value::as_array() const
+    {
+        return as_value_array().std_vector();
+    }
+
+    const std::map<std::string, value>& value::as_map() const
+    {
+        return as_value_map().std_map();
+    }
+
+    const value_array& value::as_value_array() const
     {
         if (!is_array())
         {
@@ -352,7 +716,7 @@ namespace signalr
         return mStorage.array;
     }
 
-    const std::map<std::string, value>& value::as_map() const
+    const value_map& value::as_value_map() const
     {
         if (!is_map())
         {
@@ -0,0 +1,125 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include <assert.h>
+#include "strand.h"
+
+namespace signalr
+{
+    namespace
+    {
+        // callbacks run per trip through the scheduler, bounds how long one busy strand can hold on to a worker
+        const int max_callbacks_per_drain = 32;
+    }
+
+    std::shared_ptr<strand> strand::create(std::shared_ptr<scheduler> scheduler)
+    {
+        return std::shared_ptr<strand>(new strand(std::move(scheduler)));
+    }
+
+    strand::strand(std::shared_ptr<scheduler> scheduler)
+        : m_scheduler(std::move(scheduler)), m_task_scheduler(dynamic_cast<task_scheduler*>(m_scheduler.get())),
+        m_clock(find_clock(*m_scheduler)), m_running(false)
+    {
+        assert(m_scheduler);
+    }
+
+    void strand::schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay)
+    {
+        schedule_task(task(cb), delay);
+    }
+
+    void strand::schedule_task(task&& t, std::chrono::milliseconds delay)
+    {
+        if (delay <= std::chrono::milliseconds::zero())
+        {
+            post(std::move(t));
+            return;
+        }
+
+        // the underlying scheduler handles the delay, the callback only joins the queue once it is due. The strand and the
+        // task together don't fit in a task's inline storage so this allocates, unlike the undelayed path.
+        signalr::schedule_task(*m_scheduler, m_task_scheduler, task(std::bind([](const std::shared_ptr<strand>& self, task& t)
+            {
+                self->post(std::move(t));
+            }, shared_from_this(), std::move(t))), delay);
+    }
+
+    std::chrono::steady_clock::time_point strand::now() const
+    {
+        return clock_now(m_clock);
+    }
+
+    void strand::post(task&& t)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_callbacks.push_back(std::move(t));
+            if (m_running)
+            {
+                // whoever is running will get to it
+                return;
+            }
+            m_running = true;
+        } // unlock
+
+        schedule_drain();
+    }
+
+    void strand::drain()
+    {
+        for (int i = 0; i < max_callbacks_per_drain; ++i)
+        {
+            task cb;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_callbacks.empty())
+                {
+                    m_running = false;
+                    return;
+                }
+
+                cb = m_callbacks.pop_front();
+            } // unlock
+
+            try
+            {
+                cb();
+            }
+            catch (...)
+            {
+                // ignore exceptions?
+                assert(false);
+            }
+        }
+
+        // give other work on the scheduler a turn, m_running stays set so the order of the remaining callbacks is kept
+        schedule_drain();
+    }
+
+    void strand::release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_callbacks.empty())
+            {
+                m_running = false;
+                return;
+            }
+        } // unlock
+
+        schedule_drain();
+    }
+
+    void strand::schedule_drain()
+    {
+        // a shared_ptr fits a task's inline storage, so this doesn't allocate when the scheduler takes tasks
+        auto self = shared_from_this();
+        signalr::schedule_task(*m_scheduler, m_task_scheduler, task([self]()
+            {
+                self->drain();
+            }));
+    }
+}
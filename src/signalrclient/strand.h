@@ -0,0 +1,79 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include "ring_queue.h"
+#include "task.h"
+#include "scheduler_clock.h"
+#include <memory>
+#include <mutex>
+
+namespace signalr
+{
+    // Runs callbacks one at a time and in the order they were queued, on top of any scheduler. Many strands can share one
+    // scheduler, which lets every connection keep its callbacks ordered without needing threads of its own.
+    //
+    // Note:
+    // Factory methods and private constructors prevent from using this class incorrectly. Because this class
+    // derives from `std::enable_shared_from_this` the instance has to be owned by a `std::shared_ptr` whenever
+    // a member method calls `std::shared_from_this()` otherwise the behavior is undefined.
+    class strand : public scheduler, public task_scheduler, public clock_source, public std::enable_shared_from_this<strand>
+    {
+    public:
+        static std::shared_ptr<strand> create(std::shared_ptr<scheduler> scheduler);
+
+        strand(const strand&) = delete;
+        strand& operator=(const strand&) = delete;
+
+        // queues the callback, delayed callbacks are queued once the delay has elapsed
+        void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override;
+        void schedule_task(task&& t, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override;
+        // the underlying scheduler's clock
+        std::chrono::steady_clock::time_point now() const override;
+
+        // runs the callback on the calling thread if nothing else is running on the strand, otherwise queues it behind the
+        // callback that is running. Callbacks queued while it runs are handed to the scheduler so the caller isn't held up.
+        template <typename Callback>
+        void dispatch(Callback&& cb)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_running)
+                {
+                    m_callbacks.push_back(task(std::forward<Callback>(cb)));
+                    return;
+                }
+                m_running = true;
+            } // unlock
+
+            struct release_on_exit
+            {
+                strand* m_strand;
+                ~release_on_exit() { m_strand->release(); }
+            } release{ this };
+
+            cb();
+        }
+
+    private:
+        explicit strand(std::shared_ptr<scheduler> scheduler);
+
+        std::shared_ptr<scheduler> m_scheduler;
+        // null if the scheduler only takes std::function callbacks
+        task_scheduler* m_task_scheduler;
+        // null if the scheduler uses the steady clock
+        const clock_source* m_clock;
+        std::mutex m_lock;
+        ring_queue<task> m_callbacks;
+        // true while a callback is running or a drain is scheduled, only one thread runs callbacks at a time
+        bool m_running;
+
+        void post(task&& t);
+        void drain();
+        void schedule_drain();
+        void release();
+    };
+}
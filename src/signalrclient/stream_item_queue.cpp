@@ -0,0 +1,195 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "stream_item_queue.h"
+
+namespace signalr
+{
+    std::shared_ptr<stream_item_queue> stream_item_queue::create(std::shared_ptr<scheduler> scheduler, size_t capacity,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete,
+        std::function<void(bool)> full_changed)
+    {
+        return std::shared_ptr<stream_item_queue>(new stream_item_queue(std::move(scheduler), capacity, std::move(on_item),
+            std::move(on_complete), std::move(full_changed)));
+    }
+
+    stream_item_queue::stream_item_queue(std::shared_ptr<scheduler> scheduler, size_t capacity,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete,
+        std::function<void(bool)> full_changed)
+        : m_scheduler(std::move(scheduler)), m_capacity(capacity), m_on_item(std::move(on_item)), m_on_complete(std::move(on_complete)),
+        m_full_changed(std::move(full_changed)), m_full(false), m_delivering(false), m_completed(false)
+    {
+        assert(m_capacity != 0);
+    }
+
+    void stream_item_queue::push(signalr::value&& item)
+    {
+        bool full = false;
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_completed)
+            {
+                return;
+            }
+
+            m_items.push_back(std::move(item));
+            if (!m_full && m_items.size() >= m_capacity)
+            {
+                m_full = true;
+                full = true;
+            }
+            schedule = start_delivering();
+        }
+
+        if (full)
+        {
+            m_full_changed(true);
+        }
+        if (schedule)
+        {
+            schedule_deliver();
+        }
+    }
+
+    void stream_item_queue::complete(std::exception_ptr error)
+    {
+        bool room = false;
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_completed)
+            {
+                return;
+            }
+
+            m_completed = true;
+            m_error = error;
+            // nothing else will be pushed, the queued items don't need to hold the connection back
+            room = m_full;
+            m_full = false;
+            schedule = start_delivering();
+        }
+
+        if (room)
+        {
+            m_full_changed(false);
+        }
+        if (schedule)
+        {
+            schedule_deliver();
+        }
+    }
+
+    void stream_item_queue::cancel(std::exception_ptr error)
+    {
+        ring_queue<signalr::value> dropped;
+        bool room = false;
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_completed)
+            {
+                return;
+            }
+
+            m_completed = true;
+            m_error = error;
+            std::swap(dropped, m_items);
+            room = m_full;
+            m_full = false;
+            schedule = start_delivering();
+        }
+
+        if (room)
+        {
+            m_full_changed(false);
+        }
+        if (schedule)
+        {
+            schedule_deliver();
+        }
+    }
+
+    bool stream_item_queue::start_delivering()
+    {
+        if (m_delivering)
+        {
+            return false;
+        }
+
+        m_delivering = true;
+        return true;
+    }
+
+    void stream_item_queue::schedule_deliver()
+    {
+        auto queue = shared_from_this();
+        m_scheduler->schedule([queue]()
+            {
+                queue->deliver();
+            });
+    }
+
+    void stream_item_queue::deliver()
+    {
+        std::function<void(std::exception_ptr)> on_complete;
+        std::exception_ptr error;
+
+        for (size_t delivered = 0; ; ++delivered)
+        {
+            signalr::value item;
+            bool room = false;
+            bool yield = false;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_items.empty())
+                {
+                    m_delivering = false;
+                    if (!m_completed)
+                    {
+                        return;
+                    }
+
+                    // nothing can start delivering again once the stream completed, so this is the only time we get here
+                    on_complete = std::move(m_on_complete);
+                    error = m_error;
+                    m_on_item = nullptr;
+                    break;
+                }
+
+                if (delivered == m_capacity)
+                {
+                    yield = true;
+                }
+                else
+                {
+                    item = m_items.pop_front();
+                    if (m_full && m_items.size() <= m_capacity / 2)
+                    {
+                        m_full = false;
+                        room = true;
+                    }
+                }
+            }
+
+            if (yield)
+            {
+                // give other work on the scheduler a turn, m_delivering stays set so the order of the items is kept
+                schedule_deliver();
+                return;
+            }
+
+            if (room)
+            {
+                m_full_changed(false);
+            }
+
+            m_on_item(item);
+        }
+
+        on_complete(error);
+    }
+}
@@ -0,0 +1,69 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/scheduler.h"
+#include "signalrclient/signalr_value.h"
+#include "ring_queue.h"
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace signalr
+{
+    // Holds the items of a stream the server sends until the user's item callback takes them, the callbacks run on the
+    // scheduler one at a time and in order so a slow callback doesn't hold up the connection's other messages. The queue
+    // reports when it gets full so the connection can stop receiving, and when it is back to half full so it can resume.
+    //
+    // Note:
+    // Factory methods and private constructors prevent from using this class incorrectly. Because this class
+    // derives from `std::enable_shared_from_this` the instance has to be owned by a `std::shared_ptr` whenever
+    // a member method calls `std::shared_from_this()` otherwise the behavior is undefined.
+    class stream_item_queue : public std::enable_shared_from_this<stream_item_queue>
+    {
+    public:
+        // full_changed is called with true once the queue holds capacity items and with false once it holds half of that,
+        // or once the stream completed since no more items will come. It is called outside of the queue's lock, the calls
+        // for one queue always pair up but the one reporting room may be made before the one reporting it full.
+        static std::shared_ptr<stream_item_queue> create(std::shared_ptr<scheduler> scheduler, size_t capacity,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete,
+            std::function<void(bool)> full_changed);
+
+        stream_item_queue(const stream_item_queue&) = delete;
+        stream_item_queue& operator=(const stream_item_queue&) = delete;
+
+        // items pushed after the stream completed are dropped
+        void push(signalr::value&& item);
+        // on_complete is called with the error, nullptr if the stream completed successfully, after the queued items
+        void complete(std::exception_ptr error);
+        // drops the queued items, on_complete is called with the error once an item callback that is running returns
+        void cancel(std::exception_ptr error);
+
+    private:
+        stream_item_queue(std::shared_ptr<scheduler> scheduler, size_t capacity,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete,
+            std::function<void(bool)> full_changed);
+
+        std::shared_ptr<scheduler> m_scheduler;
+        const size_t m_capacity;
+        std::function<void(const signalr::value&)> m_on_item;
+        std::function<void(std::exception_ptr)> m_on_complete;
+        std::function<void(bool)> m_full_changed;
+
+        std::mutex m_lock;
+        ring_queue<signalr::value> m_items;
+        bool m_full;
+        // deliver is scheduled or running, it keeps going until the queue is empty
+        bool m_delivering;
+        bool m_completed;
+        std::exception_ptr m_error;
+
+        // called with the lock held, returns true if the caller has to schedule deliver
+        bool start_delivering();
+        void schedule_deliver();
+        void deliver();
+    };
+}
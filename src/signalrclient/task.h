@@ -0,0 +1,217 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace signalr
+{
+    // A move-only replacement for signalr_base_cb on the scheduler's internal paths. Callables of up to inline_capacity
+    // bytes are stored inline, which covers the lambdas the library schedules (a few shared_ptrs and a value or two) where
+    // std::function would allocate as soon as one shared_ptr is captured. Being move-only the callable is never copied
+    // on its way through the queues.
+    class task
+    {
+    public:
+        static constexpr size_t inline_capacity = 64;
+
+        task() noexcept
+            : m_invoke(nullptr), m_manage(nullptr)
+        { }
+
+        template <typename Callable, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<Callable>::type, task>::value &&
+            !std::is_same<typename std::decay<Callable>::type, signalr_base_cb>::value>::type>
+        task(Callable&& callable)
+            : m_invoke(nullptr), m_manage(nullptr)
+        {
+            construct<typename std::decay<Callable>::type>(std::forward<Callable>(callable));
+        }
+
+        // an empty std::function makes an empty task rather than one that throws when invoked
+        task(const signalr_base_cb& callback)
+            : m_invoke(nullptr), m_manage(nullptr)
+        {
+            if (callback)
+            {
+                construct<signalr_base_cb>(callback);
+            }
+        }
+
+        task(signalr_base_cb&& callback)
+            : m_invoke(nullptr), m_manage(nullptr)
+        {
+            if (callback)
+            {
+                construct<signalr_base_cb>(std::move(callback));
+            }
+        }
+
+        task(task&& other) noexcept
+            : m_invoke(nullptr), m_manage(nullptr)
+        {
+            move_from(other);
+        }
+
+        task& operator=(task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                move_from(other);
+            }
+            return *this;
+        }
+
+        task(const task&) = delete;
+        task& operator=(const task&) = delete;
+
+        ~task()
+        {
+            reset();
+        }
+
+        void operator()()
+        {
+            m_invoke(*this);
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_invoke != nullptr;
+        }
+
+        void reset() noexcept
+        {
+            if (m_manage != nullptr)
+            {
+                m_manage(operation::destroy, *this, nullptr);
+            }
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+
+    private:
+        enum class operation
+        {
+            move,
+            destroy
+        };
+
+        typedef typename std::aligned_storage<inline_capacity, alignof(std::max_align_t)>::type storage;
+
+        storage m_storage;
+        void (*m_invoke)(task&);
+        // moves the callable from other into self, or destroys self's callable
+        void (*m_manage)(operation, task& self, task* other);
+
+        template <typename Callable>
+        struct stored_inline : std::integral_constant<bool,
+            sizeof(Callable) <= inline_capacity &&
+            alignof(Callable) <= alignof(storage) &&
+            std::is_nothrow_move_constructible<Callable>::value>
+        { };
+
+        template <typename Callable, typename Argument>
+        void construct(Argument&& argument)
+        {
+            construct<Callable>(std::forward<Argument>(argument), stored_inline<Callable>());
+        }
+
+        template <typename Callable, typename Argument>
+        void construct(Argument&& argument, std::true_type)
+        {
+            new (&m_storage) Callable(std::forward<Argument>(argument));
+            m_invoke = [](task& self)
+            {
+                (*reinterpret_cast<Callable*>(&self.m_storage))();
+            };
+            m_manage = [](operation op, task& self, task* other)
+            {
+                auto callable = reinterpret_cast<Callable*>(&self.m_storage);
+                if (op == operation::move)
+                {
+                    auto source = reinterpret_cast<Callable*>(&other->m_storage);
+                    new (callable) Callable(std::move(*source));
+                    source->~Callable();
+                }
+                else
+                {
+                    callable->~Callable();
+                }
+            };
+        }
+
+        // too big for the inline storage, only a pointer is stored so moving the task doesn't touch the callable
+        template <typename Callable, typename Argument>
+        void construct(Argument&& argument, std::false_type)
+        {
+            new (&m_storage) Callable*(new Callable(std::forward<Argument>(argument)));
+            m_invoke = [](task& self)
+            {
+                (**reinterpret_cast<Callable**>(&self.m_storage))();
+            };
+            m_manage = [](operation op, task& self, task* other)
+            {
+                if (op == operation::move)
+                {
+                    new (&self.m_storage) Callable*(*reinterpret_cast<Callable**>(&other->m_storage));
+                }
+                else
+                {
+                    delete *reinterpret_cast<Callable**>(&self.m_storage);
+                }
+            };
+        }
+
+        void move_from(task& other) noexcept
+        {
+            if (other.m_manage == nullptr)
+            {
+                return;
+            }
+
+            other.m_manage(operation::move, *this, &other);
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+    };
+
+    // Implemented by the library's schedulers so internal callers can hand them a task without it being wrapped in a
+    // std::function first.
+    struct task_scheduler
+    {
+        virtual void schedule_task(task&& t, std::chrono::milliseconds delay) = 0;
+
+        virtual ~task_scheduler() {}
+    };
+
+    // target_tasks is target's task_scheduler interface, or null when target is a scheduler that doesn't implement it (for
+    // example one provided by the user) in which case the task is wrapped in a std::function
+    inline void schedule_task(scheduler& target, task_scheduler* target_tasks, task&& t,
+        std::chrono::milliseconds delay = std::chrono::milliseconds::zero())
+    {
+        if (target_tasks != nullptr)
+        {
+            target_tasks->schedule_task(std::move(t), delay);
+            return;
+        }
+
+        // std::function needs a copyable callable
+        auto shared_task = std::make_shared<task>(std::move(t));
+        target.schedule([shared_task]()
+            {
+                (*shared_task)();
+            }, delay);
+    }
+}
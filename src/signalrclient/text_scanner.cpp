@@ -0,0 +1,278 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "text_scanner.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIGNALR_TEXT_SCANNER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SIGNALR_TEXT_SCANNER_X86) && (defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+// SSE2 is part of x64 and the compiler was told it can use it on x86 so there is nothing to detect at runtime
+#define SIGNALR_TEXT_SCANNER_SSE2
+#endif
+
+#if defined(SIGNALR_TEXT_SCANNER_X86) && (defined(_MSC_VER) || defined(__GNUC__))
+#define SIGNALR_TEXT_SCANNER_AVX2
+#ifdef _MSC_VER
+#define SIGNALR_TARGET_AVX2
+#else
+// only the AVX2 functions are compiled for AVX2, they are only called once the CPU was found to support it
+#define SIGNALR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace signalr
+{
+    namespace
+    {
+        const size_t invalid = SIZE_MAX;
+
+        bool is_continuation(unsigned char c)
+        {
+            return (c & 0xC0) == 0x80;
+        }
+
+        // The length of the UTF-8 sequence starting with a byte that isn't ASCII, 0 if it isn't a valid one: overlong
+        // encodings, surrogates, code points above U+10FFFF, stray continuation bytes and truncated sequences are invalid.
+        size_t sequence_length(const unsigned char* text, size_t available)
+        {
+            auto lead = text[0];
+            if (lead < 0xC2 || lead > 0xF4)
+            {
+                return 0;
+            }
+
+            if (lead < 0xE0)
+            {
+                return available >= 2 && is_continuation(text[1]) ? 2 : 0;
+            }
+
+            if (lead < 0xF0)
+            {
+                unsigned char lower = lead == 0xE0 ? 0xA0 : 0x80;
+                unsigned char upper = lead == 0xED ? 0x9F : 0xBF;
+                return available >= 3 && text[1] >= lower && text[1] <= upper && is_continuation(text[2]) ? 3 : 0;
+            }
+
+            unsigned char lower = lead == 0xF0 ? 0x90 : 0x80;
+            unsigned char upper = lead == 0xF4 ? 0x8F : 0xBF;
+            return available >= 4 && text[1] >= lower && text[1] <= upper && is_continuation(text[2]) && is_continuation(text[3]) ? 4 : 0;
+        }
+
+        // Scans one character at a time from position until it reaches stop, the last character may end after stop.
+        // Returns where it stopped or invalid.
+        size_t scan_characters(const unsigned char* text, size_t length, size_t position, size_t stop, unsigned char separator,
+            std::vector<size_t>& separators)
+        {
+            while (position < stop)
+            {
+                auto c = text[position];
+                if (c < 0x80)
+                {
+                    if (c == separator)
+                    {
+                        separators.push_back(position);
+                    }
+                    ++position;
+                    continue;
+                }
+
+                auto sequence = sequence_length(text + position, length - position);
+                if (sequence == 0)
+                {
+                    return invalid;
+                }
+                position += sequence;
+            }
+
+            return position;
+        }
+
+        unsigned int count_trailing_zeros(uint32_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return index;
+#else
+            return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+        }
+
+        // bit i of the mask is set if byte i of the block is a separator
+        void append_separators(size_t block_start, uint32_t mask, std::vector<size_t>& separators)
+        {
+            while (mask != 0)
+            {
+                separators.push_back(block_start + count_trailing_zeros(mask));
+                mask &= mask - 1;
+            }
+        }
+
+#ifdef SIGNALR_TEXT_SCANNER_SSE2
+        bool scan_sse2(const char* text, size_t length, char separator, std::vector<size_t>& separators)
+        {
+            auto bytes = reinterpret_cast<const unsigned char*>(text);
+            const auto separator_block = _mm_set1_epi8(separator);
+
+            size_t position = 0;
+            while (length - position >= 16)
+            {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + position));
+                // the high bit of every byte that isn't ASCII
+                if (_mm_movemask_epi8(block) == 0)
+                {
+                    append_separators(position, static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, separator_block))), separators);
+                    position += 16;
+                    continue;
+                }
+
+                position = scan_characters(bytes, length, position, position + 16, static_cast<unsigned char>(separator), separators);
+                if (position == invalid)
+                {
+                    return false;
+                }
+            }
+
+            return scan_characters(bytes, length, position, length, static_cast<unsigned char>(separator), separators) != invalid;
+        }
+#endif
+
+#ifdef SIGNALR_TEXT_SCANNER_AVX2
+        SIGNALR_TARGET_AVX2
+        bool scan_avx2(const char* text, size_t length, char separator, std::vector<size_t>& separators)
+        {
+            auto bytes = reinterpret_cast<const unsigned char*>(text);
+            const auto separator_block = _mm256_set1_epi8(separator);
+
+            size_t position = 0;
+            while (length - position >= 32)
+            {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + position));
+                if (_mm256_movemask_epi8(block) == 0)
+                {
+                    append_separators(position, static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, separator_block))), separators);
+                    position += 32;
+                    continue;
+                }
+
+                position = scan_characters(bytes, length, position, position + 32, static_cast<unsigned char>(separator), separators);
+                if (position == invalid)
+                {
+                    return false;
+                }
+            }
+
+            return scan_characters(bytes, length, position, length, static_cast<unsigned char>(separator), separators) != invalid;
+        }
+
+        bool cpu_supports_avx2()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+            {
+                return false;
+            }
+
+            // the OS has to save the AVX registers on context switches too
+            __cpuid(info, 1);
+            const int osxsave_and_avx = (1 << 27) | (1 << 28);
+            if ((info[2] & osxsave_and_avx) != osxsave_and_avx || (_xgetbv(0) & 0x6) != 0x6)
+            {
+                return false;
+            }
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }
+#endif
+
+        text_scanner::scan_function fastest_scan()
+        {
+            if (text_scanner::avx2() != nullptr)
+            {
+                return text_scanner::avx2();
+            }
+            if (text_scanner::sse2() != nullptr)
+            {
+                return text_scanner::sse2();
+            }
+            return &text_scanner::scan_portable;
+        }
+    }
+
+    bool text_scanner::scan(const char* text, size_t length, char separator, std::vector<size_t>& separators)
+    {
+        static const scan_function scan = fastest_scan();
+        return scan(text, length, separator, separators);
+    }
+
+    bool text_scanner::scan_portable(const char* text, size_t length, char separator, std::vector<size_t>& separators)
+    {
+        auto bytes = reinterpret_cast<const unsigned char*>(text);
+        const uint64_t ones = 0x0101010101010101ull;
+        const uint64_t high_bits = 0x8080808080808080ull;
+        const uint64_t separator_word = ones * static_cast<unsigned char>(separator);
+
+        size_t position = 0;
+        while (length - position >= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + position, sizeof(word));
+
+            if ((word & high_bits) == 0)
+            {
+                // a byte of the xor is zero where the word has the separator, subtracting one from it borrows into its high
+                // bit, which can't happen otherwise since all the high bits are clear
+                auto matches = word ^ separator_word;
+                if (((matches - ones) & ~matches & high_bits) == 0)
+                {
+                    position += 8;
+                    continue;
+                }
+            }
+
+            position = scan_characters(bytes, length, position, position + 8, static_cast<unsigned char>(separator), separators);
+            if (position == invalid)
+            {
+                return false;
+            }
+        }
+
+        return scan_characters(bytes, length, position, length, static_cast<unsigned char>(separator), separators) != invalid;
+    }
+
+    text_scanner::scan_function text_scanner::sse2()
+    {
+#ifdef SIGNALR_TEXT_SCANNER_SSE2
+        return &scan_sse2;
+#else
+        return nullptr;
+#endif
+    }
+
+    text_scanner::scan_function text_scanner::avx2()
+    {
+#ifdef SIGNALR_TEXT_SCANNER_AVX2
+        static const bool supported = cpu_supports_avx2();
+        return supported ? &scan_avx2 : nullptr;
+#else
+        return nullptr;
+#endif
+    }
+}
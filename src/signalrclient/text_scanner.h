@@ -0,0 +1,32 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace signalr
+{
+    // Finds the record separators in a text frame and checks that the frame is valid UTF-8 in the same pass. Blocks of
+    // ASCII, which is what JSON mostly is, are scanned 16 or 32 bytes at a time with SSE2 or AVX2 depending on what the
+    // CPU supports, blocks with other characters are validated one character at a time.
+    class text_scanner
+    {
+    public:
+        // appends the offset of every separator to separators, returns false if the text isn't valid UTF-8 in which case
+        // separators may have been appended up to where the text stopped being valid
+        typedef bool (*scan_function)(const char* text, size_t length, char separator, std::vector<size_t>& separators);
+
+        // the fastest implementation available on this machine
+        static bool scan(const char* text, size_t length, char separator, std::vector<size_t>& separators);
+
+        // reads 8 bytes at a time with plain integer operations, works everywhere
+        static bool scan_portable(const char* text, size_t length, char separator, std::vector<size_t>& separators);
+
+        // nullptr if the build doesn't target x86 or the CPU doesn't support the instructions
+        static scan_function sse2();
+        static scan_function avx2();
+    };
+}
@@ -0,0 +1,376 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include <assert.h>
+#include <algorithm>
+#include "thread_pool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace signalr
+{
+    namespace
+    {
+        // lets submit() find the queue of the worker it is being called from
+        thread_local const thread_pool* t_current_pool = nullptr;
+        thread_local size_t t_current_worker = 0;
+
+        // callbacks are allowed to block waiting on other callbacks, so don't go below the worker count the scheduler
+        // always had even on machines with few cores
+        const size_t minimum_default_thread_count = 5;
+
+        void configure_current_thread(size_t index, const thread_pool_options& options)
+        {
+#if defined(__linux__)
+            if (!options.thread_name.empty())
+            {
+                // Linux limits thread names to 15 characters
+                auto name = options.thread_name + "-" + std::to_string(index);
+                name.resize(std::min(name.size(), (size_t)15));
+                pthread_setname_np(pthread_self(), name.c_str());
+            }
+
+            if (!options.cpu_affinity.empty())
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(options.cpu_affinity[index % options.cpu_affinity.size()], &cpus);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+            }
+#else
+            (void)index;
+            (void)options;
+#endif
+        }
+    }
+
+    thread_pool::thread_pool(const thread_pool_options& options)
+        : m_options(options), m_pending(0), m_sleeping(0), m_next_worker(0), m_active(0), m_starting(0), m_stopping(false),
+        m_joined(false), m_metrics_enabled(false), m_peak_pending(0)
+    {
+        if (m_options.thread_count == 0)
+        {
+            m_options.thread_count = std::max((size_t)std::thread::hardware_concurrency(), minimum_default_thread_count);
+        }
+        m_options.min_thread_count = std::min(m_options.min_thread_count, m_options.thread_count);
+
+        // every slot exists up front since workers steal from each other, only the threads are started on demand
+        m_workers.reserve(m_options.thread_count);
+        for (size_t i = 0; i < m_options.thread_count; ++i)
+        {
+            m_workers.push_back(std::unique_ptr<worker>(new worker()));
+        }
+
+        std::lock_guard<std::mutex> lock(m_idle_lock);
+        for (size_t i = 0; i < m_options.min_thread_count; ++i)
+        {
+            start_worker();
+        }
+    }
+
+    thread_pool::~thread_pool()
+    {
+        shutdown();
+    }
+
+    void thread_pool::submit(task&& t)
+    {
+        size_t index;
+        if (t_current_pool == this)
+        {
+            // keep work that a callback produces on the same worker, idle workers will steal it if this one stays busy
+            index = t_current_worker;
+        }
+        else
+        {
+            // the worker may exit before the callback is queued, it is then stolen by another worker
+            index = m_next_worker++ % std::max(m_active.load(), (size_t)1);
+        }
+
+        work_item next{ std::move(t), std::chrono::steady_clock::time_point() };
+        auto metrics_enabled = m_metrics_enabled.load(std::memory_order_relaxed);
+        if (metrics_enabled)
+        {
+            next.enqueued = std::chrono::steady_clock::now();
+        }
+
+        size_t pending;
+        {
+            auto& worker = *m_workers[index];
+            std::lock_guard<std::mutex> lock(worker.m_lock);
+            worker.m_callbacks.push_back(std::move(next));
+            pending = ++m_pending;
+        } // unlock
+
+        if (metrics_enabled)
+        {
+            auto peak = m_peak_pending.load(std::memory_order_relaxed);
+            while (pending > peak && !m_peak_pending.compare_exchange_weak(peak, pending, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // a worker increments m_sleeping before checking m_pending, and lowers m_active before its last check when it exits,
+        // so either it sees the callback or we see it sleeping or gone and grow() replaces it
+        if (m_sleeping.load() != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_idle_lock);
+            } // unlock
+            m_idle_cv.notify_one();
+        }
+        else
+        {
+            // every worker is busy, or there are none
+            grow();
+        }
+    }
+
+    void thread_pool::grow()
+    {
+        if (m_starting.load() != 0 || m_active.load() == m_workers.size())
+        {
+            // a worker that is starting will pick the callback up, and there is no room for another one
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_idle_lock);
+        if (m_stopping || m_starting.load() != 0 || m_active.load() == m_workers.size() || m_pending.load() == 0)
+        {
+            return;
+        }
+
+        if (m_sleeping.load() != 0)
+        {
+            // a worker went to sleep after the callback was picked up and something else was queued since
+            m_idle_cv.notify_one();
+            return;
+        }
+
+        start_worker();
+    }
+
+    void thread_pool::start_worker()
+    {
+        auto index = m_active.load();
+        auto& slot = *m_workers[index];
+        if (slot.m_thread.joinable())
+        {
+            // the worker that had this slot before has exited, or is about to since it released m_idle_lock
+            slot.m_thread.join();
+        }
+
+        ++m_active;
+        ++m_starting;
+        try
+        {
+            slot.m_thread = std::thread(&thread_pool::run_worker, this, index);
+        }
+        catch (...)
+        {
+            --m_active;
+            --m_starting;
+            if (m_active.load() == 0)
+            {
+                throw;
+            }
+            // the workers that are running will get to the callbacks
+        }
+    }
+
+    void thread_pool::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_idle_lock);
+            if (m_joined)
+            {
+                return;
+            }
+            m_stopping = true;
+            m_joined = true;
+        } // unlock
+        m_idle_cv.notify_all();
+
+        // no workers are started once m_stopping is set, and the ones that exited on their own are joined here too
+        for (auto& worker : m_workers)
+        {
+            if (worker->m_thread.joinable())
+            {
+                assert(worker->m_thread.get_id() != std::this_thread::get_id());
+                worker->m_thread.join();
+            }
+        }
+
+        // callbacks submitted after the last worker exited have nobody else to run them, they can submit more callbacks
+        // which are queued and run here as well
+        bool ran = true;
+        while (ran)
+        {
+            ran = false;
+            for (size_t i = 0; i < m_workers.size(); ++i)
+            {
+                while (true)
+                {
+                    work_item next;
+                    if (!try_pop(i, next))
+                    {
+                        break;
+                    }
+                    run_task(*m_workers[i], next);
+                    ran = true;
+                }
+            }
+        }
+    }
+
+    size_t thread_pool::thread_count() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    size_t thread_pool::active_thread_count() const noexcept
+    {
+        return m_active.load();
+    }
+
+    void thread_pool::enable_metrics() noexcept
+    {
+        m_metrics_enabled.store(true);
+    }
+
+    bool thread_pool::metrics_enabled() const noexcept
+    {
+        return m_metrics_enabled.load(std::memory_order_relaxed);
+    }
+
+    void thread_pool::collect_metrics(scheduler_metrics& metrics) const
+    {
+        m_dispatch_latency.snapshot(metrics.dispatch_latency);
+        metrics.queue_depth = m_pending.load(std::memory_order_relaxed);
+        metrics.peak_queue_depth = std::max(m_peak_pending.load(std::memory_order_relaxed), metrics.queue_depth);
+
+        metrics.worker_busy_time.clear();
+        metrics.worker_busy_time.reserve(m_workers.size());
+        for (auto& worker : m_workers)
+        {
+            metrics.worker_busy_time.push_back(std::chrono::microseconds(worker->m_busy_us.load(std::memory_order_relaxed)));
+        }
+    }
+
+    void thread_pool::run_worker(size_t index)
+    {
+        configure_current_thread(index, m_options);
+        t_current_pool = this;
+        t_current_worker = index;
+        --m_starting;
+
+        while (true)
+        {
+            {
+                work_item next;
+                if (try_pop(index, next) || try_steal(index, next))
+                {
+                    if (m_pending.load() != 0 && m_sleeping.load() == 0)
+                    {
+                        // callbacks are allowed to block on each other, so don't leave the rest queued behind this one
+                        // just because they were submitted while another worker was starting
+                        grow();
+                    }
+                    run_task(*m_workers[index], next);
+                    continue;
+                }
+            } // destruct cb before sleeping, it's possible a shared_ptr is being held by the lambda/function and on destruction it could schedule work
+
+            std::unique_lock<std::mutex> lock(m_idle_lock);
+            ++m_sleeping;
+            auto woken = m_idle_cv.wait_for(lock, m_options.idle_timeout, [this]
+                {
+                    return m_pending.load() != 0 || m_stopping;
+                });
+            --m_sleeping;
+
+            if (m_stopping && m_pending.load() == 0)
+            {
+                return;
+            }
+
+            // only the worker in the last running slot exits so the running workers stay in [0, m_active), the others go
+            // back to sleep and get their turn once the workers above them have exited
+            if (!woken && index + 1 == m_active.load() && m_active.load() > m_options.min_thread_count)
+            {
+                // lower m_active before the last look at m_pending, a submit that queues a callback after that look sees
+                // this worker neither sleeping nor active and starts a new one
+                --m_active;
+                if (m_pending.load() == 0)
+                {
+                    return;
+                }
+                ++m_active;
+            }
+        }
+    }
+
+    void thread_pool::run_task(worker& current, work_item& next)
+    {
+        // a callback queued before metrics were enabled has no enqueue time and isn't measured
+        auto measure = next.enqueued != std::chrono::steady_clock::time_point();
+        std::chrono::steady_clock::time_point started;
+        if (measure)
+        {
+            started = std::chrono::steady_clock::now();
+            m_dispatch_latency.record(started - next.enqueued);
+        }
+
+        try
+        {
+            next.callback();
+        }
+        catch (...)
+        {
+            // ignore exceptions?
+            assert(false);
+        }
+
+        if (measure)
+        {
+            auto busy = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+            current.m_busy_us.fetch_add(static_cast<uint64_t>(busy.count()), std::memory_order_relaxed);
+        }
+    }
+
+    bool thread_pool::try_pop(size_t index, work_item& next)
+    {
+        auto& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.m_lock);
+        if (worker.m_callbacks.empty())
+        {
+            return false;
+        }
+
+        next = worker.m_callbacks.pop_front();
+        --m_pending;
+        return true;
+    }
+
+    bool thread_pool::try_steal(size_t index, work_item& next)
+    {
+        for (size_t i = 1; i < m_workers.size(); ++i)
+        {
+            auto& victim = *m_workers[(index + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.m_lock);
+            if (!victim.m_callbacks.empty())
+            {
+                next = victim.m_callbacks.pop_front();
+                --m_pending;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
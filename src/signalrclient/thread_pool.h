@@ -0,0 +1,118 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include "signalrclient/scheduler_metrics.h"
+#include "latency_recorder.h"
+#include "ring_queue.h"
+#include "task.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace signalr
+{
+    struct thread_pool_options
+    {
+        // the most workers the pool grows to, 0 picks one worker per hardware thread but never fewer than 5
+        size_t thread_count = 0;
+        // workers the pool starts with and keeps while idle
+        size_t min_thread_count = 0;
+        // workers above min_thread_count exit after being idle this long, longer than the default keepalive interval so
+        // an otherwise idle connection's pings keep reusing the same worker
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds(20);
+        // applied to the worker threads as "<name>-<index>" when not empty, currently only supported on Linux
+        std::string thread_name;
+        // worker i is pinned to cpu_affinity[i % cpu_affinity.size()] when not empty, currently only supported on Linux
+        std::vector<int> cpu_affinity;
+    };
+
+    // A pool of workers where every worker owns a queue of callbacks. Callbacks submitted from a worker go to that
+    // worker's queue, callbacks submitted from any other thread are spread across the workers, and a worker that runs out
+    // of callbacks steals from the others before going to sleep.
+    //
+    // Workers are started as they are needed, a callback submitted while no worker is asleep starts a new one until the
+    // pool reaches thread_count. Workers above min_thread_count exit again once they have been idle for idle_timeout.
+    class thread_pool
+    {
+    public:
+        explicit thread_pool(const thread_pool_options& options);
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // shuts down the pool if shutdown() hasn't been called yet, must not be called from one of the pool's workers
+        ~thread_pool();
+
+        void submit(task&& t);
+
+        // runs all queued callbacks and then joins the workers, callbacks still queued once the workers are joined run on
+        // the calling thread, must not be called from one of the pool's workers
+        void shutdown();
+
+        // the most workers the pool grows to
+        size_t thread_count() const noexcept;
+        // workers currently running, including ones that are starting up
+        size_t active_thread_count() const noexcept;
+
+        // metrics are off until enabled, after that every callback costs a few clock reads and relaxed atomic updates
+        void enable_metrics() noexcept;
+        bool metrics_enabled() const noexcept;
+        // fills in the dispatch latency, queue depth and worker busy time
+        void collect_metrics(scheduler_metrics& metrics) const;
+
+    private:
+#pragma warning( push )
+#pragma warning( disable: 4625 5026 4626 5027 )
+        struct work_item
+        {
+            task callback;
+            // only set while metrics are enabled
+            std::chrono::steady_clock::time_point enqueued;
+        };
+
+        struct worker
+        {
+            ring_queue<work_item> m_callbacks;
+            std::mutex m_lock;
+            std::thread m_thread;
+            std::atomic<uint64_t> m_busy_us{ 0 };
+        };
+#pragma warning( pop )
+
+        thread_pool_options m_options;
+        // one slot per worker the pool can grow to, slots [0, m_active) have a running worker
+        std::vector<std::unique_ptr<worker>> m_workers;
+        // callbacks queued across all workers, lets idle workers sleep without scanning every queue
+        std::atomic<size_t> m_pending;
+        // workers waiting on m_idle_cv, submit() skips the notification when nobody is waiting
+        std::atomic<size_t> m_sleeping;
+        std::atomic<size_t> m_next_worker;
+        // only changed with m_idle_lock held, read without it to skip taking the lock when the pool can't grow
+        std::atomic<size_t> m_active;
+        // workers that have been started but haven't looked for callbacks yet
+        std::atomic<size_t> m_starting;
+        std::mutex m_idle_lock;
+        std::condition_variable m_idle_cv;
+        bool m_stopping;
+        bool m_joined;
+
+        std::atomic<bool> m_metrics_enabled;
+        std::atomic<size_t> m_peak_pending;
+        latency_recorder m_dispatch_latency;
+
+        void run_worker(size_t index);
+        void grow();
+        // must be called with m_idle_lock held
+        void start_worker();
+        bool try_pop(size_t index, work_item& next);
+        bool try_steal(size_t index, work_item& next);
+        void run_task(worker& current, work_item& next);
+    };
+}
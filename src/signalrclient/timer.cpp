@@ -0,0 +1,177 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include <assert.h>
+#include "timer.h"
+
+namespace signalr
+{
+    namespace
+    {
+        // rounds up so a tick never runs before its deadline because of the scheduler's millisecond resolution
+        std::chrono::milliseconds delay_until(timer::clock::time_point deadline, timer::clock::time_point now)
+        {
+            if (deadline <= now)
+            {
+                return std::chrono::milliseconds::zero();
+            }
+
+            auto remaining = deadline - now;
+            auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(remaining);
+            if (delay < remaining)
+            {
+                delay += std::chrono::milliseconds(1);
+            }
+            return delay;
+        }
+    }
+
+    std::shared_ptr<timer> timer::create(std::shared_ptr<scheduler> scheduler)
+    {
+        return std::shared_ptr<timer>(new timer(std::move(scheduler)));
+    }
+
+    timer::timer(std::shared_ptr<scheduler> scheduler)
+        : m_scheduler(std::move(scheduler)), m_task_scheduler(dynamic_cast<task_scheduler*>(m_scheduler.get())),
+        m_clock(find_clock(*m_scheduler)), m_period(std::chrono::milliseconds::zero()), m_generation(0)
+    {
+        assert(m_scheduler);
+    }
+
+    void timer::schedule_at(clock::time_point deadline, signalr_base_cb callback)
+    {
+        arm(deadline, std::chrono::milliseconds::zero(), std::move(callback));
+    }
+
+    void timer::schedule_after(std::chrono::milliseconds delay, signalr_base_cb callback)
+    {
+        arm(clock_now(m_clock) + delay, std::chrono::milliseconds::zero(), std::move(callback));
+    }
+
+    void timer::schedule_every(std::chrono::milliseconds period, signalr_base_cb callback)
+    {
+        assert(period > std::chrono::milliseconds::zero());
+        arm(clock_now(m_clock) + period, period, std::move(callback));
+    }
+
+    void timer::cancel()
+    {
+        signalr_base_cb callback;
+        std::shared_ptr<timer> self;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            ++m_generation;
+            // a running callback is held by fire() which drops it since the generation changed
+            callback.swap(m_callback);
+            // a tick that is still pending finds the timer gone if nothing else holds it
+            self = std::move(m_self);
+        } // unlock, destruct the callback outside of the lock in case it holds the last reference to something that uses this timer
+    }
+
+    void timer::arm(clock::time_point deadline, std::chrono::milliseconds period, signalr_base_cb&& callback)
+    {
+        signalr_base_cb previous;
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            previous.swap(m_callback);
+            m_callback = std::move(callback);
+            m_deadline = deadline;
+            m_period = period;
+            generation = ++m_generation;
+
+            if (!m_self)
+            {
+                m_self = shared_from_this();
+            }
+        } // unlock
+
+        schedule_tick(deadline, generation);
+    }
+
+    void timer::schedule_tick(clock::time_point deadline, uint64_t generation)
+    {
+        // fits in a task without allocating, m_self keeps the timer alive while it is armed
+        std::weak_ptr<timer> weak_timer = shared_from_this();
+        auto tick = [weak_timer, generation]()
+        {
+            auto timer = weak_timer.lock();
+            if (timer)
+            {
+                timer->fire(generation);
+            }
+        };
+
+        if (m_task_scheduler != nullptr)
+        {
+            m_task_scheduler->schedule_task(task(tick), delay_until(deadline, clock_now(m_clock)));
+        }
+        else
+        {
+            m_scheduler->schedule(tick, delay_until(deadline, clock_now(m_clock)));
+        }
+    }
+
+    void timer::fire(uint64_t generation)
+    {
+        // the tick holds the timer while this runs, the reference released here is only destructed after the callback
+        std::shared_ptr<timer> self;
+        signalr_base_cb callback;
+        clock::time_point deadline;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (generation != m_generation || !m_callback)
+            {
+                // canceled or re-armed since this tick was scheduled
+                return;
+            }
+
+            deadline = m_deadline;
+            if (clock_now(m_clock) >= deadline)
+            {
+                callback.swap(m_callback);
+            }
+            // otherwise the scheduler ran the tick early, wait out the rest
+        } // unlock
+
+        if (!callback)
+        {
+            schedule_tick(deadline, generation);
+            return;
+        }
+
+        callback();
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (generation != m_generation)
+            {
+                // the callback canceled or re-armed the timer, the callback is destructed outside of the lock
+                return;
+            }
+
+            if (m_period == std::chrono::milliseconds::zero())
+            {
+                // a one-shot that has fired is no longer armed
+                self = std::move(m_self);
+                return;
+            }
+
+            m_callback.swap(callback);
+
+            auto now = clock_now(m_clock);
+            m_deadline += m_period;
+            if (m_deadline <= now)
+            {
+                // skip the ticks that were missed while the callback ran
+                auto missed = (now - m_deadline) / m_period + 1;
+                m_deadline += m_period * missed;
+            }
+            deadline = m_deadline;
+        } // unlock
+
+        schedule_tick(deadline, generation);
+    }
+}
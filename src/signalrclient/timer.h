@@ -0,0 +1,65 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "../include/signalrclient/scheduler.h"
+#include "task.h"
+#include "scheduler_clock.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace signalr
+{
+    // A one-shot or repeating timer on top of any scheduler that can be canceled or re-armed. Deadlines have millisecond
+    // precision and a repeating timer doesn't allocate per tick on a task_scheduler. An armed timer keeps itself alive until
+    // a one-shot has fired or the timer is canceled, which also releases the callback. Ticks only hold a weak reference, so
+    // one that is still pending for a canceled timer doesn't keep it alive. Deadlines are in the scheduler's clock.
+    //
+    // Note:
+    // Factory methods and private constructors prevent from using this class incorrectly. Because this class
+    // derives from `std::enable_shared_from_this` the instance has to be owned by a `std::shared_ptr` whenever
+    // a member method calls `std::shared_from_this()` otherwise the behavior is undefined.
+    class timer : public std::enable_shared_from_this<timer>
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        static std::shared_ptr<timer> create(std::shared_ptr<scheduler> scheduler);
+
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+
+        // arming the timer replaces whatever it was armed with before
+        void schedule_at(clock::time_point deadline, signalr_base_cb callback);
+        void schedule_after(std::chrono::milliseconds delay, signalr_base_cb callback);
+        // the first tick is one period from now, ticks that were missed because the callback ran long are skipped
+        void schedule_every(std::chrono::milliseconds period, signalr_base_cb callback);
+
+        // the callback won't be invoked again unless the timer is re-armed, a callback that is already running finishes
+        void cancel();
+
+    private:
+        explicit timer(std::shared_ptr<scheduler> scheduler);
+
+        std::shared_ptr<scheduler> m_scheduler;
+        // null if the scheduler only takes std::function callbacks
+        task_scheduler* m_task_scheduler;
+        // null if the scheduler uses the steady clock
+        const clock_source* m_clock;
+        std::mutex m_lock;
+        signalr_base_cb m_callback;
+        clock::time_point m_deadline;
+        std::chrono::milliseconds m_period;
+        // incremented whenever the timer is re-armed or canceled so ticks scheduled before that are ignored
+        uint64_t m_generation;
+        // keeps the timer alive while it is armed
+        std::shared_ptr<timer> m_self;
+
+        void arm(clock::time_point deadline, std::chrono::milliseconds period, signalr_base_cb&& callback);
+        void schedule_tick(clock::time_point deadline, uint64_t generation);
+        void fire(uint64_t generation);
+    };
+}
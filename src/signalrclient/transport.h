@@ -25,6 +25,12 @@ namespace signalr
 
         virtual void on_receive(std::function<void(std::string&&, std::exception_ptr)> callback) = 0;
 
+        // Stops asking for more messages once the one being received is processed, so the server is held back by the
+        // transport's flow control while the client catches up. Calls are counted: receiving continues once every
+        // pause_receiving was matched by a resume_receiving, whichever order they were made in.
+        virtual void pause_receiving() noexcept = 0;
+        virtual void resume_receiving() noexcept = 0;
+
     protected:
         transport(const logger& logger);
 
@@ -0,0 +1,69 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "signalrclient/upload_stream.h"
+#include "signalrclient/signalr_exception.h"
+#include "hub_connection_impl.h"
+
+namespace signalr
+{
+    upload_stream::upload_stream(std::weak_ptr<hub_connection_impl> connection, std::string stream_id)
+        : m_connection(std::move(connection)), m_stream_id(std::move(stream_id)), m_completed(false)
+    {}
+
+    upload_stream::~upload_stream()
+    {
+        if (!m_completed)
+        {
+            end("", [](std::exception_ptr) {});
+        }
+    }
+
+    void upload_stream::write(const signalr::value& item, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (m_completed)
+        {
+            callback(std::make_exception_ptr(signalr_exception("write() cannot be called on a completed upload_stream")));
+            return;
+        }
+
+        auto connection = m_connection.lock();
+        if (!connection)
+        {
+            callback(std::make_exception_ptr(signalr_exception("write() cannot be called after the hub_connection was destructed")));
+            return;
+        }
+
+        connection->send_stream_message(std::make_shared<stream_item_message>(m_stream_id, item), callback);
+    }
+
+    void upload_stream::complete(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        end("", callback);
+    }
+
+    void upload_stream::cancel(const std::string& error, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        end(error, callback);
+    }
+
+    void upload_stream::end(const std::string& error, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (m_completed.exchange(true))
+        {
+            callback(std::make_exception_ptr(signalr_exception("the upload_stream was already completed")));
+            return;
+        }
+
+        auto connection = m_connection.lock();
+        if (!connection)
+        {
+            callback(std::make_exception_ptr(signalr_exception("the upload_stream cannot be completed after the hub_connection was destructed")));
+            return;
+        }
+
+        connection->send_stream_message(std::make_shared<completion_message>(m_stream_id, error, signalr::value(), false), callback);
+    }
+}
@@ -0,0 +1,110 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "value_arena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace signalr
+{
+    namespace
+    {
+        thread_local value_arena* t_current_arena = nullptr;
+
+        // every allocation is aligned like operator new aligns them
+        const size_t alignment = alignof(std::max_align_t);
+
+        const size_t first_block_size = 4 * 1024;
+        // blocks double in size up to this, larger allocations get a block of their own size
+        const size_t max_block_size = 1024 * 1024;
+    }
+
+    value_arena* current_value_arena() noexcept
+    {
+        return t_current_arena;
+    }
+
+    void* allocate_from_value_arena(value_arena* arena, size_t size)
+    {
+        return arena->allocate(size);
+    }
+
+    value_arena::value_arena()
+        : m_current(nullptr), m_end(nullptr)
+    {}
+
+    value_arena::~value_arena()
+    {
+        for (auto& block : m_blocks)
+        {
+            ::operator delete(block.memory);
+        }
+    }
+
+    void* value_arena::allocate(size_t size)
+    {
+        size = (size + alignment - 1) & ~(alignment - 1);
+        if (static_cast<size_t>(m_end - m_current) < size)
+        {
+            auto block_size = m_blocks.empty() ? first_block_size : std::min(m_blocks.back().size * 2, max_block_size);
+            add_block(std::max(block_size, size));
+        }
+
+        auto memory = m_current;
+        m_current += size;
+        return memory;
+    }
+
+    void value_arena::release()
+    {
+        if (m_blocks.empty())
+        {
+            return;
+        }
+
+        // the last block is the largest one unless it was made for a single large allocation, which a frame of the same
+        // size will need again
+        auto kept = m_blocks.back();
+        m_blocks.pop_back();
+        for (auto& block : m_blocks)
+        {
+            ::operator delete(block.memory);
+        }
+        m_blocks.clear();
+        m_blocks.push_back(kept);
+
+        m_current = kept.memory;
+        m_end = kept.memory + kept.size;
+#ifndef NDEBUG
+        // a value kept past the release reads garbage in debug builds instead of what the next frame happens to leave
+        memset(kept.memory, 0xdd, static_cast<size_t>(m_end - m_current));
+#endif
+    }
+
+    void value_arena::add_block(size_t size)
+    {
+        // reserved first so a failure to grow the list doesn't leak the block
+        m_blocks.reserve(m_blocks.size() + 1);
+        block new_block;
+        new_block.memory = static_cast<char*>(::operator new(size));
+        new_block.size = size;
+        m_blocks.push_back(new_block);
+
+        m_current = new_block.memory;
+        m_end = new_block.memory + size;
+    }
+
+    value_arena::scope::scope(value_arena* arena) noexcept
+        : m_previous(t_current_arena)
+    {
+        t_current_arena = arena;
+    }
+
+    value_arena::scope::~scope()
+    {
+        t_current_arena = m_previous;
+    }
+}
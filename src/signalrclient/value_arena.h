@@ -0,0 +1,57 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/signalr_value.h"
+#include <cstddef>
+#include <vector>
+
+namespace signalr
+{
+    // Bump allocator for the arrays and maps of the values parsed from a frame. Allocations are carved out of blocks one
+    // after the other and are never given back individually, release gives everything back at once and keeps the largest
+    // block so frames of a similar size don't allocate at all.
+    class value_arena
+    {
+    public:
+        value_arena();
+        ~value_arena();
+
+        value_arena(const value_arena&) = delete;
+        value_arena& operator=(const value_arena&) = delete;
+
+        void* allocate(size_t size);
+        // nothing allocated from the arena may be used afterwards
+        void release();
+
+        // Makes the containers of the values created on this thread allocate from the arena until the scope ends, scopes
+        // can be nested and a nullptr arena makes them allocate from the heap.
+        class scope
+        {
+        public:
+            explicit scope(value_arena* arena) noexcept;
+            ~scope();
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            value_arena* m_previous;
+        };
+
+    private:
+        struct block
+        {
+            char* memory;
+            size_t size;
+        };
+
+        std::vector<block> m_blocks;
+        char* m_current;
+        char* m_end;
+
+        void add_block(size_t size);
+    };
+}
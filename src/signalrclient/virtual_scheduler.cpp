@@ -0,0 +1,122 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "signalrclient/virtual_scheduler.h"
+#include <algorithm>
+
+namespace signalr
+{
+    namespace
+    {
+        // std::push_heap/std::pop_heap build a max-heap, inverting the comparison keeps the earliest deadline at the front
+        template <typename Entry>
+        bool later(const Entry& lhs, const Entry& rhs)
+        {
+            if (lhs.deadline != rhs.deadline)
+            {
+                return lhs.deadline > rhs.deadline;
+            }
+            return lhs.sequence > rhs.sequence;
+        }
+    }
+
+    virtual_scheduler::virtual_scheduler()
+        : m_sequence(0)
+    { }
+
+    void virtual_scheduler::schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_entries.push_back(entry{ m_now + std::max(delay, std::chrono::milliseconds::zero()), m_sequence++, cb });
+            std::push_heap(m_entries.begin(), m_entries.end(), later<entry>);
+        } // unlock
+
+        m_scheduled_cv.notify_all();
+    }
+
+    std::chrono::steady_clock::time_point virtual_scheduler::now() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_now;
+    }
+
+    size_t virtual_scheduler::run_until_idle()
+    {
+        size_t ran = 0;
+        while (run_next(now()))
+        {
+            ++ran;
+        }
+        return ran;
+    }
+
+    size_t virtual_scheduler::advance(std::chrono::milliseconds duration)
+    {
+        auto until = now() + duration;
+
+        size_t ran = 0;
+        while (run_next(until))
+        {
+            ++ran;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_now = std::max(m_now, until);
+        return ran;
+    }
+
+    bool virtual_scheduler::run_until(const std::function<bool()>& condition, std::chrono::milliseconds timeout)
+    {
+        auto give_up = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            run_until_idle();
+            if (condition())
+            {
+                return true;
+            }
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (std::chrono::steady_clock::now() >= give_up)
+            {
+                return false;
+            }
+
+            // the condition can also be satisfied by another thread without scheduling anything, so don't sleep for long
+            m_scheduled_cv.wait_for(lock, std::chrono::milliseconds(1), [this]()
+                {
+                    return !m_entries.empty() && m_entries.front().deadline <= m_now;
+                });
+        }
+    }
+
+    size_t virtual_scheduler::pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_entries.size();
+    }
+
+    bool virtual_scheduler::run_next(std::chrono::steady_clock::time_point until)
+    {
+        signalr_base_cb callback;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_entries.empty() || m_entries.front().deadline > until)
+            {
+                return false;
+            }
+
+            std::pop_heap(m_entries.begin(), m_entries.end(), later<entry>);
+            m_now = std::max(m_now, m_entries.back().deadline);
+            callback = std::move(m_entries.back().callback);
+            m_entries.pop_back();
+        } // unlock
+
+        // callbacks are free to schedule more work
+        callback();
+        return true;
+    }
+}
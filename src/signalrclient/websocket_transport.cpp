@@ -26,7 +26,8 @@ namespace signalr
         const signalr_client_config& signalr_client_config, const logger& logger)
         : transport(logger), m_websocket_client_factory(websocket_client_factory), m_process_response_callback([](std::string, std::exception_ptr) {}),
         m_close_callback([](std::exception_ptr) {}), m_signalr_client_config(signalr_client_config),
-        m_disconnected(true), m_receive_loop_task(std::make_shared<cancellation_token_source>())
+        m_disconnected(true), m_receive_loop_task(std::make_shared<cancellation_token_source>()), m_receive_pauses(0),
+        m_receive_parked(false)
     {
         // we use this cts to check if the receive loop is running so it should be
         // initially canceled to indicate that the receive loop is not running
@@ -171,6 +172,12 @@ namespace signalr
                 {
                     std::lock_guard<std::mutex> lock(transport->m_start_stop_lock);
                     disconnected = transport->m_disconnected;
+                    if (!disconnected && transport->m_receive_pauses > 0)
+                    {
+                        // resume_receiving continues the loop, or stop ends it
+                        transport->m_receive_parked = true;
+                        return;
+                    }
                 }
 
                 if (!disconnected)
@@ -221,6 +228,8 @@ namespace signalr
             }
 
             m_disconnected = false;
+            m_receive_pauses = 0;
+            m_receive_parked = false;
             m_receive_loop_task->reset();
 
             auto weak_transport = std::weak_ptr<websocket_transport>(shared_from_this());
@@ -266,6 +275,7 @@ namespace signalr
     void websocket_transport::stop(std::function<void(std::exception_ptr)> callback) noexcept
     {
         std::shared_ptr<websocket_client> websocket_client = nullptr;
+        bool receive_parked;
 
         {
             std::lock_guard<std::mutex> lock(m_start_stop_lock);
@@ -277,6 +287,8 @@ namespace signalr
             }
 
             m_disconnected = true;
+            receive_parked = m_receive_parked;
+            m_receive_parked = false;
 
             websocket_client = safe_get_websocket_client();
         }
@@ -285,6 +297,12 @@ namespace signalr
         auto close_callback = m_close_callback;
         auto receive_loop_task = m_receive_loop_task;
 
+        if (receive_parked)
+        {
+            // there is no receive for the client to complete, the loop ends here
+            receive_loop_task->cancel();
+        }
+
         m_logger.log(trace_level::debug, "stopping websocket transport");
 
         websocket_client->stop([logger, callback, close_callback, receive_loop_task](std::exception_ptr exception)
@@ -327,6 +345,28 @@ namespace signalr
         m_process_response_callback = callback;
     }
 
+    void websocket_transport::pause_receiving() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_start_stop_lock);
+        ++m_receive_pauses;
+    }
+
+    void websocket_transport::resume_receiving() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+            --m_receive_pauses;
+            if (m_receive_pauses > 0 || !m_receive_parked)
+            {
+                // still paused, or the loop didn't get to park and just keeps going
+                return;
+            }
+            m_receive_parked = false;
+        }
+
+        receive_loop();
+    }
+
     void websocket_transport::send(const std::string& payload, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept
     {
         safe_get_websocket_client()->send(payload, transfer_format, [callback](std::exception_ptr exception)
@@ -33,6 +33,9 @@ namespace signalr
 
         void on_receive(std::function<void(std::string&&, std::exception_ptr)>) override;
 
+        void pause_receiving() noexcept override;
+        void resume_receiving() noexcept override;
+
     private:
         websocket_transport(const std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)>& websocket_client_factory,
             const signalr_client_config& signalr_client_config, const logger& logger);
@@ -47,6 +50,10 @@ namespace signalr
 
         bool m_disconnected;
         std::shared_ptr<cancellation_token_source> m_receive_loop_task;
+        // guarded by m_start_stop_lock, the receive loop is parked instead of receiving the next message while pause_receiving
+        // was called more often than resume_receiving
+        int m_receive_pauses;
+        bool m_receive_parked;
 
         void receive_loop();
 
@@ -0,0 +1,148 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    std::atomic<uint64_t> allocations(0);
+}
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    auto memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+uint64_t allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+benchmark_registration::benchmark_registration(const char* name, void (*func)())
+{
+    get_registered_benchmarks().push_back(registered_benchmark{ name, func });
+}
+
+std::vector<registered_benchmark>& get_registered_benchmarks()
+{
+    static std::vector<registered_benchmark> benchmarks;
+    return benchmarks;
+}
+
+sample_summary summarize(std::vector<double> samples)
+{
+    sample_summary summary{ samples.size(), 0, 0, 0, 0 };
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    summary.p50 = samples[samples.size() / 2];
+    summary.p99 = samples[std::min(samples.size() - 1, (samples.size() * 99) / 100)];
+    summary.max = samples.back();
+    return summary;
+}
+
+void report(const std::string& metric, double value, const std::string& unit)
+{
+    std::printf("  %-48s %14.3f %s\n", metric.c_str(), value, unit.c_str());
+}
+
+void report(const std::string& metric, const sample_summary& summary, const std::string& unit)
+{
+    std::printf("  %-48s mean %10.3f  p50 %10.3f  p99 %10.3f  max %10.3f %s (n=%zu)\n", metric.c_str(),
+        summary.mean, summary.p50, summary.p99, summary.max, unit.c_str(), summary.count);
+}
+
+std::chrono::microseconds process_cpu_time()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto to_100ns = [](const FILETIME& time)
+    {
+        return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return std::chrono::microseconds((to_100ns(kernel) + to_100ns(user)) / 10);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+        + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+namespace
+{
+    // reads a numeric field such as "Threads:" from /proc/self/status
+    size_t read_process_status(const char* field)
+    {
+        size_t value = 0;
+#if defined(__linux__)
+        auto status = std::fopen("/proc/self/status", "r");
+        if (status == nullptr)
+        {
+            return 0;
+        }
+
+        char line[256];
+        auto field_length = std::strlen(field);
+        while (std::fgets(line, sizeof(line), status) != nullptr)
+        {
+            if (std::strncmp(line, field, field_length) == 0)
+            {
+                value = std::strtoul(line + field_length, nullptr, 10);
+                break;
+            }
+        }
+        std::fclose(status);
+#else
+        (void)field;
+#endif
+        return value;
+    }
+}
+
+size_t process_thread_count()
+{
+    return read_process_status("Threads:");
+}
+
+size_t process_resident_memory_kb()
+{
+    return read_process_status("VmRSS:");
+}
@@ -0,0 +1,57 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Registers a benchmark with the runner in signalrclientbenchmarks.cpp, mirrors the shape of a gtest TEST so benchmarks
+// read like the rest of the test code.
+#define BENCHMARK(group, name) \
+    static void group##_##name##_benchmark(); \
+    static benchmark_registration group##_##name##_registration(#group "." #name, &group##_##name##_benchmark); \
+    static void group##_##name##_benchmark()
+
+struct benchmark_registration
+{
+    benchmark_registration(const char* name, void (*func)());
+};
+
+struct registered_benchmark
+{
+    std::string name;
+    void (*func)();
+};
+
+std::vector<registered_benchmark>& get_registered_benchmarks();
+
+// summary of a set of samples, all values are in the unit the samples were recorded in
+struct sample_summary
+{
+    size_t count;
+    double mean;
+    double p50;
+    double p99;
+    double max;
+};
+
+sample_summary summarize(std::vector<double> samples);
+
+void report(const std::string& metric, double value, const std::string& unit);
+void report(const std::string& metric, const sample_summary& summary, const std::string& unit);
+
+// CPU time (user + kernel) consumed by the whole process so far
+std::chrono::microseconds process_cpu_time();
+
+// Thread count and resident memory of the process, both are 0 where they aren't supported (currently only Linux is)
+size_t process_thread_count();
+size_t process_resident_memory_kb();
+
+// Heap allocations made through operator new by any thread since the process started, the benchmark executable replaces
+// the global operator new to count them
+uint64_t allocation_count();
@@ -0,0 +1,271 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include "loopback_websocket_client.h"
+#include "signalrclient/hub_connection_builder.h"
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace signalr;
+
+namespace
+{
+    hub_connection create_loopback_connection(bool use_shared_scheduler)
+    {
+        auto connection = hub_connection_builder::create("http://localhost/hub")
+            .with_logging(nullptr, trace_level::none)
+            .skip_negotiation()
+            .with_http_client_factory([](const signalr_client_config&)
+                {
+                    // never used since negotiation is skipped
+                    return std::shared_ptr<http_client>();
+                })
+            .with_websocket_factory([](const signalr_client_config& config)
+                {
+                    return std::make_shared<loopback_websocket_client>(config);
+                })
+            .build();
+
+        signalr_client_config config;
+        config.set_use_shared_scheduler(use_shared_scheduler);
+        connection.set_client_config(config);
+        return connection;
+    }
+
+    void start_many_connections(bool use_shared_scheduler)
+    {
+        const int count = 200;
+
+        auto threads_before = process_thread_count();
+        auto memory_before = process_resident_memory_kb();
+
+        std::vector<hub_connection> connections;
+        connections.reserve(count);
+        std::vector<std::future<void>> started;
+        started.reserve(count);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            connections.push_back(create_loopback_connection(use_shared_scheduler));
+
+            auto promise = std::make_shared<std::promise<void>>();
+            started.push_back(promise->get_future());
+            connections.back().start([promise](std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        promise->set_exception(exception);
+                    }
+                    else
+                    {
+                        promise->set_value();
+                    }
+                });
+        }
+
+        for (auto& future : started)
+        {
+            future.get();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        report("connections", count, "");
+        report("time to start all", std::chrono::duration<double, std::milli>(elapsed).count(), "ms");
+        report("threads added", static_cast<double>(process_thread_count()) - threads_before, "");
+        report("resident memory added", static_cast<double>(process_resident_memory_kb()) - memory_before, "KB");
+
+        std::vector<std::future<void>> stopped;
+        stopped.reserve(count);
+        for (auto& connection : connections)
+        {
+            auto promise = std::make_shared<std::promise<void>>();
+            stopped.push_back(promise->get_future());
+            connection.stop([promise](std::exception_ptr)
+                {
+                    promise->set_value();
+                });
+        }
+
+        for (auto& future : stopped)
+        {
+            future.get();
+        }
+
+        connections.clear();
+
+        // schedulers shut down asynchronously, give their threads a moment to exit before the next benchmark measures
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+
+    // Latency of a single start() on a connection with its own default scheduler, which includes creating the scheduler
+    // and its workers, along with the threads and memory that one idle connection holds on to once started
+    void single_connection_start()
+    {
+        const int count = 50;
+        std::vector<double> start_us;
+        start_us.reserve(count);
+        std::vector<double> threads_added;
+        std::vector<double> memory_added_kb;
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto threads_before = process_thread_count();
+            auto memory_before = process_resident_memory_kb();
+
+            {
+                auto connection = create_loopback_connection(false);
+
+                std::promise<void> started;
+                auto start = std::chrono::steady_clock::now();
+                connection.start([&started](std::exception_ptr exception)
+                    {
+                        if (exception)
+                        {
+                            started.set_exception(exception);
+                        }
+                        else
+                        {
+                            started.set_value();
+                        }
+                    });
+                started.get_future().get();
+                start_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+                // let workers that were only needed for the start settle
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                threads_added.push_back(static_cast<double>(process_thread_count()) - threads_before);
+                memory_added_kb.push_back(static_cast<double>(process_resident_memory_kb()) - memory_before);
+
+                std::promise<void> stopped;
+                connection.stop([&stopped](std::exception_ptr)
+                    {
+                        stopped.set_value();
+                    });
+                stopped.get_future().get();
+            }
+
+            // the scheduler shuts down asynchronously
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        report("start", summarize(start_us), "us");
+        report("threads per started connection", summarize(threads_added).p50, "");
+        report("resident memory per started connection", summarize(memory_added_kb).p50, "KB");
+    }
+
+    // Time from the server's message arriving at the websocket until the hub method handler runs, messages are sent one
+    // at a time so this measures the delivery path rather than queueing.
+    void receive_to_handler_latency(callback_mode mode)
+    {
+        const int count = 20000;
+
+        auto websocket = std::make_shared<std::shared_ptr<loopback_websocket_client>>();
+        auto connection = hub_connection_builder::create("http://localhost/hub")
+            .with_logging(nullptr, trace_level::none)
+            .skip_negotiation()
+            .with_http_client_factory([](const signalr_client_config&)
+                {
+                    return std::shared_ptr<http_client>();
+                })
+            .with_websocket_factory([websocket](const signalr_client_config& config)
+                {
+                    *websocket = std::make_shared<loopback_websocket_client>(config);
+                    return *websocket;
+                })
+            .build();
+
+        signalr_client_config config;
+        config.set_callback_mode(mode);
+        connection.set_client_config(config);
+
+        std::mutex lock;
+        std::condition_variable handled_cv;
+        int handled = 0;
+        std::chrono::steady_clock::time_point received;
+        std::vector<double> latency_us;
+        latency_us.reserve(count);
+
+        connection.on("tick", [&lock, &handled_cv, &handled, &received, &latency_us](const std::vector<signalr::value>&)
+            {
+                auto now = std::chrono::steady_clock::now();
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    latency_us.push_back(std::chrono::duration<double, std::micro>(now - received).count());
+                    ++handled;
+                }
+                handled_cv.notify_one();
+            });
+
+        std::promise<void> started;
+        connection.start([&started](std::exception_ptr exception)
+            {
+                if (exception)
+                {
+                    started.set_exception(exception);
+                }
+                else
+                {
+                    started.set_value();
+                }
+            });
+        started.get_future().get();
+
+        const std::string message = "{\"type\":1,\"target\":\"tick\",\"arguments\":[]}\x1e";
+        for (int i = 0; i < count; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                received = std::chrono::steady_clock::now();
+            }
+            (*websocket)->receive_message(message);
+
+            std::unique_lock<std::mutex> guard(lock);
+            handled_cv.wait(guard, [&handled, i]() { return handled == i + 1; });
+        }
+
+        report("messages", count, "");
+        report("receive to handler", summarize(latency_us), "us");
+
+        std::promise<void> stopped;
+        connection.stop([&stopped](std::exception_ptr)
+            {
+                stopped.set_value();
+            });
+        stopped.get_future().get();
+    }
+}
+
+// Starting many connections that share the process-wide default scheduler.
+BENCHMARK(connection, start_many_connections_shared_scheduler)
+{
+    start_many_connections(true);
+}
+
+// Starting many connections that each get their own default scheduler.
+BENCHMARK(connection, start_many_connections_private_schedulers)
+{
+    start_many_connections(false);
+}
+
+// Start latency and footprint of one connection with its own scheduler.
+BENCHMARK(connection, single_connection_start)
+{
+    single_connection_start();
+}
+
+// Receive to handler latency with handlers running on the connection's strand.
+BENCHMARK(connection, receive_to_handler_latency_scheduled)
+{
+    receive_to_handler_latency(callback_mode::scheduled);
+}
+
+// Receive to handler latency with handlers running directly on the receiving thread.
+BENCHMARK(connection, receive_to_handler_latency_caller_runs)
+{
+    receive_to_handler_latency(callback_mode::caller_runs);
+}
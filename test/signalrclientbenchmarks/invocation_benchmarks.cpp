@@ -0,0 +1,221 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include "callback_manager.h"
+#include "loopback_websocket_client.h"
+#include "signalrclient/hub_connection_builder.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+
+using namespace signalr;
+
+namespace
+{
+    // A server that answers invocations more slowly than the client makes them. Each invocation carries a 1KB argument
+    // so whatever the client buffers shows up in resident memory.
+    void invoke_faster_than_the_server_answers(const std::string& label, size_t max_pending_invocations, flow_control_mode mode)
+    {
+        const int count = 20000;
+        const size_t answers_per_ms = 20;
+
+        std::shared_ptr<loopback_websocket_client> websocket;
+        auto connection = hub_connection_builder::create("http://localhost/hub")
+            .with_logging(nullptr, trace_level::none)
+            .skip_negotiation()
+            .with_http_client_factory([](const signalr_client_config&)
+                {
+                    // never used since negotiation is skipped
+                    return std::shared_ptr<http_client>();
+                })
+            .with_websocket_factory([&websocket](const signalr_client_config& config)
+                {
+                    websocket = std::make_shared<loopback_websocket_client>(config);
+                    return websocket;
+                })
+            .build();
+
+        signalr_client_config config;
+        config.set_max_pending_invocations(max_pending_invocations);
+        config.set_flow_control_mode(mode);
+        connection.set_client_config(config);
+
+        std::mutex lock;
+        std::condition_variable ready_cv;
+        bool ready = false;
+        connection.set_ready_to_send([&lock, &ready_cv, &ready]()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ready = true;
+                }
+                ready_cv.notify_all();
+            });
+
+        std::promise<void> started;
+        connection.start([&started](std::exception_ptr)
+            {
+                started.set_value();
+            });
+        started.get_future().get();
+
+        std::mutex received_lock;
+        std::deque<std::string> received;
+        websocket->on_send = [&received_lock, &received](const std::string& message)
+        {
+            const std::string marker = "\"invocationId\":\"";
+            auto begin = message.find(marker) + marker.size();
+            std::lock_guard<std::mutex> guard(received_lock);
+            received.push_back(message.substr(begin, message.find('"', begin) - begin));
+        };
+
+        std::atomic<int> completed(0);
+        std::atomic<bool> done(false);
+        std::thread server([&]()
+            {
+                while (!done)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                    std::lock_guard<std::mutex> guard(received_lock);
+                    for (size_t i = 0; i < answers_per_ms && !received.empty(); ++i)
+                    {
+                        websocket->receive_message("{\"type\":3,\"invocationId\":\"" + received.front() + "\",\"result\":null}\x1e");
+                        received.pop_front();
+                    }
+                }
+            });
+
+        const std::vector<signalr::value> arguments{ signalr::value(std::string(1024, 'x')) };
+        auto memory_before = process_resident_memory_kb();
+        size_t peak_pending = 0;
+        size_t peak_memory = memory_before;
+        int retries = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ready = false;
+                }
+
+                bool rejected = false;
+                connection.invoke("method", arguments, [&completed, &rejected](const signalr::value&, std::exception_ptr exception)
+                    {
+                        if (exception)
+                        {
+                            rejected = true;
+                        }
+                        else
+                        {
+                            ++completed;
+                        }
+                    });
+
+                if (!rejected)
+                {
+                    break;
+                }
+
+                // the rejection is reported before invoke returns, wait for the connection to drop below its limit
+                ++retries;
+                std::unique_lock<std::mutex> guard(lock);
+                ready_cv.wait(guard, [&ready]() { return ready; });
+            }
+
+            peak_pending = std::max(peak_pending, connection.get_pending_invocation_count());
+            if (i % 1000 == 0)
+            {
+                peak_memory = std::max(peak_memory, process_resident_memory_kb());
+            }
+        }
+        auto issued = std::chrono::steady_clock::now() - start;
+        peak_memory = std::max(peak_memory, process_resident_memory_kb());
+
+        while (completed < count)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        done = true;
+        server.join();
+
+        std::promise<void> stopped;
+        connection.stop([&stopped](std::exception_ptr)
+            {
+                stopped.set_value();
+            });
+        stopped.get_future().get();
+
+        auto suffix = " (" + label + ")";
+        report("time to issue all invocations" + suffix, std::chrono::duration<double, std::milli>(issued).count(), "ms");
+        report("time to complete all invocations" + suffix, std::chrono::duration<double, std::milli>(elapsed).count(), "ms");
+        report("peak pending invocations" + suffix, static_cast<double>(peak_pending), "");
+        report("peak resident memory added" + suffix, static_cast<double>(peak_memory) - memory_before, "KB");
+        report("rejected and retried" + suffix, retries, "");
+    }
+}
+
+// Registering an invocation callback, writing its id the way the invocation message needs it and completing it by the id
+// the completion message carries, from one thread and from several threads sharing the callback manager.
+BENCHMARK(invocation, callback_round_trip)
+{
+    const int count = 200000;
+    const size_t thread_counts[] = { 1, 4 };
+
+    for (auto thread_count : thread_counts)
+    {
+        callback_manager callback_mgr{ "" };
+
+        auto round_trips = [&callback_mgr]()
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                auto callback_id = callback_mgr.register_callback([](const char*, const signalr::value&) {});
+
+                char buffer[callback_manager::max_callback_id_length];
+                const std::string invocation_id(buffer, callback_manager::format_callback_id(callback_id, buffer));
+
+                callback_mgr.invoke_callback(invocation_id, nullptr, signalr::value(), true);
+            }
+        };
+
+        auto allocations_before = allocation_count();
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            threads.emplace_back(round_trips);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto allocations = allocation_count() - allocations_before;
+        auto total = static_cast<double>(count * thread_count);
+
+        auto suffix = std::string(" (") + std::to_string(thread_count) + (thread_count == 1 ? " thread)" : " threads)");
+        report("round trips/s" + suffix, total / std::chrono::duration<double>(elapsed).count(), "");
+        report("allocations/round trip" + suffix, static_cast<double>(allocations) / total, "");
+    }
+}
+
+// A producer invoking as fast as it can against a server that can't keep up, without flow control every invocation ends
+// up pending, with a limit the calls are either held by the connection (wait) or pushed back to the producer (reject).
+BENCHMARK(invocation, faster_than_the_server_answers)
+{
+    invoke_faster_than_the_server_answers("no limit", 0, flow_control_mode::wait);
+    invoke_faster_than_the_server_answers("wait, 100 pending", 100, flow_control_mode::wait);
+    invoke_faster_than_the_server_answers("reject, 100 pending", 100, flow_control_mode::reject);
+}
@@ -0,0 +1,99 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "loopback_websocket_client.h"
+
+loopback_websocket_client::loopback_websocket_client(const signalr::signalr_client_config& config)
+    : m_scheduler(config.get_scheduler()), m_stopped(true), m_handshake_received(false)
+{ }
+
+void loopback_websocket_client::start(const std::string&, std::function<void(std::exception_ptr)> callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stopped = false;
+        m_handshake_received = false;
+        m_messages.clear();
+    }
+
+    // complete on another thread like a real websocket, the library blocks the completing thread while waiting for the
+    // handshake response which can only arrive once the receive loop has been started
+    m_scheduler->schedule([callback]()
+        {
+            callback(nullptr);
+        });
+}
+
+void loopback_websocket_client::stop(std::function<void(std::exception_ptr)> callback)
+{
+    std::function<void(const std::string&, std::exception_ptr)> receive_callback;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stopped = true;
+        receive_callback.swap(m_receive_callback);
+    }
+
+    // ends the receive loop
+    if (receive_callback)
+    {
+        receive_callback("", nullptr);
+    }
+
+    callback(nullptr);
+}
+
+void loopback_websocket_client::send(const std::string& payload, signalr::transfer_format, std::function<void(std::exception_ptr)> callback)
+{
+    bool handshake;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        handshake = !m_handshake_received;
+        m_handshake_received = true;
+    }
+
+    if (handshake)
+    {
+        receive_message("{}\x1e");
+    }
+    else if (on_send)
+    {
+        on_send(payload);
+    }
+
+    callback(nullptr);
+}
+
+void loopback_websocket_client::receive(std::function<void(const std::string&, std::exception_ptr)> callback)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_receive_callback = callback;
+    deliver(lock);
+}
+
+void loopback_websocket_client::receive_message(const std::string& message)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_messages.push_back(message);
+    deliver(lock);
+}
+
+void loopback_websocket_client::deliver(std::unique_lock<std::mutex>& lock)
+{
+    if (!m_receive_callback || m_messages.empty() || m_stopped)
+    {
+        return;
+    }
+
+    std::function<void(const std::string&, std::exception_ptr)> receive_callback;
+    receive_callback.swap(m_receive_callback);
+    auto message = std::move(m_messages.front());
+    m_messages.pop_front();
+    lock.unlock();
+
+    // like a real websocket the receive completes on another thread, which also keeps the receive loop from recursing
+    m_scheduler->schedule([receive_callback, message]()
+        {
+            receive_callback(message, nullptr);
+        });
+}
@@ -0,0 +1,41 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalrclient/signalr_client_config.h"
+#include "signalrclient/websocket_client.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// In-process stand-in for a SignalR server speaking the JSON protocol, lets benchmarks drive full connections without a
+// network. It answers the handshake and hands everything else it receives to on_send.
+class loopback_websocket_client : public signalr::websocket_client
+{
+public:
+    explicit loopback_websocket_client(const signalr::signalr_client_config& config);
+
+    void start(const std::string& url, std::function<void(std::exception_ptr)> callback) override;
+    void stop(std::function<void(std::exception_ptr)> callback) override;
+    void send(const std::string& payload, signalr::transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) override;
+    void receive(std::function<void(const std::string&, std::exception_ptr)> callback) override;
+
+    // queues a message for the client as if the server had sent it
+    void receive_message(const std::string& message);
+
+    // called for every message sent by the client after the handshake
+    std::function<void(const std::string&)> on_send;
+
+private:
+    std::shared_ptr<signalr::scheduler> m_scheduler;
+    std::mutex m_lock;
+    std::deque<std::string> m_messages;
+    std::function<void(const std::string&, std::exception_ptr)> m_receive_callback;
+    bool m_stopped;
+    bool m_handshake_received;
+
+    void deliver(std::unique_lock<std::mutex>& lock);
+};
@@ -0,0 +1,280 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include "json_helpers.h"
+#include "json_hub_protocol.h"
+#include "message_framer.h"
+#include "text_scanner.h"
+#include <memory>
+
+#ifdef USE_MSGPACK
+#include "binary_message_parser.h"
+#include "messagepack_hub_protocol.h"
+#include <cstring>
+#include <msgpack.hpp>
+#endif
+
+using namespace signalr;
+
+namespace
+{
+    // what the server typically sends: invocations of client methods with a few arguments, completions of the client's
+    // invocations and pings
+    const std::pair<const char*, std::string> typical_messages[] =
+    {
+        { "invocation", "{\"type\":1,\"target\":\"ReceiveMessage\",\"arguments\":[\"user-1234\",\"Hello there, how is it going?\"]}\x1e" },
+        { "invocation with object", "{\"type\":1,\"target\":\"PriceUpdated\",\"arguments\":[{\"symbol\":\"MSFT\",\"price\":412.37,"
+            "\"change\":-1.25,\"volume\":18234500,\"halted\":false,\"tags\":[\"tech\",\"nasdaq\"]}]}\x1e" },
+        { "invocation with integers", "{\"type\":1,\"target\":\"Trades\",\"arguments\":[[1718900000123,4123700,1500,90071992547409930],"
+            "[1718900000456,4123800,300,90071992547409931],[1718900000789,4123650,-200,90071992547409932]]}\x1e" },
+        { "completion", "{\"type\":3,\"invocationId\":\"1337\",\"result\":{\"id\":42,\"name\":\"result\",\"values\":[1,2,3,4,5]}}\x1e" },
+        { "ping", "{\"type\":6}\x1e" }
+    };
+
+    // how each message was parsed before json_reader: a jsoncpp document first, then converted to a signalr::value
+    size_t parse_with_jsoncpp(const std::string& message)
+    {
+        auto reader = getJsonReader();
+        Json::Value root;
+        std::string errors;
+        reader->parse(message.data(), message.data() + message.size() - 1, &root, &errors);
+        return createValue(root).as_value_map().size();
+    }
+
+    template <typename Message, typename Process>
+    void measure(const std::string& label, const Message& message, Process process)
+    {
+        const int count = 100000;
+
+        size_t checksum = 0;
+        auto allocations_before = allocation_count();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            checksum += process(message);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto allocations = allocation_count() - allocations_before;
+
+        if (checksum == 0)
+        {
+            report("nothing was processed" + label, 0, "");
+        }
+        report("messages/s" + label, count / std::chrono::duration<double>(elapsed).count(), "");
+        report("allocations/message" + label, static_cast<double>(allocations) / count, "");
+    }
+}
+
+// Parsing the messages the server sends, through json_hub_protocol and the way it used to be done with jsoncpp.
+BENCHMARK(json_hub_protocol, parse_messages)
+{
+    json_hub_protocol protocol;
+
+    for (auto& message : typical_messages)
+    {
+        measure(std::string(" (") + message.first + ", jsoncpp)", message.second, parse_with_jsoncpp);
+        measure(std::string(" (") + message.first + ")", message.second, [&protocol](const std::string& text)
+            {
+                return protocol.parse_messages(text).size();
+            });
+    }
+}
+
+// Writing the messages the client sends, through json_hub_protocol and the way it used to be done with jsoncpp.
+BENCHMARK(json_hub_protocol, write_message)
+{
+    json_hub_protocol protocol;
+
+    const std::pair<const char*, std::shared_ptr<hub_message>> messages[] =
+    {
+        { "invocation", std::make_shared<invocation_message>("42", "SendMessage",
+            std::vector<signalr::value>{ signalr::value("user-1234"), signalr::value("Hello there, how is it going?") }) },
+        { "invocation with object", std::make_shared<invocation_message>("43", "UpdatePosition",
+            std::vector<signalr::value>{ signalr::value(std::map<std::string, signalr::value>
+                {
+                    { "x", signalr::value(12.5) }, { "y", signalr::value(-3.25) }, { "heading", signalr::value(270.0) },
+                    { "name", signalr::value("player one") }, { "flags", signalr::value(std::vector<signalr::value>{ signalr::value(true) }) }
+                }) }) },
+        { "invocation with integers", std::make_shared<invocation_message>("44", "ReportFill",
+            std::vector<signalr::value>{ signalr::value(int64_t(1718900000123)), signalr::value(int64_t(4123700)),
+                signalr::value(int64_t(1500)), signalr::value(int64_t(90071992547409930)) }) },
+        { "ping", std::make_shared<ping_message>() }
+    };
+
+    for (auto& message : messages)
+    {
+        measure(std::string(" (") + message.first + ", jsoncpp)", message.second, [](const std::shared_ptr<hub_message>& hub_message)
+            {
+                auto invocation = dynamic_cast<invocation_message*>(hub_message.get());
+                Json::Value object(Json::ValueType::objectValue);
+                object["type"] = static_cast<int>(hub_message->message_type);
+                if (invocation != nullptr)
+                {
+                    object["invocationId"] = invocation->invocation_id;
+                    object["target"] = invocation->target;
+                    object["arguments"] = createJson(invocation->arguments);
+                }
+                return (Json::writeString(getJsonWriter(), object) + record_separator).size();
+            });
+        measure(std::string(" (") + message.first + ")", message.second, [&protocol](const std::shared_ptr<hub_message>& hub_message)
+            {
+                return protocol.write_message(hub_message.get()).size();
+            });
+    }
+}
+
+// Splitting a large batched text frame into messages: finding the record separators the way parse_messages used to
+// (std::string::find, without any UTF-8 validation) and with each text_scanner implementation, which also validates.
+BENCHMARK(json_hub_protocol, frame_scanning)
+{
+    std::string frame;
+    while (frame.size() < 512 * 1024)
+    {
+        frame += typical_messages[frame.size() % 3].second;
+    }
+
+    const int count = 200;
+    auto megabytes = static_cast<double>(frame.size()) * count / (1024 * 1024);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        auto pos = frame.find(record_separator);
+        while (pos != std::string::npos)
+        {
+            ++found;
+            pos = frame.find(record_separator, pos + 1);
+        }
+    }
+    report("MB/s (std::string::find, no validation)", megabytes / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), "");
+
+    const std::pair<const char*, text_scanner::scan_function> implementations[] =
+    {
+        { "portable", &text_scanner::scan_portable },
+        { "sse2", text_scanner::sse2() },
+        { "avx2", text_scanner::avx2() }
+    };
+
+    std::vector<size_t> separators;
+    for (auto& implementation : implementations)
+    {
+        if (implementation.second == nullptr)
+        {
+            report(std::string("MB/s (") + implementation.first + ", not supported)", 0, "");
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            separators.clear();
+            implementation.second(frame.data(), frame.size(), record_separator, separators);
+        }
+        report(std::string("MB/s (") + implementation.first + ")", megabytes / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), "");
+
+        if (separators.size() * count != found)
+        {
+            report("separators missed", static_cast<double>(found - separators.size() * count), "");
+        }
+    }
+}
+
+// Taking complete messages out of a stream of text frames, for frames that end where a message ends and for frames of a
+// fixed size that end in the middle of messages.
+BENCHMARK(message_framer, take_messages)
+{
+    std::string stream;
+    std::vector<size_t> message_ends;
+    while (stream.size() < 512 * 1024)
+    {
+        stream += typical_messages[message_ends.size() % 3].second;
+        message_ends.push_back(stream.size());
+    }
+
+    const int count = 50;
+    auto megabytes = static_cast<double>(stream.size()) * count / (1024 * 1024);
+
+    for (size_t frame_size : { static_cast<size_t>(0), static_cast<size_t>(1024), static_cast<size_t>(100) })
+    {
+        // the frames are created up front so only the framer is measured
+        std::vector<std::string> frames;
+        size_t start = 0;
+        for (auto end : message_ends)
+        {
+            if (frame_size == 0)
+            {
+                frames.push_back(stream.substr(start, end - start));
+                start = end;
+            }
+        }
+        for (; frame_size != 0 && start < stream.size(); start += frame_size)
+        {
+            frames.push_back(stream.substr(start, frame_size));
+        }
+
+        size_t taken = 0;
+        std::chrono::steady_clock::duration elapsed{};
+        for (int i = 0; i < count; ++i)
+        {
+            auto copies = frames;
+            message_framer framer(transfer_format::text);
+            auto begin = std::chrono::steady_clock::now();
+            for (auto& frame : copies)
+            {
+                framer.append(std::move(frame));
+                taken += framer.take_messages().size();
+            }
+            elapsed += std::chrono::steady_clock::now() - begin;
+        }
+
+        auto label = frame_size == 0 ? std::string("whole messages") : std::to_string(frame_size) + " byte frames";
+        if (taken != stream.size() * count)
+        {
+            report("bytes lost (" + label + ")", static_cast<double>(stream.size() * count - taken), "");
+        }
+        report("MB/s (" + label + ")", megabytes / std::chrono::duration<double>(elapsed).count(), "");
+    }
+}
+
+#ifdef USE_MSGPACK
+// Parsing small MessagePack messages, through messagepack_hub_protocol and the way it used to be done: an unpacker per
+// message with the message copied into it.
+BENCHMARK(messagepack_hub_protocol, parse_messages)
+{
+    messagepack_hub_protocol protocol;
+
+    // [1, {}, nil, "ReceiveMessage", ["user-1234", "Hello"]] and [3, {}, "1337", 3, 42], each with its length prefix
+    const std::pair<const char*, std::string> messages[] =
+    {
+        { "invocation", std::string("\x24\x95\x01\x80\xC0\xAE" "ReceiveMessage" "\x92\xA9" "user-1234" "\xA5" "Hello", 37) },
+        { "completion", std::string("\x0A\x95\x03\x80\xA4" "1337" "\x03\x2A", 11) },
+        { "ping", std::string("\x02\x91\x06", 3) }
+    };
+
+    for (auto& message : messages)
+    {
+        measure(std::string(" (") + message.first + ", unpacker per message)", message.second, [](const std::string& payload)
+            {
+                size_t length_prefix_length;
+                size_t length_of_message;
+                binary_message_parser::try_parse_message(reinterpret_cast<const unsigned char*>(payload.data()), payload.size(),
+                    &length_prefix_length, &length_of_message);
+
+                msgpack::unpacker pac;
+                pac.reserve_buffer(length_of_message);
+                memcpy(pac.buffer(), payload.data() + length_prefix_length, length_of_message);
+                pac.buffer_consumed(length_of_message);
+                msgpack::object_handle obj_handle;
+                pac.next(obj_handle);
+                return static_cast<size_t>(obj_handle.get().via.array.size);
+            });
+        measure(std::string(" (") + message.first + ")", message.second, [&protocol](const std::string& payload)
+            {
+                return protocol.parse_messages(payload).size();
+            });
+    }
+}
+#endif
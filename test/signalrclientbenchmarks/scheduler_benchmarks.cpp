@@ -0,0 +1,258 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include "signalr_default_scheduler.h"
+#include "strand.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace signalr;
+
+// How late delayed callbacks run compared to the deadline they were scheduled for.
+BENCHMARK(scheduler, delayed_callback_lateness)
+{
+    const int count = 2000;
+    signalr_default_scheduler scheduler;
+
+    std::mutex samples_lock;
+    std::vector<double> lateness_us;
+    lateness_us.reserve(count);
+    auto done = std::make_shared<std::promise<void>>();
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> delay_ms(1, 250);
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto delay = std::chrono::milliseconds(delay_ms(random));
+        auto deadline = std::chrono::steady_clock::now() + delay;
+        scheduler.schedule([deadline, &samples_lock, &lateness_us, done]()
+            {
+                auto late = std::chrono::steady_clock::now() - deadline;
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock(samples_lock);
+                    lateness_us.push_back(std::chrono::duration<double, std::micro>(late).count());
+                    last = lateness_us.size() == static_cast<size_t>(count);
+                }
+                if (last)
+                {
+                    done->set_value();
+                }
+            }, delay);
+    }
+
+    done->get_future().get();
+    report("lateness", summarize(lateness_us), "us");
+}
+
+// CPU consumed while many delayed callbacks are registered but none are due.
+BENCHMARK(scheduler, idle_cpu_with_pending_timers)
+{
+    const int pending = 5000;
+    const auto idle_period = std::chrono::seconds(2);
+
+    auto scheduler = std::make_shared<signalr_default_scheduler>();
+    for (int i = 0; i < pending; ++i)
+    {
+        // far enough out that nothing becomes due during the measurement, the benchmark process exits before they run
+        scheduler->schedule([]() {}, std::chrono::minutes(10) + std::chrono::milliseconds(i));
+    }
+
+    // let the dispatcher settle before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto cpu_before = process_cpu_time();
+    std::this_thread::sleep_for(idle_period);
+    auto cpu_used = process_cpu_time() - cpu_before;
+
+    report("pending timers", pending, "");
+    report("cpu while idle", std::chrono::duration<double, std::milli>(cpu_used).count(), "ms");
+    report("cpu while idle (fraction of one core)",
+        std::chrono::duration<double>(cpu_used).count() / std::chrono::duration<double>(idle_period).count(), "");
+}
+
+// Cost of scheduling callbacks with a delay, which is what every timer in the library does.
+BENCHMARK(scheduler, schedule_delayed_throughput)
+{
+    const int count = 100000;
+    signalr_default_scheduler scheduler;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        scheduler.schedule([]() {}, std::chrono::minutes(10) + std::chrono::milliseconds(i % 1000));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    report("schedule (delayed)", std::chrono::duration<double, std::nano>(elapsed).count() / count, "ns/op");
+}
+
+// Round trip of a callback scheduled with no delay, from the schedule call to the callback starting.
+BENCHMARK(scheduler, immediate_callback_latency)
+{
+    const int count = 10000;
+    signalr_default_scheduler scheduler;
+
+    std::vector<double> latency_us;
+    latency_us.reserve(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto ran = std::make_shared<std::promise<std::chrono::steady_clock::time_point>>();
+        auto start = std::chrono::steady_clock::now();
+        scheduler.schedule([ran]()
+            {
+                ran->set_value(std::chrono::steady_clock::now());
+            });
+        auto end = ran->get_future().get();
+        latency_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    report("schedule to run", summarize(latency_us), "us");
+}
+
+// Throughput of CPU bound callbacks, with the old fixed worker count compared to one worker per hardware thread.
+BENCHMARK(scheduler, cpu_bound_callback_throughput)
+{
+    const int count = 20000;
+    const size_t thread_counts[] = { 5, 0 };
+
+    for (auto thread_count : thread_counts)
+    {
+        thread_pool_options options;
+        options.thread_count = thread_count;
+        signalr_default_scheduler scheduler(options);
+
+        std::atomic<int> remaining(count);
+        auto done = std::make_shared<std::promise<void>>();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            scheduler.schedule([&remaining, done]()
+                {
+                    // roughly 50us of work
+                    volatile double sink = 0;
+                    for (int j = 0; j < 20000; ++j)
+                    {
+                        sink = sink + j * 0.5;
+                    }
+
+                    if (--remaining == 0)
+                    {
+                        done->set_value();
+                    }
+                });
+        }
+        done->get_future().get();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto label = thread_count == 0 ? std::string("callbacks/s (default workers)") : std::string("callbacks/s (5 workers)");
+        report(label, count / std::chrono::duration<double>(elapsed).count(), "");
+    }
+}
+
+// Overhead of scheduler metrics on tiny callbacks, where it is most visible.
+BENCHMARK(scheduler, metrics_overhead)
+{
+    const int count = 200000;
+    const bool metrics_enabled[] = { false, true };
+
+    for (auto enabled : metrics_enabled)
+    {
+        signalr_default_scheduler scheduler;
+        if (enabled)
+        {
+            scheduler.enable_metrics();
+        }
+
+        std::atomic<int> remaining(count);
+        auto done = std::make_shared<std::promise<void>>();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            scheduler.schedule([&remaining, done]()
+                {
+                    if (--remaining == 0)
+                    {
+                        done->set_value();
+                    }
+                });
+        }
+        done->get_future().get();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        report(enabled ? "callbacks/s (metrics enabled)" : "callbacks/s (metrics disabled)",
+            count / std::chrono::duration<double>(elapsed).count(), "");
+
+        if (enabled)
+        {
+            scheduler_metrics metrics;
+            scheduler.get_metrics(metrics);
+            report("peak queue depth", static_cast<double>(metrics.peak_queue_depth), "");
+            report("mean dispatch latency", static_cast<double>(metrics.dispatch_latency.total.count()) / metrics.dispatch_latency.count, "us");
+        }
+    }
+}
+
+// Heap allocations per callback going through a strand on the default scheduler, with the callback handed over as a
+// std::function and as a task. The callback captures a couple of shared_ptrs like the library's own callbacks do.
+BENCHMARK(scheduler, allocations_per_callback)
+{
+    const int count = 200000;
+    const bool use_task[] = { false, true };
+
+    for (auto as_task : use_task)
+    {
+        auto scheduler = std::make_shared<signalr_default_scheduler>();
+        auto callback_strand = strand::create(scheduler);
+
+        auto state = std::make_shared<std::atomic<int>>(count);
+        auto done = std::make_shared<std::promise<void>>();
+        auto future = done->get_future();
+
+        // warms up the queues so their growth isn't counted
+        for (int i = 0; i < 1000; ++i)
+        {
+            callback_strand->schedule_task(task([]() {}));
+        }
+
+        auto allocations_before = allocation_count();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            auto callback = [state, done, i]()
+            {
+                if (--(*state) == 0)
+                {
+                    done->set_value();
+                }
+            };
+
+            if (as_task)
+            {
+                callback_strand->schedule_task(task(std::move(callback)));
+            }
+            else
+            {
+                callback_strand->schedule(signalr_base_cb(std::move(callback)));
+            }
+        }
+        future.get();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto allocations = allocation_count() - allocations_before;
+
+        report(as_task ? "allocations/callback (task)" : "allocations/callback (std::function)",
+            static_cast<double>(allocations) / count, "");
+        report(as_task ? "callbacks/s (task)" : "callbacks/s (std::function)",
+            count / std::chrono::duration<double>(elapsed).count(), "");
+    }
+}
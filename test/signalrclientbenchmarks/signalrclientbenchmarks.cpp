@@ -0,0 +1,26 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include <cstdio>
+#include <cstring>
+
+// Runs every registered benchmark, or only the ones whose name contains the first command line argument.
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    for (const auto& benchmark : get_registered_benchmarks())
+    {
+        if (filter != nullptr && std::strstr(benchmark.name.c_str(), filter) == nullptr)
+        {
+            continue;
+        }
+
+        std::printf("%s\n", benchmark.name.c_str());
+        benchmark.func();
+    }
+
+    return 0;
+}
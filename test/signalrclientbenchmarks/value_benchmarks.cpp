@@ -0,0 +1,169 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark_utils.h"
+#include "json_reader.h"
+#include "value_arena.h"
+#include "signalrclient/signalr_value.h"
+#include <map>
+
+using namespace signalr;
+
+namespace
+{
+    const char* const quote_members[] = { "symbol", "price", "change", "volume", "bid", "ask", "halted", "tags" };
+
+    // an argument like the ones market data hubs send: an array of quotes, objects of a few short members each
+    std::string create_quotes_json(int count)
+    {
+        std::string json = "[";
+        for (int i = 0; i < count; ++i)
+        {
+            if (i != 0)
+            {
+                json += ",";
+            }
+            json += "{\"symbol\":\"SYM" + std::to_string(i) + "\",\"price\":412.37,\"change\":-1.25,\"volume\":18234500,"
+                "\"bid\":412.30,\"ask\":412.41,\"halted\":false,\"tags\":[\"tech\",\"nasdaq\"]}";
+        }
+        return json + "]";
+    }
+
+    signalr::value read_value(const std::string& json)
+    {
+        json_reader reader(json.data(), json.size());
+        signalr::value value;
+        reader.read_value(value);
+        return value;
+    }
+
+    template <typename Map>
+    size_t look_up_members(const std::vector<Map>& maps)
+    {
+        size_t found = 0;
+        for (auto& map : maps)
+        {
+            for (auto name : quote_members)
+            {
+                found += map.find(name) != map.end() ? 1 : 0;
+            }
+        }
+        return found;
+    }
+}
+
+// The size of a value, which is the size of every element of an array and every member of a map.
+BENCHMARK(value, layout)
+{
+    report("sizeof(signalr::value)", static_cast<double>(sizeof(signalr::value)), "bytes");
+}
+
+// Reading an array of quote objects into a value tree.
+BENCHMARK(value, decode)
+{
+    const auto json = create_quotes_json(20);
+    const int count = 20000;
+
+    size_t checksum = 0;
+    auto allocations_before = allocation_count();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        checksum += read_value(json).as_value_array().size();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto allocations = allocation_count() - allocations_before;
+
+    if (checksum == 0)
+    {
+        report("nothing was decoded", 0, "");
+    }
+    report("arrays/s", count / std::chrono::duration<double>(elapsed).count(), "");
+    report("allocations/array", static_cast<double>(allocations) / count, "");
+
+    // the same with the arena, released after each array like the connection releases it after each frame
+    value_arena arena;
+    allocations_before = allocation_count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        {
+            value_arena::scope scope(&arena);
+            checksum += read_value(json).as_value_array().size();
+        }
+        arena.release();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    allocations = allocation_count() - allocations_before;
+
+    report("arrays/s (arena)", count / std::chrono::duration<double>(elapsed).count(), "");
+    report("allocations/array (arena)", static_cast<double>(allocations) / count, "");
+}
+
+// Looking members up by name in the quotes, through the value's map and through the std::map it used to be.
+BENCHMARK(value, access)
+{
+    const auto quotes = read_value(create_quotes_json(20));
+    std::vector<value_map> maps;
+    std::vector<std::map<std::string, signalr::value>> std_maps;
+    for (auto& quote : quotes.as_value_array())
+    {
+        maps.push_back(quote.as_value_map());
+        std_maps.push_back(quote.as_value_map());
+    }
+
+    const int count = 20000;
+    const auto lookups = static_cast<double>(count) * maps.size() * (sizeof(quote_members) / sizeof(quote_members[0]));
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        found += look_up_members(std_maps);
+    }
+    report("lookups/s (std::map)", lookups / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), "");
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        found += look_up_members(maps);
+    }
+    report("lookups/s", lookups / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), "");
+
+    if (found != 2 * lookups)
+    {
+        report("members missed", 2 * lookups - found, "");
+    }
+}
+
+// Freeing decoded quotes, as value trees and as the std::map trees they used to be.
+BENCHMARK(value, destruction)
+{
+    const auto quotes = read_value(create_quotes_json(20));
+    const int count = 2000;
+
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < count; ++i)
+    {
+        std::vector<std::map<std::string, signalr::value>> std_maps;
+        for (auto& quote : quotes.as_value_array())
+        {
+            std_maps.push_back(quote.as_value_map());
+        }
+        auto begin = std::chrono::steady_clock::now();
+        std_maps.clear();
+        elapsed += std::chrono::steady_clock::now() - begin;
+    }
+    report("arrays/s (std::map)", count / std::chrono::duration<double>(elapsed).count(), "");
+
+    elapsed = std::chrono::steady_clock::duration{};
+    for (int i = 0; i < count; ++i)
+    {
+        auto copy = quotes;
+        auto begin = std::chrono::steady_clock::now();
+        copy = signalr::value();
+        elapsed += std::chrono::steady_clock::now() - begin;
+    }
+    report("arrays/s", count / std::chrono::duration<double>(elapsed).count(), "");
+}
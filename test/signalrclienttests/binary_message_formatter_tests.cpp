@@ -38,6 +38,30 @@ TEST(write_length_prefix, writes_correct_prefix)
     ASSERT_EQ(0x01, (unsigned char)payload[2]);
 }
 
+TEST(write_length_prefix, writes_prefix_into_reserved_space)
+{
+    // space for the prefix that is the right size, too small and too big
+    for (size_t reserved_length = 0; reserved_length <= 5; ++reserved_length)
+    {
+        auto payload = std::string(reserved_length, 'x') + std::string(500, 'c');
+        binary_message_formatter::write_length_prefix(payload, reserved_length);
+        ASSERT_EQ(502, payload.length()) << reserved_length;
+        ASSERT_EQ(0xF4, (unsigned char)payload[0]) << reserved_length;
+        ASSERT_EQ(0x03, (unsigned char)payload[1]) << reserved_length;
+        ASSERT_EQ(std::string(500, 'c'), payload.substr(2)) << reserved_length;
+    }
+}
+
+TEST(length_prefix_length, is_the_length_of_the_prefix_written)
+{
+    for (size_t length : { 0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0xC0DE, 0x1FFFFF, 0x200000 })
+    {
+        auto payload = std::string(length, 'c');
+        binary_message_formatter::write_length_prefix(payload);
+        ASSERT_EQ(payload.length() - length, binary_message_formatter::length_prefix_length(length)) << length;
+    }
+}
+
 std::string create_payload(size_t size)
 {
     std::string payload;
@@ -130,3 +130,183 @@ TEST(callback_manager_dtor, clear_invokes_all_callbacks)
 
     ASSERT_EQ(10, invocation_count);
 }
+
+TEST(callback_manager_invoke_callback, invoke_callback_finds_callback_by_its_string_id)
+{
+    callback_manager callback_mgr{ "" };
+
+    auto callback_called = false;
+    auto callback_id = callback_mgr.register_callback(
+        [&callback_called](const char*, const signalr::value&)
+        {
+            callback_called = true;
+        });
+
+    char buffer[callback_manager::max_callback_id_length];
+    std::string id(buffer, callback_manager::format_callback_id(callback_id, buffer));
+
+    ASSERT_TRUE(callback_mgr.invoke_callback(id, nullptr, signalr::value(), true));
+    ASSERT_TRUE(callback_called);
+    ASSERT_FALSE(callback_mgr.remove_callback(id));
+}
+
+TEST(callback_manager_invoke_callback, invoke_callback_returns_false_for_malformed_callback_ids)
+{
+    callback_manager callback_mgr{ "" };
+    callback_mgr.register_callback([](const char*, const signalr::value&) {});
+
+    ASSERT_FALSE(callback_mgr.invoke_callback("", nullptr, signalr::value(), false));
+    ASSERT_FALSE(callback_mgr.invoke_callback("00", nullptr, signalr::value(), false));
+    ASSERT_FALSE(callback_mgr.invoke_callback("-0", nullptr, signalr::value(), false));
+    ASSERT_FALSE(callback_mgr.invoke_callback("0x0", nullptr, signalr::value(), false));
+    ASSERT_FALSE(callback_mgr.invoke_callback("18446744073709551616", nullptr, signalr::value(), false));
+    ASSERT_TRUE(callback_mgr.invoke_callback("0", nullptr, signalr::value(), false));
+}
+
+TEST(callback_manager_invoke_callback, completed_callback_id_does_not_find_callback_registered_after_it)
+{
+    callback_manager callback_mgr{ "" };
+
+    std::vector<uint64_t> completed;
+    for (auto i = 0; i < 100; i++)
+    {
+        auto callback_id = callback_mgr.register_callback([](const char*, const signalr::value&) {});
+        ASSERT_TRUE(callback_mgr.invoke_callback(callback_id, nullptr, signalr::value(), true));
+        completed.push_back(callback_id);
+    }
+
+    auto callback_called = false;
+    auto callback_id = callback_mgr.register_callback(
+        [&callback_called](const char*, const signalr::value&)
+        {
+            callback_called = true;
+        });
+
+    for (auto id : completed)
+    {
+        ASSERT_NE(id, callback_id);
+        ASSERT_FALSE(callback_mgr.invoke_callback(id, nullptr, signalr::value(), true));
+    }
+    ASSERT_FALSE(callback_called);
+}
+
+TEST(callback_manager_invoke_callback, long_running_callback_stays_registered_while_others_come_and_go)
+{
+    callback_manager callback_mgr{ "" };
+
+    auto long_running_calls = 0;
+    auto long_running_id = callback_mgr.register_callback(
+        [&long_running_calls](const char*, const signalr::value&)
+        {
+            long_running_calls++;
+        });
+
+    std::vector<uint64_t> outstanding;
+    for (auto i = 0; i < 1000; i++)
+    {
+        outstanding.push_back(callback_mgr.register_callback([](const char*, const signalr::value&) {}));
+        if (outstanding.size() == 50)
+        {
+            for (auto id : outstanding)
+            {
+                ASSERT_TRUE(callback_mgr.invoke_callback(id, nullptr, signalr::value(), true));
+            }
+            outstanding.clear();
+        }
+    }
+
+    ASSERT_EQ(0, long_running_calls);
+    ASSERT_TRUE(callback_mgr.invoke_callback(long_running_id, nullptr, signalr::value(), true));
+    ASSERT_EQ(1, long_running_calls);
+}
+
+TEST(callback_manager_clear, clear_invokes_callbacks_outside_of_the_lock)
+{
+    callback_manager callback_mgr{ "" };
+
+    uint64_t registered_during_clear = 0;
+    callback_mgr.register_callback(
+        [&callback_mgr, &registered_during_clear](const char*, const signalr::value&)
+        {
+            registered_during_clear = callback_mgr.register_callback([](const char*, const signalr::value&) {});
+        });
+
+    callback_mgr.clear("clearing callback");
+
+    ASSERT_NE(0u, registered_during_clear);
+    ASSERT_TRUE(callback_mgr.remove_callback(registered_during_clear));
+}
+
+TEST(callback_manager_format_callback_id, formats_decimal_ids_that_parse_back)
+{
+    char buffer[callback_manager::max_callback_id_length];
+    for (uint64_t id : { uint64_t(0), uint64_t(7), uint64_t(10), uint64_t(1234567890), UINT64_MAX })
+    {
+        std::string text(buffer, callback_manager::format_callback_id(id, buffer));
+        ASSERT_EQ(std::to_string(id), text);
+
+        uint64_t parsed;
+        ASSERT_TRUE(callback_manager::parse_callback_id(text, parsed));
+        ASSERT_EQ(id, parsed);
+    }
+}
+
+TEST(callback_manager_expire, expire_removes_callbacks_whose_deadline_passed_and_invokes_on_expired)
+{
+    callback_manager callback_mgr{ "" };
+    auto start = callback_manager::clock::time_point();
+
+    std::vector<int> expired;
+    auto invoked = false;
+    for (auto i = 3; i > 0; i--)
+    {
+        callback_mgr.register_callback(
+            [&invoked](const char*, const signalr::value&)
+            {
+                invoked = true;
+            }, start + std::chrono::seconds(i),
+            [&expired, i]()
+            {
+                expired.push_back(i);
+            });
+    }
+    auto no_deadline = callback_mgr.register_callback([](const char*, const signalr::value&) {});
+
+    ASSERT_EQ(start + std::chrono::seconds(1), callback_mgr.next_deadline());
+    ASSERT_EQ(0u, callback_mgr.expire(start));
+    ASSERT_EQ(4u, callback_mgr.size());
+
+    ASSERT_EQ(2u, callback_mgr.expire(start + std::chrono::seconds(2)));
+    ASSERT_EQ((std::vector<int>{ 1, 2 }), expired);
+    ASSERT_EQ(2u, callback_mgr.size());
+    ASSERT_EQ(start + std::chrono::seconds(3), callback_mgr.next_deadline());
+
+    ASSERT_EQ(1u, callback_mgr.expire(start + std::chrono::hours(1)));
+    ASSERT_EQ((std::vector<int>{ 1, 2, 3 }), expired);
+    ASSERT_FALSE(invoked);
+    ASSERT_EQ(callback_manager::clock::time_point::max(), callback_mgr.next_deadline());
+    ASSERT_TRUE(callback_mgr.remove_callback(no_deadline));
+    ASSERT_EQ(0u, callback_mgr.size());
+}
+
+TEST(callback_manager_expire, callbacks_invoked_before_their_deadline_dont_expire)
+{
+    callback_manager callback_mgr{ "" };
+    auto start = callback_manager::clock::time_point();
+
+    auto calls = 0;
+    for (auto i = 0; i < 1000; i++)
+    {
+        auto callback_id = callback_mgr.register_callback(
+            [&calls](const char*, const signalr::value&)
+            {
+                calls++;
+            }, start + std::chrono::seconds(1));
+        ASSERT_TRUE(callback_mgr.invoke_callback(callback_id, nullptr, signalr::value(), true));
+    }
+
+    ASSERT_EQ(1000, calls);
+    ASSERT_EQ(callback_manager::clock::time_point::max(), callback_mgr.next_deadline());
+    ASSERT_EQ(0u, callback_mgr.expire(start + std::chrono::seconds(1)));
+    ASSERT_EQ(1000, calls);
+}
@@ -1291,6 +1291,48 @@ TEST(connection_impl_set_message_received, non_std_exception_from_callback_caugh
     ASSERT_TRUE(has_log_entry("[error    ] message_received callback threw an unknown exception\n", log_entries)) << dump_vector(log_entries);
 }
 
+TEST(connection_impl_set_message_received, caller_runs_mode_does_not_wait_for_strand)
+{
+    auto websocket_client = create_test_websocket_client();
+    auto connection = create_connection(websocket_client);
+
+    signalr_client_config config;
+    config.set_callback_mode(callback_mode::caller_runs);
+    connection->set_client_config(config);
+
+    auto message_received_event = std::make_shared<cancellation_token_source>();
+    connection->set_message_received([message_received_event](const std::string& m)
+        {
+            if (m == "Test")
+            {
+                message_received_event->cancel();
+            }
+        });
+
+    auto mre = manual_reset_event<void>();
+    connection->start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    mre.get();
+
+    // keep the strand busy, in scheduled mode the message would be queued behind this callback
+    auto blocked = std::make_shared<manual_reset_event<void>>();
+    auto unblock = std::make_shared<manual_reset_event<void>>();
+    connection->get_strand()->schedule([blocked, unblock]()
+        {
+            blocked->set();
+            unblock->get();
+        });
+    blocked->get();
+
+    websocket_client->receive_message("Test");
+
+    ASSERT_FALSE(message_received_event->wait(5000));
+    unblock->set();
+}
+
 void can_be_set_only_in_disconnected_state(std::function<void(connection_impl*)> callback, const char* expected_exception_message)
 {
     auto websocket_client = create_test_websocket_client();
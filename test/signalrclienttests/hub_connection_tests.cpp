@@ -9,8 +9,10 @@
 #include "memory_log_writer.h"
 #include "signalrclient/hub_exception.h"
 #include "signalrclient/signalr_exception.h"
+#include "signalrclient/timeout_exception.h"
 #include "test_websocket_client.h"
 #include "hub_connection_impl.h"
+#include <algorithm>
 #include <atomic>
 
 using namespace signalr;
@@ -206,6 +208,66 @@ TEST(start, start_waits_for_handshake_response)
     ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
 }
 
+TEST(start, start_callback_can_wait_on_an_invocation_result)
+{
+    auto invocation_sent = std::make_shared<cancellation_token_source>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [invocation_sent](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            if (msg.find("\"type\":1") != std::string::npos)
+            {
+                invocation_sent->cancel();
+            }
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    // the callback runs after the handshake response has been processed, the result it waits on has to be processed on the
+    // same strand
+    auto mre = manual_reset_event<signalr::value>();
+    hub_connection.start([&mre, &hub_connection](std::exception_ptr exception)
+    {
+        if (exception)
+        {
+            mre.set(exception);
+            return;
+        }
+
+        auto result = std::make_shared<std::promise<signalr::value>>();
+        hub_connection.invoke("method", std::vector<signalr::value>(), [result](const signalr::value& message, std::exception_ptr exception)
+        {
+            if (exception)
+            {
+                result->set_exception(exception);
+            }
+            else
+            {
+                result->set_value(message);
+            }
+        });
+
+        auto result_future = result->get_future();
+        if (result_future.wait_for(std::chrono::seconds(5)) != std::future_status::ready)
+        {
+            mre.set(std::make_exception_ptr(std::runtime_error("the invocation result wasn't delivered while the start callback was waiting")));
+            return;
+        }
+        mre.set(result_future.get());
+    });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{}\x1e");
+
+    ASSERT_FALSE(invocation_sent->wait(5000));
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"result\": \"abc\" }\x1e");
+
+    auto result = mre.get();
+    ASSERT_TRUE(result.is_string());
+    ASSERT_EQ("abc", result.as_string());
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
+}
+
 TEST(start, start_fails_for_handshake_response_with_error)
 {
     auto websocket_client = create_test_websocket_client();
@@ -313,7 +375,7 @@ TEST(start, on_not_called_if_multiple_messages_received_before_handshake)
     ASSERT_FALSE(on_called);
 }
 
-TEST(start, start_fails_for_incomplete_handshake_response)
+TEST(start, start_waits_for_the_rest_of_an_incomplete_handshake_response)
 {
     auto websocket_client = create_test_websocket_client();
     auto hub_connection = create_hub_connection(websocket_client);
@@ -326,19 +388,12 @@ TEST(start, start_fails_for_incomplete_handshake_response)
 
     ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
     ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
-    websocket_client->receive_message("{}");
-
-    try
-    {
-        mre.get();
-        ASSERT_TRUE(false);
-    }
-    catch (const std::exception & ex)
-    {
-        ASSERT_STREQ("connection closed while handshake was in progress.", ex.what());
-    }
+    websocket_client->receive_message("{");
+    websocket_client->receive_message("}");
+    websocket_client->receive_message("\x1e");
 
-    ASSERT_EQ(connection_state::disconnected, hub_connection.get_connection_state());
+    mre.get();
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
 }
 
 TEST(start, start_fails_for_invalid_json_handshake_response)
@@ -400,24 +455,35 @@ TEST(start, start_fails_if_stop_called_before_handshake_response)
 
 TEST(start, start_fails_if_handshake_times_out)
 {
+    auto scheduler = std::make_shared<virtual_scheduler>();
     auto websocket_client = create_test_websocket_client();
     auto hub_connection = create_hub_connection(websocket_client);
     auto config = signalr_client_config();
+    config.set_scheduler(scheduler);
     config.set_handshake_timeout(std::chrono::seconds(1));
     hub_connection.set_client_config(config);
 
-    auto mre = manual_reset_event<void>();
-    hub_connection.start([&mre](std::exception_ptr exception)
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    hub_connection.start([&started](std::exception_ptr exception)
         {
-            mre.set(exception);
+            started.set_exception(exception);
         });
 
-    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
-    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    ASSERT_TRUE(scheduler->run_until([&websocket_client]()
+        {
+            return websocket_client->handshake_sent.wait(0) == 0;
+        }));
+
+    scheduler->advance(std::chrono::milliseconds(999));
+    ASSERT_NE(std::future_status::ready, started_future.wait_for(std::chrono::seconds(0)));
+
+    scheduler->advance(std::chrono::milliseconds(1));
+    ASSERT_TRUE(run_until_ready(*scheduler, started_future));
 
     try
     {
-        mre.get();
+        started_future.get();
         ASSERT_TRUE(false);
     }
     catch (const std::exception& ex)
@@ -691,6 +757,128 @@ TEST(stop, blocking_stop_callback_does_not_prevent_start)
     mre.get();
 }
 
+TEST(stop, start_waits_for_the_disconnect_queued_behind_a_running_callback)
+{
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    auto disconnected_count = std::make_shared<std::atomic<int>>(0);
+    auto disconnected = std::make_shared<cancellation_token_source>();
+    hub_connection.set_disconnected([disconnected_count, disconnected](std::exception_ptr)
+        {
+            ++*disconnected_count;
+            disconnected->cancel();
+        });
+
+    auto mre = manual_reset_event<void>();
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{}\x1e");
+    mre.get();
+
+    // the timeout completes the invocation on the connection's strand on a scheduler thread, which leaves the receive loop
+    // free so stop can complete while the callback is running
+    auto callback_running = manual_reset_event<void>();
+    auto unblock_callback = manual_reset_event<void>();
+    hub_connection.invoke("method", std::vector<signalr::value>(), [&callback_running, &unblock_callback](const signalr::value&, std::exception_ptr)
+        {
+            callback_running.set();
+            unblock_callback.get();
+        }, std::chrono::milliseconds(10));
+    callback_running.get();
+
+    hub_connection.stop([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    mre.get();
+    // the disconnect is queued behind the callback
+    ASSERT_EQ(0, disconnected_count->load());
+
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    ASSERT_EQ(connection_state::connecting, hub_connection.get_connection_state());
+
+    unblock_callback.set();
+    ASSERT_FALSE(disconnected->wait(5000));
+
+    // the disconnect of the previous connection would fail this handshake if it ran after the start
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{}\x1e");
+    mre.get();
+
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
+    ASSERT_EQ(1, disconnected_count->load());
+}
+
+TEST(stop, stop_cancels_start_waiting_for_the_previous_disconnect)
+{
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    auto mre = manual_reset_event<void>();
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{}\x1e");
+    mre.get();
+
+    auto callback_running = manual_reset_event<void>();
+    auto unblock_callback = manual_reset_event<void>();
+    auto callback_done = manual_reset_event<void>();
+    hub_connection.invoke("method", std::vector<signalr::value>(), [&callback_running, &unblock_callback, &callback_done](const signalr::value&, std::exception_ptr)
+        {
+            callback_running.set();
+            unblock_callback.get();
+            callback_done.set();
+        }, std::chrono::milliseconds(10));
+    callback_running.get();
+
+    hub_connection.stop([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    mre.get();
+
+    auto start_mre = manual_reset_event<void>();
+    hub_connection.start([&start_mre](std::exception_ptr exception)
+        {
+            start_mre.set(exception);
+        });
+
+    // stop doesn't wait for the callback the start is queued behind
+    hub_connection.stop([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    mre.get();
+    ASSERT_EQ(connection_state::disconnected, hub_connection.get_connection_state());
+
+    try
+    {
+        start_mre.get();
+        ASSERT_TRUE(false);
+    }
+    catch (const canceled_exception&)
+    { }
+
+    unblock_callback.set();
+    // avoids referencing the events after they've been destructed
+    callback_done.get();
+}
+
 TEST(stop, disconnected_callback_called_when_hub_connection_stops)
 {
     auto websocket_client = create_test_websocket_client();
@@ -1072,6 +1260,44 @@ TEST(hub_invocation, hub_connection_can_receive_multiple_messages_in_same_payloa
     ASSERT_EQ(2, count);
 }
 
+TEST(hub_invocation, hub_connection_can_receive_messages_split_across_payloads)
+{
+    auto websocket_client = create_test_websocket_client();
+
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    auto payloads = std::make_shared<std::vector<std::string>>();
+    auto on_broadcast_event = std::make_shared<cancellation_token_source>();
+    hub_connection.on("broadcast", [on_broadcast_event, payloads](const std::vector<signalr::value>& message)
+        {
+            payloads->push_back(message[0].as_string());
+            if (payloads->size() == 3)
+            {
+                on_broadcast_event->cancel();
+            }
+        });
+
+    auto mre = manual_reset_event<void>();
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    // the handshake response and the messages after it end in the middle of the payloads, including in the middle of a
+    // character, and one message takes three payloads
+    websocket_client->receive_message("{ }\x1e{ \"type\": 1, \"target\": \"broadcast\", \"argu");
+    websocket_client->receive_message("ments\": [ \"first\" ] }\x1e{ \"type\": 1, \"target\": \"broadcast\", \"arguments\": [ \"\xE2\x82");
+    websocket_client->receive_message("\xAC\" ] }");
+    websocket_client->receive_message("\x1e{ \"type\": 1, \"target\": \"broadcast\", \"arguments\": [ \"third\" ] }\x1e");
+
+    mre.get();
+    ASSERT_FALSE(on_broadcast_event->wait(5000));
+
+    ASSERT_EQ((std::vector<std::string>{ "first", "\xE2\x82\xAC", "third" }), *payloads);
+}
+
 TEST(hub_invocation, hub_connection_closes_when_invocation_response_missing_arguments)
 {
     auto websocket_client = create_test_websocket_client();
@@ -1738,88 +1964,841 @@ TEST(invoke, invoke_handles_zero_value_as_int)
         });
 }
 
-class test_scheduler : public scheduler
-{
-public:
-    virtual void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override
-    {
-        schedule_count++;
-        std::thread([cb, delay]()
-            {
-                std::this_thread::sleep_for(delay);
-                cb();
-            }).detach();
-    }
-
-    std::atomic<int> schedule_count{ 0 };
-};
-
-TEST(config, can_replace_scheduler)
+// starts the connection with its callbacks and timers running on the virtual scheduler
+void start_on_virtual_scheduler(hub_connection& hub_connection, const std::shared_ptr<test_websocket_client>& websocket_client,
+    const std::shared_ptr<virtual_scheduler>& scheduler, signalr_client_config config = signalr_client_config())
 {
-    auto websocket_client = create_test_websocket_client();
-    auto hub_connection = hub_connection_builder::create(create_uri())
-        .with_logging(std::make_shared<memory_log_writer>(), trace_level::verbose)
-        .with_http_client_factory(create_test_http_client())
-        .with_websocket_factory([websocket_client](const signalr_client_config& config)
-            {
-                websocket_client->set_config(config);
-                return websocket_client;
-            })
-        .build();
-
-    signalr_client_config config{};
-    auto scheduler = std::make_shared<test_scheduler>();
     config.set_scheduler(scheduler);
     hub_connection.set_client_config(config);
 
-    // do some "work" to verify scheduler is used
-
-    auto mre = manual_reset_event<void>();
-    hub_connection.start([&mre](std::exception_ptr exception)
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    hub_connection.start([&started](std::exception_ptr exception)
         {
-            mre.set(exception);
+            if (exception)
+            {
+                started.set_exception(exception);
+            }
+            else
+            {
+                started.set_value();
+            }
         });
 
-    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
-    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
-    websocket_client->receive_message("{ }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&websocket_client]()
+        {
+            return websocket_client->receive_loop_started.wait(0) == 0 && websocket_client->handshake_sent.wait(0) == 0;
+        }));
+    websocket_client->receive_message("{}\x1e");
 
-    mre.get();
+    ASSERT_TRUE(run_until_ready(*scheduler, started_future));
+    started_future.get();
+}
 
-    auto invoke_mre = manual_reset_event<void>();
-    hub_connection.invoke("method", std::vector<signalr::value>(), [&invoke_mre](const signalr::value& message, std::exception_ptr exception)
+// the connection has to be stopped before it is destroyed, destroying it blocks until it stopped and the virtual scheduler
+// wouldn't be driven
+void stop_on_virtual_scheduler(hub_connection& hub_connection, const std::shared_ptr<virtual_scheduler>& scheduler)
+{
+    std::promise<void> stopped;
+    auto stopped_future = stopped.get_future();
+    hub_connection.stop([&stopped](std::exception_ptr)
+        {
+            stopped.set_value();
+        });
+    ASSERT_TRUE(run_until_ready(*scheduler, stopped_future));
+}
+
+TEST(invoke, invoke_fails_with_timeout_exception_if_no_result_is_received_in_time)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+    std::promise<signalr::value> invoked;
+    auto invoked_future = invoked.get_future();
+    hub_connection.invoke("method", std::vector<signalr::value>(), [&invoked](const signalr::value& result, std::exception_ptr exception)
         {
             if (exception)
             {
-                invoke_mre.set(exception);
+                invoked.set_exception(exception);
             }
             else
             {
-                invoke_mre.set();
+                invoked.set_value(result);
             }
-        });
+        }, std::chrono::seconds(5));
+    ASSERT_EQ(1u, hub_connection.get_pending_invocation_count());
 
-    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"result\": \"abc\" }\x1e");
+    scheduler->advance(std::chrono::milliseconds(4999));
+    ASSERT_EQ(std::future_status::timeout, invoked_future.wait_for(std::chrono::milliseconds(0)));
+    ASSERT_EQ(1u, hub_connection.get_pending_invocation_count());
 
-    invoke_mre.get();
+    scheduler->advance(std::chrono::milliseconds(1));
+    ASSERT_TRUE(run_until_ready(*scheduler, invoked_future));
+    ASSERT_EQ(0u, hub_connection.get_pending_invocation_count());
 
-    hub_connection.stop([&mre](std::exception_ptr ex)
-        {
-            mre.set();
-        });
+    try
+    {
+        invoked_future.get();
+        ASSERT_TRUE(false);
+    }
+    catch (const timeout_exception& e)
+    {
+        ASSERT_STREQ("timed out waiting for the server to complete the invocation.", e.what());
+    }
 
-    mre.get();
+    // a result that arrives late is ignored
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"result\": \"abc\" }\x1e");
+    websocket_client->receive_message("{ \"type\": 6 }\x1e");
+    scheduler->run_until_idle();
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
 
-    // http_client->send (negotiate), websocket_client->start, handshake timeout timer, websocket_client->send, websocket_client->send, keep alive timer, websocket_client->send ping, websocket_client->stop
-    // handshake timeout timer can trigger more than once if test takes more than 1 second
-    ASSERT_GE(scheduler->schedule_count, 8);
+    stop_on_virtual_scheduler(hub_connection, scheduler);
 }
 
-class throw_hub_protocol : public hub_protocol
+TEST(invoke, invoke_that_timed_out_is_not_completed_again_when_its_send_fails)
 {
-    virtual std::string write_message(const hub_message* message) const override
-    {
-        if (message->message_type == message_type::ping)
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto send_callbacks = std::make_shared<std::vector<std::function<void(std::exception_ptr)>>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [send_callbacks](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            if (msg.find("\"type\":1") != std::string::npos)
+            {
+                send_callbacks->push_back(callback);
+                return;
+            }
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    auto calls = std::make_shared<std::atomic<int>>(0);
+    std::promise<void> invoked;
+    auto invoked_future = invoked.get_future();
+    hub_connection.invoke("method", std::vector<signalr::value>(), [calls, &invoked](const signalr::value&, std::exception_ptr exception)
+        {
+            if (++*calls == 1)
+            {
+                invoked.set_exception(exception);
+            }
+        }, std::chrono::seconds(5));
+
+    scheduler->advance(std::chrono::seconds(5));
+    ASSERT_TRUE(run_until_ready(*scheduler, invoked_future));
+    ASSERT_THROW(invoked_future.get(), timeout_exception);
+
+    ASSERT_EQ(1u, send_callbacks->size());
+    (*send_callbacks)[0](std::make_exception_ptr(std::runtime_error("send failed")));
+    scheduler->run_until_idle();
+    ASSERT_EQ(1, calls->load());
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(invoke, invoke_uses_invocation_timeout_from_config)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+    signalr_client_config config;
+    config.set_invocation_timeout(std::chrono::seconds(2));
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+
+    std::vector<std::promise<void>> invoked(3);
+    for (size_t i = 0; i < invoked.size(); ++i)
+    {
+        auto& promise = invoked[i];
+        auto callback = [&promise](const signalr::value&, std::exception_ptr exception)
+        {
+            if (exception)
+            {
+                promise.set_exception(exception);
+            }
+            else
+            {
+                promise.set_value();
+            }
+        };
+
+        if (i == 1)
+        {
+            // overrides the configured timeout
+            hub_connection.invoke("method", std::vector<signalr::value>(), callback, std::chrono::seconds(10));
+        }
+        else
+        {
+            hub_connection.invoke("method", std::vector<signalr::value>(), callback);
+        }
+    }
+    ASSERT_EQ(3u, hub_connection.get_pending_invocation_count());
+
+    // completes before the timeout
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"2\" }\x1e");
+    auto completed_future = invoked[2].get_future();
+    ASSERT_TRUE(run_until_ready(*scheduler, completed_future));
+    completed_future.get();
+
+    scheduler->advance(std::chrono::seconds(2));
+    auto timed_out_future = invoked[0].get_future();
+    ASSERT_TRUE(run_until_ready(*scheduler, timed_out_future));
+    ASSERT_THROW(timed_out_future.get(), timeout_exception);
+    ASSERT_EQ(1u, hub_connection.get_pending_invocation_count());
+
+    auto overridden_future = invoked[1].get_future();
+    scheduler->advance(std::chrono::seconds(7));
+    ASSERT_EQ(std::future_status::timeout, overridden_future.wait_for(std::chrono::milliseconds(0)));
+    scheduler->advance(std::chrono::seconds(1));
+    ASSERT_TRUE(run_until_ready(*scheduler, overridden_future));
+    ASSERT_THROW(overridden_future.get(), timeout_exception);
+    ASSERT_EQ(0u, hub_connection.get_pending_invocation_count());
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(flow_control, wait_holds_invocations_over_the_limit_until_pending_ones_complete)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    int ready_to_send = 0;
+    hub_connection.set_ready_to_send([&ready_to_send]()
+        {
+            ++ready_to_send;
+        });
+
+    signalr_client_config config;
+    config.set_max_pending_invocations(2);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+
+    std::vector<int> completed;
+    for (int i = 0; i < 4; ++i)
+    {
+        hub_connection.invoke("method", std::vector<signalr::value> { signalr::value((double)i) },
+            [&completed, i](const signalr::value&, std::exception_ptr exception)
+            {
+                // the last invocation is still pending when the connection stops
+                if (exception == nullptr)
+                {
+                    completed.push_back(i);
+                }
+            });
+    }
+
+    scheduler->run_until_idle();
+    // the handshake and the first two invocations
+    ASSERT_EQ(3u, messages->size());
+    ASSERT_EQ("{\"arguments\":[1],\"invocationId\":\"1\",\"target\":\"method\",\"type\":1}\x1e", (*messages)[2]);
+    ASSERT_EQ(2u, hub_connection.get_pending_invocation_count());
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&messages]() { return messages->size() == 4; }));
+    ASSERT_EQ("{\"arguments\":[2],\"invocationId\":\"2\",\"target\":\"method\",\"type\":1}\x1e", (*messages)[3]);
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"1\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&messages]() { return messages->size() == 5; }));
+    ASSERT_EQ("{\"arguments\":[3],\"invocationId\":\"3\",\"target\":\"method\",\"type\":1}\x1e", (*messages)[4]);
+    ASSERT_EQ(0, ready_to_send);
+
+    // below the limit with nothing held
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"2\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&ready_to_send]() { return ready_to_send == 1; }));
+    ASSERT_EQ((std::vector<int>{ 0, 1, 2 }), completed);
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(flow_control, reject_fails_invocations_over_the_limit_and_reports_ready_to_send)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    int ready_to_send = 0;
+    hub_connection.set_ready_to_send([&ready_to_send]()
+        {
+            ++ready_to_send;
+        });
+
+    signalr_client_config config;
+    config.set_max_pending_invocations(1);
+    config.set_flow_control_mode(flow_control_mode::reject);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+
+    hub_connection.invoke("method", std::vector<signalr::value>(), [](const signalr::value&, std::exception_ptr) {});
+
+    std::exception_ptr rejection;
+    hub_connection.invoke("method", std::vector<signalr::value>(), [&rejection](const signalr::value&, std::exception_ptr exception)
+        {
+            rejection = exception;
+        });
+
+    // rejected right away, without waiting for the scheduler
+    try
+    {
+        ASSERT_NE(nullptr, rejection);
+        std::rethrow_exception(rejection);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("the invocation was rejected because the connection reached its limit of pending invocations or outbound bytes", e.what());
+    }
+    ASSERT_EQ(1u, hub_connection.get_pending_invocation_count());
+
+    scheduler->run_until_idle();
+    ASSERT_EQ(0, ready_to_send);
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&ready_to_send]() { return ready_to_send == 1; }));
+    ASSERT_EQ(0u, hub_connection.get_pending_invocation_count());
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(flow_control, outbound_bytes_limit_holds_sends_until_the_websocket_reports_them_sent)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto send_callbacks = std::make_shared<std::vector<std::function<void(std::exception_ptr)>>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages, send_callbacks](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            if (messages->size() == 1)
+            {
+                // the handshake
+                callback(nullptr);
+            }
+            else
+            {
+                send_callbacks->push_back(callback);
+            }
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    signalr_client_config config;
+    config.set_max_outbound_bytes(1);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+
+    std::vector<std::exception_ptr> sent(3);
+    std::vector<bool> completed(3, false);
+    for (size_t i = 0; i < sent.size(); ++i)
+    {
+        hub_connection.send("method", std::vector<signalr::value>(), [&sent, &completed, i](std::exception_ptr exception)
+            {
+                sent[i] = exception;
+                completed[i] = true;
+            });
+    }
+
+    scheduler->run_until_idle();
+    ASSERT_EQ(2u, messages->size());
+    ASSERT_EQ(1u, send_callbacks->size());
+
+    (*send_callbacks)[0](nullptr);
+    scheduler->run_until_idle();
+    ASSERT_TRUE(completed[0]);
+    ASSERT_EQ(nullptr, sent[0]);
+    ASSERT_EQ(3u, messages->size());
+    ASSERT_FALSE(completed[1]);
+
+    // the call that is still held fails when the connection stops
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+    ASSERT_TRUE(completed[2]);
+    try
+    {
+        ASSERT_NE(nullptr, sent[2]);
+        std::rethrow_exception(sent[2]);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("the connection was stopped before the call was sent", e.what());
+    }
+    ASSERT_EQ(3u, messages->size());
+}
+
+TEST(stream, sends_stream_invocation_and_delivers_items_until_completion)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    std::vector<signalr::value> items;
+    bool completed = false;
+    std::exception_ptr error;
+    hub_connection.stream("method", std::vector<signalr::value>{ signalr::value(1.0) },
+        [&items](const signalr::value& item) { items.push_back(item); },
+        [&completed, &error](std::exception_ptr exception)
+        {
+            completed = true;
+            error = exception;
+        });
+
+    scheduler->run_until_idle();
+    ASSERT_EQ("{\"arguments\":[1],\"invocationId\":\"0\",\"target\":\"method\",\"type\":4}\x1e", messages->back());
+
+    websocket_client->receive_message("{ \"type\": 2, \"invocationId\": \"0\", \"item\": \"first\" }\x1e"
+        "{ \"type\": 2, \"invocationId\": \"0\", \"item\": 2 }\x1e");
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&completed]() { return completed; }));
+
+    ASSERT_EQ(nullptr, error);
+    ASSERT_EQ(2u, items.size());
+    ASSERT_EQ("first", items[0].as_string());
+    ASSERT_EQ(2, items[1].as_double());
+    ASSERT_EQ(0u, hub_connection.get_pending_invocation_count());
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(stream, propagates_errors_from_server_as_hub_exceptions)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    bool completed = false;
+    std::exception_ptr error;
+    hub_connection.stream("method", std::vector<signalr::value>(), [](const signalr::value&) {},
+        [&completed, &error](std::exception_ptr exception)
+        {
+            completed = true;
+            error = exception;
+        });
+    scheduler->run_until_idle();
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"error\": \"stream failed\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&completed]() { return completed; }));
+
+    try
+    {
+        ASSERT_NE(nullptr, error);
+        std::rethrow_exception(error);
+    }
+    catch (const hub_exception& e)
+    {
+        ASSERT_STREQ("stream failed", e.what());
+    }
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(stream, cancel_sends_cancel_invocation_and_completes_the_stream)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto writer = std::make_shared<memory_log_writer>();
+    auto hub_connection = create_hub_connection(websocket_client, writer);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    std::vector<signalr::value> items;
+    int completions = 0;
+    std::exception_ptr error;
+    auto cancel = hub_connection.stream("method", std::vector<signalr::value>(),
+        [&items](const signalr::value& item) { items.push_back(item); },
+        [&completions, &error](std::exception_ptr exception)
+        {
+            ++completions;
+            error = exception;
+        });
+    scheduler->run_until_idle();
+
+    cancel();
+    scheduler->run_until_idle();
+    ASSERT_EQ("{\"invocationId\":\"0\",\"type\":5}\x1e", messages->back());
+    ASSERT_EQ(1, completions);
+    try
+    {
+        ASSERT_NE(nullptr, error);
+        std::rethrow_exception(error);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("the stream was canceled", e.what());
+    }
+
+    // canceling again has nothing left to cancel
+    auto sent = messages->size();
+    cancel();
+    scheduler->run_until_idle();
+    ASSERT_EQ(sent, messages->size());
+
+    // what the server sent before it saw the cancellation is dropped
+    websocket_client->receive_message("{ \"type\": 2, \"invocationId\": \"0\", \"item\": 1 }\x1e{ \"type\": 3, \"invocationId\": \"0\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&writer]()
+        {
+            auto entries = writer->get_log_entries();
+            return std::any_of(entries.begin(), entries.end(), [](const std::string& entry)
+                {
+                    return entry.find("no callback found for id: 0") != std::string::npos;
+                });
+        }));
+    ASSERT_TRUE(items.empty());
+    ASSERT_EQ(1, completions);
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(stream, full_stream_buffer_pauses_receive_until_the_items_are_taken)
+{
+    auto writer = std::make_shared<memory_log_writer>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client, writer);
+    signalr_client_config config;
+    config.set_stream_buffer_capacity(2);
+    hub_connection.set_client_config(config);
+
+    auto mre = manual_reset_event<void>();
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{ }\x1e");
+    mre.get();
+
+    // the items are delivered one at a time so only the callback touches the vector
+    auto items = std::make_shared<std::vector<double>>();
+    auto first_item = std::make_shared<cancellation_token_source>();
+    auto unblock = std::make_shared<cancellation_token_source>();
+    auto completed = std::make_shared<cancellation_token_source>();
+    hub_connection.stream("method", std::vector<signalr::value>(), [items, first_item, unblock](const signalr::value& item)
+        {
+            items->push_back(item.as_double());
+            first_item->cancel();
+            unblock->wait(5000);
+        },
+        [completed](std::exception_ptr)
+        {
+            completed->cancel();
+        });
+
+    websocket_client->receive_message("{ \"type\": 2, \"invocationId\": \"0\", \"item\": 1 }\x1e{ \"type\": 2, \"invocationId\": \"0\", \"item\": 2 }\x1e"
+        "{ \"type\": 2, \"invocationId\": \"0\", \"item\": 3 }\x1e");
+    ASSERT_FALSE(first_item->wait(5000));
+
+    auto logged = [&writer](const char* text)
+    {
+        for (int wait_time_ms = 5; wait_time_ms < 6000; wait_time_ms <<= 1)
+        {
+            auto entries = writer->get_log_entries();
+            if (std::any_of(entries.begin(), entries.end(), [text](const std::string& entry)
+                {
+                    return entry.find(text) != std::string::npos;
+                }))
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(wait_time_ms));
+        }
+        return false;
+    };
+    ASSERT_TRUE(logged("pausing receive"));
+
+    // the receive loop doesn't ask for the next message while the item callback is behind
+    auto receive_count = websocket_client->receive_count;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(receive_count, websocket_client->receive_count);
+
+    unblock->cancel();
+    ASSERT_TRUE(logged("resuming receive"));
+
+    websocket_client->receive_message("{ \"type\": 2, \"invocationId\": \"0\", \"item\": 4 }\x1e{ \"type\": 3, \"invocationId\": \"0\" }\x1e");
+    ASSERT_FALSE(completed->wait(5000));
+    ASSERT_EQ((std::vector<double>{ 1, 2, 3, 4 }), *items);
+}
+
+TEST(stream, items_and_copied_arguments_outlive_their_frame_with_the_message_arena)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    // the handler copies what it keeps, the items are delivered after their frame was released
+    std::vector<signalr::value> quotes;
+    hub_connection.on("quote", [&quotes](const std::vector<signalr::value>& arguments)
+        {
+            quotes.push_back(arguments[0]);
+        });
+
+    signalr_client_config config;
+    config.set_use_message_arena(true);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+
+    std::vector<signalr::value> items;
+    bool completed = false;
+    hub_connection.stream("method", std::vector<signalr::value>(),
+        [&items](const signalr::value& item) { items.push_back(item); },
+        [&completed](std::exception_ptr) { completed = true; });
+    scheduler->run_until_idle();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        auto index = std::to_string(i);
+        // compact like servers send them, so they are parsed into the arena without going through jsoncpp
+        websocket_client->receive_message("{\"type\":1,\"target\":\"quote\",\"arguments\":[{\"symbol\":\"SYM" + index + "\",\"prices\":["
+            + index + ",1]}]}\x1e{\"type\":2,\"invocationId\":\"0\",\"item\":[[" + index + "],{\"n\":" + index + "}]}\x1e");
+    }
+    websocket_client->receive_message("{\"type\":3,\"invocationId\":\"0\"}\x1e");
+    ASSERT_TRUE(scheduler->run_until([&completed]() { return completed; }));
+
+    ASSERT_EQ(3u, quotes.size());
+    ASSERT_EQ(3u, items.size());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ("SYM" + std::to_string(i), quotes[i].as_map().at("symbol").as_string());
+        ASSERT_EQ(static_cast<double>(i), quotes[i].as_map().at("prices").as_array()[0].as_double());
+        ASSERT_EQ(static_cast<double>(i), items[i].as_array()[0].as_array()[0].as_double());
+        ASSERT_EQ(static_cast<double>(i), items[i].as_array()[1].as_map().at("n").as_double());
+    }
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(upload, sends_invocation_with_stream_id_then_items_and_completion)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+    auto sent = messages->size();
+
+    bool completed = false;
+    signalr::value result;
+    std::exception_ptr error;
+    auto stream = hub_connection.upload("method", std::vector<signalr::value>{ signalr::value(1.0) },
+        [&completed, &result, &error](const signalr::value& value, std::exception_ptr exception)
+        {
+            completed = true;
+            result = value;
+            error = exception;
+        });
+
+    std::vector<std::exception_ptr> write_errors;
+    auto record_write = [&write_errors](std::exception_ptr exception) { write_errors.push_back(exception); };
+    stream->write(signalr::value("first"), record_write);
+    stream->write(signalr::value(2.0), record_write);
+    stream->complete(record_write);
+    scheduler->run_until_idle();
+
+    ASSERT_EQ((std::vector<std::string>
+        {
+            "{\"arguments\":[1],\"invocationId\":\"0\",\"streamIds\":[\"0\"],\"target\":\"method\",\"type\":1}\x1e",
+            "{\"invocationId\":\"0\",\"item\":\"first\",\"type\":2}\x1e",
+            "{\"invocationId\":\"0\",\"item\":2,\"type\":2}\x1e",
+            "{\"invocationId\":\"0\",\"type\":3}\x1e"
+        }), std::vector<std::string>(messages->begin() + sent, messages->end()));
+    ASSERT_EQ((std::vector<std::exception_ptr>{ nullptr, nullptr, nullptr }), write_errors);
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"result\": 42 }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&completed]() { return completed; }));
+    ASSERT_EQ(nullptr, error);
+    ASSERT_EQ(42, result.as_double());
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(upload, cancel_sends_completion_with_error_and_later_writes_fail)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    auto stream = hub_connection.upload("method", std::vector<signalr::value>());
+    std::exception_ptr cancel_error;
+    stream->cancel("no more data", [&cancel_error](std::exception_ptr exception) { cancel_error = exception; });
+    scheduler->run_until_idle();
+    ASSERT_EQ(nullptr, cancel_error);
+    ASSERT_EQ("{\"error\":\"no more data\",\"invocationId\":\"0\",\"type\":3}\x1e", messages->back());
+
+    auto sent = messages->size();
+    std::exception_ptr write_error;
+    stream->write(signalr::value(1.0), [&write_error](std::exception_ptr exception) { write_error = exception; });
+    std::exception_ptr complete_error;
+    stream->complete([&complete_error](std::exception_ptr exception) { complete_error = exception; });
+    scheduler->run_until_idle();
+    ASSERT_EQ(sent, messages->size());
+
+    try
+    {
+        ASSERT_NE(nullptr, write_error);
+        std::rethrow_exception(write_error);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("write() cannot be called on a completed upload_stream", e.what());
+    }
+    try
+    {
+        ASSERT_NE(nullptr, complete_error);
+        std::rethrow_exception(complete_error);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("the upload_stream was already completed", e.what());
+    }
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+TEST(upload, stream_ends_with_its_invocation_and_completes_when_dropped)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto websocket_client = create_test_websocket_client(
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        {
+            messages->push_back(msg);
+            callback(nullptr);
+        });
+    auto hub_connection = create_hub_connection(websocket_client);
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler);
+
+    bool completed = false;
+    auto stream = hub_connection.upload("method", std::vector<signalr::value>(),
+        [&completed](const signalr::value&, std::exception_ptr) { completed = true; });
+    scheduler->run_until_idle();
+
+    // the hub method failed, the server doesn't read the stream anymore
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"error\": \"failed\" }\x1e");
+    ASSERT_TRUE(scheduler->run_until([&completed]() { return completed; }));
+
+    auto sent = messages->size();
+    std::exception_ptr write_error;
+    stream->write(signalr::value(1.0), [&write_error](std::exception_ptr exception) { write_error = exception; });
+    ASSERT_NE(nullptr, write_error);
+    stream.reset();
+    scheduler->run_until_idle();
+    ASSERT_EQ(sent, messages->size());
+
+    // a stream dropped before it completed tells the server there are no more items
+    hub_connection.upload("method", std::vector<signalr::value>());
+    scheduler->run_until_idle();
+    ASSERT_EQ(sent + 2, messages->size());
+    ASSERT_EQ("{\"arguments\":[],\"invocationId\":\"1\",\"streamIds\":[\"1\"],\"target\":\"method\",\"type\":1}\x1e", (*messages)[sent]);
+    ASSERT_EQ("{\"invocationId\":\"1\",\"type\":3}\x1e", (*messages)[sent + 1]);
+
+    stop_on_virtual_scheduler(hub_connection, scheduler);
+}
+
+class test_scheduler : public scheduler
+{
+public:
+    virtual void schedule(const signalr_base_cb& cb, std::chrono::milliseconds delay = std::chrono::milliseconds::zero()) override
+    {
+        schedule_count++;
+        std::thread([cb, delay]()
+            {
+                std::this_thread::sleep_for(delay);
+                cb();
+            }).detach();
+    }
+
+    std::atomic<int> schedule_count{ 0 };
+};
+
+TEST(config, can_replace_scheduler)
+{
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = hub_connection_builder::create(create_uri())
+        .with_logging(std::make_shared<memory_log_writer>(), trace_level::verbose)
+        .with_http_client_factory(create_test_http_client())
+        .with_websocket_factory([websocket_client](const signalr_client_config& config)
+            {
+                websocket_client->set_config(config);
+                return websocket_client;
+            })
+        .build();
+
+    signalr_client_config config{};
+    auto scheduler = std::make_shared<test_scheduler>();
+    config.set_scheduler(scheduler);
+    hub_connection.set_client_config(config);
+
+    // do some "work" to verify scheduler is used
+
+    auto mre = manual_reset_event<void>();
+    hub_connection.start([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+
+    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
+    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    websocket_client->receive_message("{ }\x1e");
+
+    mre.get();
+
+    auto invoke_mre = manual_reset_event<void>();
+    hub_connection.invoke("method", std::vector<signalr::value>(), [&invoke_mre](const signalr::value& message, std::exception_ptr exception)
+        {
+            if (exception)
+            {
+                invoke_mre.set(exception);
+            }
+            else
+            {
+                invoke_mre.set();
+            }
+        });
+
+    websocket_client->receive_message("{ \"type\": 3, \"invocationId\": \"0\", \"result\": \"abc\" }\x1e");
+
+    invoke_mre.get();
+
+    hub_connection.stop([&mre](std::exception_ptr ex)
+        {
+            mre.set();
+        });
+
+    mre.get();
+
+    // http_client->send (negotiate), websocket_client->start, handshake timeout timer, websocket_client->send, websocket_client->send, keep alive timer, websocket_client->send ping, websocket_client->stop
+    // handshake timeout timer can trigger more than once if test takes more than 1 second
+    ASSERT_GE(scheduler->schedule_count, 8);
+}
+
+class throw_hub_protocol : public hub_protocol
+{
+    virtual std::string write_message(const hub_message* message) const override
+    {
+        if (message->message_type == message_type::ping)
         {
             return "";
         }
@@ -1974,22 +2953,17 @@ TEST(receive, close_connection_on_null_hub_message)
 
 TEST(keepalive, sends_ping_messages)
 {
+    auto scheduler = std::make_shared<virtual_scheduler>();
     signalr_client_config config;
+    config.set_scheduler(scheduler);
     config.set_keepalive_interval(std::chrono::seconds(1));
     config.set_server_timeout(std::chrono::seconds(3));
-    auto ping_mre = manual_reset_event<void>();
     auto messages = std::make_shared<std::deque<std::string>>();
     auto websocket_client = create_test_websocket_client(
-        /* send function */ [messages, &ping_mre](const std::string& msg, std::function<void(std::exception_ptr)> callback)
+        /* send function */ [messages](const std::string& msg, std::function<void(std::exception_ptr)> callback)
         {
-            if (messages->size() < 3)
-            {
-                messages->push_back(msg);
-            }
-            if (messages->size() == 3)
-            {
-                ping_mre.set();
-            }
+            // sends run on the scheduler, which only runs callbacks on the test thread
+            messages->push_back(msg);
             callback(nullptr);
         },
         [](const std::string&, std::function<void(std::exception_ptr)> callback) { callback(nullptr); },
@@ -1998,59 +2972,101 @@ TEST(keepalive, sends_ping_messages)
     auto hub_connection = create_hub_connection(websocket_client);
     hub_connection.set_client_config(config);
 
-    auto mre = manual_reset_event<void>();
-    hub_connection.start([&mre](std::exception_ptr exception)
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    hub_connection.start([&started](std::exception_ptr exception)
         {
-            mre.set(exception);
+            if (exception)
+            {
+                started.set_exception(exception);
+            }
+            else
+            {
+                started.set_value();
+            }
         });
 
-    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
-    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    ASSERT_TRUE(scheduler->run_until([&websocket_client]()
+        {
+            return websocket_client->receive_loop_started.wait(0) == 0 && websocket_client->handshake_sent.wait(0) == 0;
+        }));
     websocket_client->receive_message("{}\x1e");
 
-    mre.get();
+    ASSERT_TRUE(run_until_ready(*scheduler, started_future));
+    started_future.get();
 
-    ping_mre.get();
+    // the first ping is sent as soon as the connection starts, then one every keepalive interval
+    ASSERT_TRUE(scheduler->run_until([&messages]() { return messages->size() == 2; }));
+    scheduler->advance(std::chrono::milliseconds(999));
+    ASSERT_EQ(2, messages->size());
+    scheduler->advance(std::chrono::milliseconds(1));
+    ASSERT_TRUE(scheduler->run_until([&messages]() { return messages->size() == 3; }));
 
     ASSERT_EQ(3, messages->size());
     ASSERT_EQ("{\"protocol\":\"json\",\"version\":1}\x1e", (*messages)[0]);
     ASSERT_EQ("{\"type\":6}\x1e", (*messages)[1]);
     ASSERT_EQ("{\"type\":6}\x1e",  (*messages)[2]);
     ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
+
+    std::promise<void> stopped;
+    auto stopped_future = stopped.get_future();
+    hub_connection.stop([&stopped](std::exception_ptr)
+        {
+            stopped.set_value();
+        });
+    ASSERT_TRUE(run_until_ready(*scheduler, stopped_future));
 }
 
 TEST(keepalive, server_timeout_on_no_ping_from_server)
 {
+    auto scheduler = std::make_shared<virtual_scheduler>();
     signalr_client_config config;
+    config.set_scheduler(scheduler);
     config.set_keepalive_interval(std::chrono::seconds(1));
     config.set_server_timeout(std::chrono::seconds(1));
     auto websocket_client = create_test_websocket_client();
     auto hub_connection = create_hub_connection(websocket_client);
     hub_connection.set_client_config(config);
 
-    auto disconnected_called = false;
-
-    auto disconnect_mre = manual_reset_event<void>();
-    hub_connection.set_disconnected([&disconnected_called, &disconnect_mre](std::exception_ptr ex)
+    std::promise<void> disconnected;
+    auto disconnected_future = disconnected.get_future();
+    hub_connection.set_disconnected([&disconnected](std::exception_ptr ex)
         {
-            disconnect_mre.set(ex);
+            disconnected.set_exception(ex);
         });
 
-    auto mre = manual_reset_event<void>();
-    hub_connection.start([&mre](std::exception_ptr exception)
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    hub_connection.start([&started](std::exception_ptr exception)
         {
-            mre.set(exception);
+            if (exception)
+            {
+                started.set_exception(exception);
+            }
+            else
+            {
+                started.set_value();
+            }
         });
 
-    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
-    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    ASSERT_TRUE(scheduler->run_until([&websocket_client]()
+        {
+            return websocket_client->receive_loop_started.wait(0) == 0 && websocket_client->handshake_sent.wait(0) == 0;
+        }));
     websocket_client->receive_message("{}\x1e");
 
-    mre.get();
+    ASSERT_TRUE(run_until_ready(*scheduler, started_future));
+    started_future.get();
+
+    scheduler->advance(std::chrono::milliseconds(999));
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
+
+    scheduler->advance(std::chrono::milliseconds(1));
+    ASSERT_TRUE(run_until_ready(*scheduler, disconnected_future));
 
     try
     {
-        disconnect_mre.get();
+        disconnected_future.get();
         ASSERT_TRUE(false);
     }
     catch (const std::exception& ex)
@@ -2062,39 +3078,66 @@ TEST(keepalive, server_timeout_on_no_ping_from_server)
 
 TEST(keepalive, resets_server_timeout_timer_on_any_message_from_server)
 {
+    auto scheduler = std::make_shared<virtual_scheduler>();
     signalr_client_config config;
+    config.set_scheduler(scheduler);
     config.set_keepalive_interval(std::chrono::seconds(1));
     config.set_server_timeout(std::chrono::seconds(1));
     auto websocket_client = create_test_websocket_client();
     auto hub_connection = create_hub_connection(websocket_client);
     hub_connection.set_client_config(config);
 
-    auto disconnect_mre = manual_reset_event<void>();
-    hub_connection.set_disconnected([&disconnect_mre](std::exception_ptr ex)
+    std::promise<void> disconnected;
+    auto disconnected_future = disconnected.get_future();
+    hub_connection.set_disconnected([&disconnected](std::exception_ptr ex)
         {
-            disconnect_mre.set(ex);
+            disconnected.set_exception(ex);
         });
 
-    auto mre = manual_reset_event<void>();
-    hub_connection.start([&mre](std::exception_ptr exception)
+    std::atomic<bool> handled(false);
+    hub_connection.on("tick", [&handled](const std::vector<signalr::value>&)
         {
-            mre.set(exception);
+            handled = true;
         });
 
-    ASSERT_FALSE(websocket_client->receive_loop_started.wait(5000));
-    ASSERT_FALSE(websocket_client->handshake_sent.wait(5000));
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    hub_connection.start([&started](std::exception_ptr exception)
+        {
+            if (exception)
+            {
+                started.set_exception(exception);
+            }
+            else
+            {
+                started.set_value();
+            }
+        });
+
+    ASSERT_TRUE(scheduler->run_until([&websocket_client]()
+        {
+            return websocket_client->receive_loop_started.wait(0) == 0 && websocket_client->handshake_sent.wait(0) == 0;
+        }));
     websocket_client->receive_message("{}\x1e");
 
-    mre.get();
+    ASSERT_TRUE(run_until_ready(*scheduler, started_future));
+    started_future.get();
 
-    std::this_thread::sleep_for(config.get_server_timeout() - std::chrono::milliseconds(500));
+    scheduler->advance(config.get_server_timeout() - std::chrono::milliseconds(500));
     websocket_client->receive_message("{\"type\":6}\x1e");
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    // messages are processed in order, once the handler has run the ping has been seen
+    websocket_client->receive_message("{\"type\":1,\"target\":\"tick\",\"arguments\":[]}\x1e");
+    ASSERT_TRUE(scheduler->run_until([&handled]() { return handled.load(); }));
+
+    scheduler->advance(std::chrono::milliseconds(999));
     ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
 
+    scheduler->advance(std::chrono::seconds(1));
+    ASSERT_TRUE(run_until_ready(*scheduler, disconnected_future));
+
     try
     {
-        disconnect_mre.get();
+        disconnected_future.get();
         ASSERT_TRUE(false);
     }
     catch (const std::exception& ex)
@@ -2104,6 +3147,36 @@ TEST(keepalive, resets_server_timeout_timer_on_any_message_from_server)
     ASSERT_EQ(connection_state::disconnected, hub_connection.get_connection_state());
 }
 
+TEST(keepalive, server_timeout_fires_at_its_deadline_rather_than_on_a_whole_second)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    signalr_client_config config;
+    config.set_keepalive_interval(std::chrono::seconds(1));
+    config.set_server_timeout(std::chrono::milliseconds(2350));
+    auto websocket_client = create_test_websocket_client();
+    auto hub_connection = create_hub_connection(websocket_client);
+
+    std::promise<void> disconnected;
+    auto disconnected_future = disconnected.get_future();
+    hub_connection.set_disconnected([&disconnected](std::exception_ptr ex)
+        {
+            disconnected.set_exception(ex);
+        });
+
+    start_on_virtual_scheduler(hub_connection, websocket_client, scheduler, config);
+    auto started = scheduler->now();
+
+    // pings go out in between but only messages from the server reset the timeout
+    scheduler->advance(std::chrono::milliseconds(2349));
+    ASSERT_EQ(connection_state::connected, hub_connection.get_connection_state());
+
+    scheduler->advance(std::chrono::milliseconds(1));
+    ASSERT_EQ(std::chrono::milliseconds(2350), scheduler->now() - started);
+    ASSERT_TRUE(run_until_ready(*scheduler, disconnected_future));
+    ASSERT_THROW(disconnected_future.get(), signalr_exception);
+    ASSERT_EQ(connection_state::disconnected, hub_connection.get_connection_state());
+}
+
 class unknown_message_type_hub_protocol : public hub_protocol
 {
     class custom_hub_message : public hub_message
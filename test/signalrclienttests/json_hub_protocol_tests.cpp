@@ -4,7 +4,10 @@
 
 #include "stdafx.h"
 #include "json_hub_protocol.h"
+#include "json_helpers.h"
 #include "test_utils.h"
+#include <cstring>
+#include <limits>
 
 using namespace signalr;
 
@@ -12,11 +15,11 @@ std::vector<std::pair<std::string, std::shared_ptr<hub_message>>> protocol_test_
 {
     // invocation message without invocation id
     { "{\"arguments\":[1,\"Foo\"],\"target\":\"Target\",\"type\":1}\x1e",
-    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(1.f), value("Foo") })) },
+    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
 
     // invocation message with multiple arguments
     { "{\"arguments\":[1,\"Foo\"],\"invocationId\":\"123\",\"target\":\"Target\",\"type\":1}\x1e",
-    std::shared_ptr<hub_message>(new invocation_message("123", "Target", std::vector<value>{ value(1.f), value("Foo") })) },
+    std::shared_ptr<hub_message>(new invocation_message("123", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
 
     // invocation message with bool argument
     { "{\"arguments\":[true],\"target\":\"Target\",\"type\":1}\x1e",
@@ -36,11 +39,11 @@ std::vector<std::pair<std::string, std::shared_ptr<hub_message>>> protocol_test_
 
     // invocation message with object argument
     { "{\"arguments\":[{\"property\":5}],\"target\":\"Target\",\"type\":1}\x1e",
-    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::map<std::string, value>{ {"property", value(5.f)} }) })) },
+    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::map<std::string, value>{ {"property", value(int64_t(5))} }) })) },
 
     // invocation message with array argument
     { "{\"arguments\":[[1,5]],\"target\":\"Target\",\"type\":1}\x1e",
-    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::vector<value>{value(1.f), value(5.f)}) })) },
+    std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::vector<value>{value(int64_t(1)), value(int64_t(5))}) })) },
 
     // ping message
     { "{\"type\":6}\x1e",
@@ -52,7 +55,7 @@ std::vector<std::pair<std::string, std::shared_ptr<hub_message>>> protocol_test_
 
     // completion message with result
     { "{\"invocationId\":\"1\",\"result\":42,\"type\":3}\x1e",
-    std::shared_ptr<hub_message>(new completion_message("1", "", value(42.f), true)) },
+    std::shared_ptr<hub_message>(new completion_message("1", "", value(int64_t(42)), true)) },
 
     // completion message with no result or error
     { "{\"invocationId\":\"1\",\"type\":3}\x1e",
@@ -61,6 +64,26 @@ std::vector<std::pair<std::string, std::shared_ptr<hub_message>>> protocol_test_
     // completion message with null result
     { "{\"invocationId\":\"1\",\"result\":null,\"type\":3}\x1e",
     std::shared_ptr<hub_message>(new completion_message("1", "", value(), true)) },
+
+    // invocation message with stream ids
+    { "{\"arguments\":[1],\"invocationId\":\"1\",\"streamIds\":[\"2\",\"3\"],\"target\":\"Target\",\"type\":1}\x1e",
+    std::shared_ptr<hub_message>(new invocation_message("1", "Target", std::vector<value>{ value(int64_t(1)) }, std::vector<std::string>{ "2", "3" })) },
+
+    // stream invocation message
+    { "{\"arguments\":[1,\"Foo\"],\"invocationId\":\"1\",\"target\":\"Target\",\"type\":4}\x1e",
+    std::shared_ptr<hub_message>(new invocation_message(message_type::stream_invocation, "1", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
+
+    // stream item message
+    { "{\"invocationId\":\"1\",\"item\":{\"property\":5},\"type\":2}\x1e",
+    std::shared_ptr<hub_message>(new stream_item_message("1", value(std::map<std::string, value>{ {"property", value(int64_t(5))} }))) },
+
+    // stream item message with null item
+    { "{\"invocationId\":\"1\",\"item\":null,\"type\":2}\x1e",
+    std::shared_ptr<hub_message>(new stream_item_message("1", value())) },
+
+    // cancel invocation message
+    { "{\"invocationId\":\"1\",\"type\":5}\x1e",
+    std::shared_ptr<hub_message>(new cancel_invocation_message("1")) },
 };
 
 TEST(json_hub_protocol, write_message)
@@ -116,7 +139,7 @@ TEST(json_hub_protocol, can_parse_multiple_messages)
     invocation_message invocation = invocation_message("", "Target", std::vector<value>{});
     assert_hub_message_equality(&invocation, output[0].get());
 
-    completion_message completion = completion_message("1", "", value(42.f), true);
+    completion_message completion = completion_message("1", "", value(int64_t(42)), true);
     assert_hub_message_equality(&completion, output[1].get());
 }
 
@@ -151,11 +174,24 @@ std::vector<std::pair<std::string, std::string>> invalid_messages
     { "{\"type\":1,\"target\":\"send\",\"arguments\":[],\"invocationId\":42}\x1e", "Expected 'invocationId' to be of type 'string'" },
     { "{\"type\":1,\"target\":\"send\",\"arguments\":42,\"invocationId\":\"42\"}\x1e", "Expected 'arguments' to be of type 'array'" },
     { "{\"type\":1,\"target\":true,\"arguments\":[],\"invocationId\":\"42\"}\x1e", "Expected 'target' to be of type 'string'" },
+    { "{\"type\":1,\"target\":\"send\",\"arguments\":[],\"streamIds\":42}\x1e", "Expected 'streamIds' to be of type 'array'" },
+    { "{\"type\":1,\"target\":\"send\",\"arguments\":[],\"streamIds\":[\"1\",2]}\x1e", "Expected 'streamIds' to only contain values of type 'string'" },
 
     { "{\"type\":3}\x1e", "Field 'invocationId' not found for 'completion' message" },
     { "{\"type\":3,\"invocationId\":42}\x1e", "Expected 'invocationId' to be of type 'string'" },
     { "{\"type\":3,\"invocationId\":\"42\",\"error\":[]}\x1e", "Expected 'error' to be of type 'string'" },
     { "{\"type\":3,\"invocationId\":\"42\",\"error\":\"foo\",\"result\":true}\x1e", "The 'error' and 'result' properties are mutually exclusive." },
+
+    { "{\"type\":2,\"item\":42}\x1e", "Field 'invocationId' not found for 'stream_item' message" },
+    { "{\"type\":2,\"invocationId\":42,\"item\":42}\x1e", "Expected 'invocationId' to be of type 'string'" },
+    { "{\"type\":2,\"invocationId\":\"42\"}\x1e", "Field 'item' not found for 'stream_item' message" },
+
+    { "{\"type\":4,\"target\":\"send\",\"arguments\":[]}\x1e", "Field 'invocationId' not found for 'stream_invocation' message" },
+    { "{\"type\":4,\"invocationId\":\"42\",\"arguments\":[]}\x1e", "Field 'target' not found for 'stream_invocation' message" },
+
+    { "{\"type\":5}\x1e", "Field 'invocationId' not found for 'cancel_invocation' message" },
+
+    { "{\"type\":6}\x1e{\"type\":1,\"target\":\"send\",\"arguments\":[\"\xC3\"]}\x1e", "message is not valid UTF-8" },
 };
 
 TEST(json_hub_protocol, invalid_messages_throw)
@@ -172,4 +208,180 @@ TEST(json_hub_protocol, invalid_messages_throw)
             ASSERT_STREQ(pair.second.data(), exception.what());
         }
     }
-}
\ No newline at end of file
+}
+namespace
+{
+    // stricter than assert_signalr_value_equality, doubles have to be bit for bit the same (which tells 0.0 and -0.0
+    // apart) and strings can contain null characters
+    void assert_identical_values(const value& expected, const value& actual)
+    {
+        ASSERT_EQ(expected.type(), actual.type());
+        switch (expected.type())
+        {
+        case value_type::float64:
+        {
+            auto expected_double = expected.as_double();
+            auto actual_double = actual.as_double();
+            ASSERT_EQ(0, memcmp(&expected_double, &actual_double, sizeof(double))) << expected_double << " != " << actual_double;
+            break;
+        }
+        case value_type::string:
+            ASSERT_EQ(expected.as_string(), actual.as_string());
+            break;
+        case value_type::array:
+            ASSERT_EQ(expected.as_value_array().size(), actual.as_value_array().size());
+            for (size_t i = 0; i < expected.as_value_array().size(); ++i)
+            {
+                assert_identical_values(expected.as_value_array()[i], actual.as_value_array()[i]);
+            }
+            break;
+        case value_type::map:
+            ASSERT_EQ(expected.as_value_map().size(), actual.as_value_map().size());
+            for (auto& pair : expected.as_value_map())
+            {
+                auto found = actual.as_value_map().find(pair.first);
+                ASSERT_NE(actual.as_value_map().end(), found) << pair.first;
+                assert_identical_values(pair.second, found->second);
+            }
+            break;
+        default:
+            assert_signalr_value_equality(expected, actual);
+            break;
+        }
+    }
+}
+
+TEST(json_hub_protocol, arguments_are_parsed_the_same_as_with_jsoncpp)
+{
+    std::vector<std::string> arguments
+    {
+        "0", "-0", "1", "-1", "42", "0.1", "-0.0", "1.5e3", "1E-3", "2.5e+2", "0.000123", "123.456e-5", "9007199254740993",
+        "9223372036854775807", "-9223372036854775808", "-9223372036854775809", "18446744073709551615",
+        "18446744073709551616", "123456789012345678901234567890", "1.7976931348623157e308", "5e-324", "2.2250738585072014e-308",
+        "0.30000000000000004", "3.141592653589793238462643383279", "1e22", "1e23", "4.35679e-10", "1e-7",
+        "true", "false", "null", "\"\"", "\"plain\"", "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"", "\"\\u0000\\u001f\\u00e9\\u20AC\"",
+        "\"\\ud83d\\ude00\"", "\"\xD7\x9E\xD7\x97\xD7\xA8\"", "[]", "[1,[2,[3,[]]]]", "{}", "{\"a\":{\"b\":[1,\"c\",null]},\"\":true}",
+        " [ 1 , { \"key\" :\t\"value\" } ]\r\n"
+    };
+
+    for (auto& argument : arguments)
+    {
+        auto message = "{\"type\":1,\"target\":\"Target\",\"arguments\":[" + argument + "]}";
+
+        Json::Value root;
+        std::string errors;
+        auto jsoncpp_reader = getJsonReader();
+        ASSERT_TRUE(jsoncpp_reader->parse(message.data(), message.data() + message.size(), &root, &errors)) << argument;
+
+        auto output = json_hub_protocol().parse_messages(message + record_separator);
+        ASSERT_EQ(1, output.size()) << argument;
+        auto invocation = static_cast<invocation_message*>(output[0].get());
+        ASSERT_EQ(1, invocation->arguments.size()) << argument;
+        assert_identical_values(createValue(root["arguments"][0]), invocation->arguments[0]);
+    }
+}
+
+TEST(json_hub_protocol, messages_the_direct_reader_does_not_handle_are_parsed_with_jsoncpp)
+{
+    // a lone surrogate, jsoncpp reads it as is
+    auto output = json_hub_protocol().parse_messages("{\"type\":1,\"target\":\"Target\",\"arguments\":[\"\\udc00\"]}\x1e");
+    ASSERT_EQ(1, output.size());
+    auto invocation = static_cast<invocation_message*>(output[0].get());
+    ASSERT_EQ(1, invocation->arguments.size());
+    ASSERT_EQ("\xED\xB0\x80", invocation->arguments[0].as_string());
+
+    // a message the direct reader doesn't handle, and jsoncpp doesn't either
+    try
+    {
+        json_hub_protocol().parse_messages("{\"type\":1,\"target\":\"Target\",\"target\":\"Other\",\"arguments\":[]}\x1e");
+        ASSERT_TRUE(false);
+    }
+    catch (const std::exception& exception)
+    {
+        ASSERT_STREQ("* Line 1, Column 29\n  Duplicate key: 'target'\n", exception.what());
+    }
+}
+
+TEST(json_hub_protocol, arguments_are_written_the_same_as_with_jsoncpp)
+{
+    std::vector<value> arguments
+    {
+        value(0.0), value(-0.0), value(42.0), value(-42.0), value(9007199254740993.0), value(-9223372036854775808.0),
+        value(18446744073709549568.0), value(int64_t(0)), value(INT64_MIN), value(INT64_MAX), value(UINT64_MAX),
+        value(std::numeric_limits<double>::infinity()), value(-std::numeric_limits<double>::infinity()),
+        value(std::numeric_limits<double>::quiet_NaN()), value(true), value(false), value(), value(""), value("plain"),
+        value("\"\\/\b\f\n\r\t\x01\x1f\x7f"), value(std::string("a\0b", 3)), value("\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"),
+        value("\xFF\xC3"), value("\xC0\x80\xED\xA0\x80\xE2\x82"), value("\x80\xBF\xF8\xF4\x90\x80\x80"),
+        value(std::vector<uint8_t>{ 0x67, 0x6F, 0x6F, 0x64 }), value(std::vector<value>{ value(1.0), value(std::vector<value>()) }),
+        value(std::map<std::string, value>{ { "b", value(1.0) }, { "a", value("\xC3\xA9") }, { "B", value() }, { "", value(true) } })
+    };
+
+    for (auto& argument : arguments)
+    {
+        invocation_message invocation("", "Target", std::vector<value>{ argument });
+        auto expected = Json::writeString(getJsonWriter(), createJson(value(std::vector<value>{ argument })));
+
+        auto output = json_hub_protocol().write_message(&invocation);
+        ASSERT_EQ("{\"arguments\":" + expected + ",\"target\":\"Target\",\"type\":1}\x1e", output);
+    }
+}
+
+TEST(json_hub_protocol, doubles_are_written_with_the_fewest_digits_that_round_trip)
+{
+    std::vector<std::pair<double, std::string>> doubles
+    {
+        { 0.1, "0.1" }, { -0.1, "-0.1" }, { 0.30000000000000004, "0.30000000000000004" }, { 1.5, "1.5" }, { 412.37, "412.37" },
+        { 1e-7, "1e-07" }, { 5e-324, "4.94065645841247e-324" }, { 1.7976931348623157e308, "1.7976931348623157e+308" },
+        { 123456.789, "123456.789" }, { 2.0 / 3.0, "0.6666666666666666" },
+        // integral but too large for a uint64_t or an int64_t
+        { 18446744073709551616.0, "1.8446744073709552e+19" }, { -9223372036854777856.0, "-9.223372036854778e+18" }, { 1e300, "1e+300" }
+    };
+
+    for (auto& pair : doubles)
+    {
+        invocation_message invocation("", "Target", std::vector<value>{ value(pair.first) });
+        auto output = json_hub_protocol().write_message(&invocation);
+        ASSERT_EQ("{\"arguments\":[" + pair.second + "],\"target\":\"Target\",\"type\":1}\x1e", output);
+
+        auto parsed = json_hub_protocol().parse_messages(output);
+        ASSERT_EQ(pair.first, static_cast<invocation_message*>(parsed[0].get())->arguments[0].as_double());
+    }
+}
+
+TEST(json_hub_protocol, integers_round_trip_exactly)
+{
+    std::vector<std::pair<value, std::string>> integers
+    {
+        { value(int64_t(0)), "0" }, { value(int64_t(-1)), "-1" }, { value(int64_t(9007199254740993)), "9007199254740993" },
+        { value(INT64_MIN), "-9223372036854775808" }, { value(INT64_MAX), "9223372036854775807" },
+        { value(uint64_t(9223372036854775808u)), "9223372036854775808" }, { value(UINT64_MAX), "18446744073709551615" }
+    };
+
+    for (auto& pair : integers)
+    {
+        invocation_message invocation("", "Target", std::vector<value>{ pair.first });
+        auto output = json_hub_protocol().write_message(&invocation);
+        ASSERT_EQ("{\"arguments\":[" + pair.second + "],\"target\":\"Target\",\"type\":1}\x1e", output);
+
+        auto parsed = json_hub_protocol().parse_messages(output);
+        assert_identical_values(pair.first, static_cast<invocation_message*>(parsed[0].get())->arguments[0]);
+    }
+
+    // integers that only fit in a double and numbers with a fraction or an exponent stay doubles
+    auto parsed = json_hub_protocol().parse_messages("{\"arguments\":[-9223372036854775809,18446744073709551616,1.0,1e2],\"target\":\"Target\",\"type\":1}\x1e");
+    auto& arguments = static_cast<invocation_message*>(parsed[0].get())->arguments;
+    ASSERT_EQ(4u, arguments.size());
+    for (auto& argument : arguments)
+    {
+        ASSERT_TRUE(argument.is_double());
+    }
+    ASSERT_EQ(-9223372036854775808.0, arguments[0].as_double());
+    ASSERT_EQ(100.0, arguments[3].as_double());
+}
+
+TEST(json_hub_protocol, write_message_appends_to_the_payload)
+{
+    std::string payload = "{\"type\":6}\x1e";
+    json_hub_protocol().write_message(std::unique_ptr<hub_message>(new completion_message("1", "", value(42.0), true)).get(), payload);
+    ASSERT_EQ("{\"type\":6}\x1e{\"invocationId\":\"1\",\"result\":42,\"type\":3}\x1e", payload);
+}
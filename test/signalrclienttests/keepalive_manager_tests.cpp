@@ -0,0 +1,155 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "../src/signalrclient/keepalive_manager.h"
+#include "../src/signalrclient/signalr_default_scheduler.h"
+#include "signalrclient/virtual_scheduler.h"
+
+using namespace signalr;
+
+TEST(keepalive_manager, check_runs_once_deadline_reached)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+    auto deadline = scheduler->now() + std::chrono::milliseconds(150);
+
+    int checks = 0;
+    keepalive_manager::clock::time_point checked_at;
+    manager->add(deadline, [&checks, &checked_at](keepalive_manager::clock::time_point now)
+        {
+            ++checks;
+            checked_at = now;
+            return keepalive_manager::clock::time_point::max();
+        });
+
+    scheduler->advance(std::chrono::milliseconds(100));
+    ASSERT_EQ(0, checks);
+
+    scheduler->advance(std::chrono::seconds(1));
+    ASSERT_EQ(1, checks);
+    // checks run at the registration's deadline rather than at the end of its slot
+    ASSERT_EQ(deadline, checked_at);
+    ASSERT_EQ(0u, manager->size());
+}
+
+TEST(keepalive_manager, registrations_sharing_a_slot_are_checked_at_their_own_deadlines)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+    auto start = scheduler->now();
+
+    std::vector<std::chrono::milliseconds> checked_at;
+    auto check = [&checked_at, start](keepalive_manager::clock::time_point now)
+    {
+        checked_at.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(now - start));
+        return keepalive_manager::clock::time_point::max();
+    };
+    manager->add(start + std::chrono::milliseconds(1270), check);
+    manager->add(start + std::chrono::milliseconds(1210), check);
+    manager->add(start + std::chrono::milliseconds(1210), check);
+
+    scheduler->advance(std::chrono::seconds(2));
+    ASSERT_EQ(3u, checked_at.size());
+    ASSERT_EQ(std::chrono::milliseconds(1210), checked_at[0]);
+    ASSERT_EQ(std::chrono::milliseconds(1210), checked_at[1]);
+    ASSERT_EQ(std::chrono::milliseconds(1270), checked_at[2]);
+}
+
+TEST(keepalive_manager, only_due_registrations_are_checked)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+    auto now = scheduler->now();
+
+    int idle_checks = 0;
+    manager->add(now + std::chrono::seconds(30), [&idle_checks](keepalive_manager::clock::time_point)
+        {
+            ++idle_checks;
+            return keepalive_manager::clock::time_point::max();
+        });
+
+    int due_checks = 0;
+    manager->add(now + std::chrono::milliseconds(100), [&due_checks](keepalive_manager::clock::time_point)
+        {
+            ++due_checks;
+            return keepalive_manager::clock::time_point::max();
+        });
+
+    scheduler->advance(std::chrono::seconds(1));
+    ASSERT_EQ(1, due_checks);
+    ASSERT_EQ(0, idle_checks);
+    ASSERT_EQ(1u, manager->size());
+
+    scheduler->advance(std::chrono::seconds(30));
+    ASSERT_EQ(1, idle_checks);
+    ASSERT_EQ(0u, manager->size());
+}
+
+TEST(keepalive_manager, returned_deadline_reschedules_registration)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+
+    int checks = 0;
+    manager->add(scheduler->now() + std::chrono::milliseconds(50), [&checks](keepalive_manager::clock::time_point now)
+        {
+            if (++checks == 3)
+            {
+                return keepalive_manager::clock::time_point::max();
+            }
+            return now + std::chrono::milliseconds(50);
+        });
+
+    scheduler->advance(std::chrono::seconds(10));
+    ASSERT_EQ(3, checks);
+    ASSERT_EQ(0u, manager->size());
+}
+
+TEST(keepalive_manager, deadlines_beyond_one_turn_of_the_wheel_wait_for_their_turn)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+
+    int checks = 0;
+    manager->add(scheduler->now() + std::chrono::minutes(2), [&checks](keepalive_manager::clock::time_point)
+        {
+            ++checks;
+            return keepalive_manager::clock::time_point::max();
+        });
+
+    scheduler->advance(std::chrono::minutes(2) - std::chrono::milliseconds(100));
+    ASSERT_EQ(0, checks);
+
+    scheduler->advance(std::chrono::milliseconds(100));
+    ASSERT_EQ(1, checks);
+}
+
+TEST(keepalive_manager, removed_registration_is_not_checked)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto manager = keepalive_manager::create(scheduler);
+
+    bool called = false;
+    auto id = manager->add(scheduler->now() + std::chrono::milliseconds(100), [&called](keepalive_manager::clock::time_point)
+        {
+            called = true;
+            return keepalive_manager::clock::time_point::max();
+        });
+    manager->remove(id);
+    ASSERT_EQ(0u, manager->size());
+
+    scheduler->advance(std::chrono::seconds(1));
+    ASSERT_FALSE(called);
+}
+
+TEST(keepalive_manager, managers_are_shared_per_scheduler)
+{
+    auto scheduler = std::make_shared<signalr_default_scheduler>();
+
+    auto manager = keepalive_manager::for_scheduler(scheduler);
+    ASSERT_EQ(manager, keepalive_manager::for_scheduler(scheduler));
+    ASSERT_NE(manager, keepalive_manager::for_scheduler(std::make_shared<signalr_default_scheduler>()));
+}
@@ -0,0 +1,126 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "../src/signalrclient/message_framer.h"
+#include <string>
+
+using namespace signalr;
+
+namespace
+{
+    // the messages taken out after each frame, for frames that split the text at every possible place
+    std::vector<std::string> take_split(message_framer& framer, const std::string& text, size_t split)
+    {
+        std::vector<std::string> taken;
+        framer.append(text.substr(0, split));
+        taken.push_back(framer.take_messages());
+        framer.append(text.substr(split));
+        taken.push_back(framer.take_messages());
+        return taken;
+    }
+}
+
+TEST(message_framer, takes_whole_frames_without_copying_them)
+{
+    message_framer framer(transfer_format::text);
+
+    std::string frame = "{\"type\":6}\x1e{\"type\":6}\x1e";
+    frame.reserve(1000);
+    auto data = frame.data();
+    framer.append(std::move(frame));
+
+    auto messages = framer.take_messages();
+    ASSERT_EQ("{\"type\":6}\x1e{\"type\":6}\x1e", messages);
+    ASSERT_EQ(data, messages.data());
+    ASSERT_EQ(0, framer.incomplete_length());
+}
+
+TEST(message_framer, takes_messages_split_at_any_position)
+{
+    const std::string text = "{\"type\":1,\"target\":\"a\",\"arguments\":[\"\xE2\x82\xAC\"]}\x1e{\"type\":6}\x1e";
+
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        message_framer framer(transfer_format::text);
+        auto taken = take_split(framer, text, split);
+
+        // the first frame gives the messages it finished, the second the rest of them
+        auto first_end = text.find('\x1e');
+        ASSERT_EQ(split > text.size() - 1 ? text : split > first_end ? text.substr(0, first_end + 1) : "", taken[0]) << split;
+        ASSERT_EQ(text, taken[0] + taken[1]) << split;
+        ASSERT_EQ(0, framer.incomplete_length()) << split;
+    }
+}
+
+TEST(message_framer, keeps_incomplete_messages_until_they_are_complete)
+{
+    message_framer framer(transfer_format::text);
+
+    framer.append("{\"type\":6}\x1e{\"ty");
+    ASSERT_EQ("{\"type\":6}\x1e", framer.take_messages());
+    ASSERT_EQ(4, framer.incomplete_length());
+
+    framer.append("pe\"");
+    ASSERT_EQ("", framer.take_messages());
+    framer.append(":6");
+    ASSERT_EQ("", framer.take_messages());
+    ASSERT_EQ(9, framer.incomplete_length());
+
+    framer.append("}\x1e");
+    ASSERT_EQ("{\"type\":6}\x1e", framer.take_messages());
+    ASSERT_EQ(0, framer.incomplete_length());
+}
+
+TEST(message_framer, takes_the_handshake_response_by_itself)
+{
+    message_framer framer(transfer_format::text);
+
+    framer.append("{");
+    std::string handshake;
+    ASSERT_FALSE(framer.take_handshake(handshake));
+    framer.append("}\x1e{\"type\":6}\x1e{\"ty");
+    ASSERT_TRUE(framer.take_handshake(handshake));
+    ASSERT_EQ("{}\x1e", handshake);
+
+    ASSERT_EQ("{\"type\":6}\x1e", framer.take_messages());
+
+    framer.reset();
+    ASSERT_EQ(0, framer.incomplete_length());
+    ASSERT_EQ("", framer.take_messages());
+}
+
+#ifdef USE_MSGPACK
+TEST(message_framer, takes_binary_messages_split_at_any_position)
+{
+    // a message with a two byte length prefix followed by two pings
+    const std::string text = std::string("\x80\x01", 2) + std::string(128, '\x1e') + std::string("\x02\x91\x06\x02\x91\x06", 6);
+
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        message_framer framer(transfer_format::binary);
+        auto taken = take_split(framer, text, split);
+
+        auto expected_first = split < 130 ? 0 : split < 133 ? 130 : split < 136 ? 133 : 136;
+        ASSERT_EQ(text.substr(0, expected_first), taken[0]) << split;
+        ASSERT_EQ(text, taken[0] + taken[1]) << split;
+        ASSERT_EQ(0, framer.incomplete_length()) << split;
+    }
+}
+
+TEST(message_framer, takes_binary_messages_after_the_text_handshake_response)
+{
+    message_framer framer(transfer_format::binary);
+
+    // record separators in binary messages aren't the end of anything
+    framer.append(std::string("{}\x1e\x03\x91\x1e", 6));
+    std::string handshake;
+    ASSERT_TRUE(framer.take_handshake(handshake));
+    ASSERT_EQ("{}\x1e", handshake);
+    ASSERT_EQ("", framer.take_messages());
+
+    framer.append(std::string("\x06\x02\x91\x06", 4));
+    ASSERT_EQ(std::string("\x03\x91\x1e\x06\x02\x91\x06", 7), framer.take_messages());
+}
+#endif
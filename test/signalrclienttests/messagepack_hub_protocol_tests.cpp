@@ -21,11 +21,11 @@ namespace
     {
         // invocation message without invocation id
         { string_from_bytes({0x12, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x92, 0x01, 0xA3, 0x46, 0x6F, 0x6F, 0x90}),
-        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(1.f), value("Foo") })) },
+        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
 
         // invocation message with multiple arguments
         { string_from_bytes({0x15, 0x96, 0x01, 0x80, 0xA3, 0x31, 0x32, 0x33, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x92, 0x01, 0xA3, 0x46, 0x6F, 0x6F, 0x90}),
-        std::shared_ptr<hub_message>(new invocation_message("123", "Target", std::vector<value>{ value(1.f), value("Foo") })) },
+        std::shared_ptr<hub_message>(new invocation_message("123", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
 
         // invocation message with bool argument
         { string_from_bytes({0x0E, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0xC3, 0x90}),
@@ -45,16 +45,24 @@ namespace
 
         // invocation message with object argument
         { string_from_bytes({0x18, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0x81, 0xA8, 0x70, 0x72, 0x6F, 0x70, 0x65, 0x72, 0x74, 0x79, 0x05, 0x90}),
-        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::map<std::string, value>{ {"property", value(5.f)} }) })) },
+        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::map<std::string, value>{ {"property", value(int64_t(5))} }) })) },
 
         // invocation message with array argument
         { string_from_bytes({0x10, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0x92, 0x01, 0x05, 0x90}),
-        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::vector<value>{value(1.f), value(5.f)}) })) },
+        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::vector<value>{value(int64_t(1)), value(int64_t(5))}) })) },
 
         // invocation message with binary argument
         { string_from_bytes({0x14, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0xC4, 0x05, 0x17, 0x36, 0x45, 0x6D, 0xC8, 0x90}),
         std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(std::vector<uint8_t>{23, 54, 69, 109, 200}) })) },
 
+        // invocation message with smallest int64 argument
+        { string_from_bytes({0x16, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0xD3, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x90}),
+        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(INT64_MIN) })) },
+
+        // invocation message with largest uint64 argument
+        { string_from_bytes({0x16, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0xCF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x90}),
+        std::shared_ptr<hub_message>(new invocation_message("", "Target", std::vector<value>{ value(UINT64_MAX) })) },
+
         // ping message
         { string_from_bytes({0x02, 0x91, 0x06}),
         std::shared_ptr<hub_message>(new ping_message()) },
@@ -65,7 +73,7 @@ namespace
 
         // completion message with result
         { string_from_bytes({0x07, 0x95, 0x03, 0x80, 0xA1, 0x31, 0x03, 0x2A}),
-        std::shared_ptr<hub_message>(new completion_message("1", "", value(42.f), true)) },
+        std::shared_ptr<hub_message>(new completion_message("1", "", value(int64_t(42)), true)) },
 
         // completion message with no result or error
         { string_from_bytes({0x06, 0x94, 0x03, 0x80, 0xA1, 0x31, 0x02}),
@@ -74,6 +82,22 @@ namespace
         // completion message with null result
         { string_from_bytes({0x07, 0x95, 0x03, 0x80, 0xA1, 0x31, 0x03, 0xC0}),
         std::shared_ptr<hub_message>(new completion_message("1", "", value(), true)) },
+
+        // invocation message with stream ids
+        { string_from_bytes({0x13, 0x96, 0x01, 0x80, 0xA1, 0x31, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x91, 0x01, 0x92, 0xA1, 0x32, 0xA1, 0x33}),
+        std::shared_ptr<hub_message>(new invocation_message("1", "Target", std::vector<value>{ value(int64_t(1)) }, std::vector<std::string>{ "2", "3" })) },
+
+        // stream invocation message
+        { string_from_bytes({0x13, 0x96, 0x04, 0x80, 0xA1, 0x31, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x92, 0x01, 0xA3, 0x46, 0x6F, 0x6F, 0x90}),
+        std::shared_ptr<hub_message>(new invocation_message(message_type::stream_invocation, "1", "Target", std::vector<value>{ value(int64_t(1)), value("Foo") })) },
+
+        // stream item message
+        { string_from_bytes({0x06, 0x94, 0x02, 0x80, 0xA1, 0x31, 0x2A}),
+        std::shared_ptr<hub_message>(new stream_item_message("1", value(int64_t(42)))) },
+
+        // cancel invocation message
+        { string_from_bytes({0x05, 0x93, 0x05, 0x80, 0xA1, 0x31}),
+        std::shared_ptr<hub_message>(new cancel_invocation_message("1")) },
     };
 }
 
@@ -82,10 +106,60 @@ TEST(messagepack_hub_protocol, write_message)
     for (auto& data : protocol_test_data)
     {
         auto output = messagepack_hub_protocol().write_message(data.second.get());
-        ASSERT_STREQ(data.first.data(), output.data());
+        ASSERT_EQ(data.first, output);
+    }
+}
+
+TEST(messagepack_hub_protocol, write_message_prefixes_messages_of_any_length)
+{
+    messagepack_hub_protocol protocol;
+
+    // lengths around where the prefix grows, written in an order that makes the guessed length wrong both ways
+    for (size_t length : { 0x3FF0, 0x10, 0x7F, 0x3FF0, 0x4000, 0x60, 0x1FFFF0, 0x70 })
+    {
+        std::vector<uint8_t> data(length, 0x2A);
+        invocation_message invocation("", "Target", std::vector<value>{ value(data) });
+        auto output = protocol.write_message(&invocation);
+
+        auto messages = protocol.parse_messages(output);
+        ASSERT_EQ(1, messages.size()) << length;
+        assert_hub_message_equality(&invocation, messages[0].get());
     }
 }
 
+TEST(messagepack_hub_protocol, integers_round_trip_exactly)
+{
+    messagepack_hub_protocol protocol;
+
+    for (auto& argument : { value(int64_t(0)), value(int64_t(-1)), value(int64_t(9007199254740993)), value(INT64_MIN), value(INT64_MAX),
+        value(uint64_t(9223372036854775808u)), value(UINT64_MAX) })
+    {
+        invocation_message invocation("", "Target", std::vector<value>{ argument });
+        auto messages = protocol.parse_messages(protocol.write_message(&invocation));
+        ASSERT_EQ(1, messages.size());
+        assert_hub_message_equality(&invocation, messages[0].get());
+    }
+}
+
+TEST(messagepack_hub_protocol, integers_parse_as_int64_unless_they_only_fit_uint64)
+{
+    // 1 as uint64, 1 as int64, 255 as uint8, -1 as int16, INT64_MAX as uint64 and 2^63 as uint64
+    auto payload = string_from_bytes({ 0x36, 0x96, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x96,
+        0xCF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0xCC, 0xFF,
+        0xD1, 0xFF, 0xFF,
+        0xCF, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xCF, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x90 });
+    auto output = messagepack_hub_protocol().parse_messages(payload);
+    ASSERT_EQ(1, output.size());
+
+    invocation_message expected("", "Target", std::vector<value>{ value(int64_t(1)), value(int64_t(1)), value(int64_t(255)),
+        value(int64_t(-1)), value(INT64_MAX), value(uint64_t(9223372036854775808u)) });
+    assert_hub_message_equality(&expected, output[0].get());
+}
+
 TEST(messagepack_hub_protocol, parse_message)
 {
     for (auto& data : protocol_test_data)
@@ -106,13 +180,13 @@ TEST(messagepack_hub_protocol, can_parse_multiple_messages)
     invocation_message invocation = invocation_message("", "Target", std::vector<value>{});
     assert_hub_message_equality(&invocation, output[0].get());
 
-    completion_message completion = completion_message("1", "", value(42.f), true);
+    completion_message completion = completion_message("1", "", value(int64_t(42)), true);
     assert_hub_message_equality(&completion, output[1].get());
 }
 
 TEST(messagepack_hub_protocol, extra_items_ignored_when_parsing)
 {
-    invocation_message message = invocation_message("", "Target", std::vector<value>{value(1.f), value("Foo")});
+    invocation_message message = invocation_message("", "Target", std::vector<value>{value(int64_t(1)), value("Foo")});
     auto payload = string_from_bytes({ 0x16, 0x97, 0x01, 0x80, 0xC0, 0xA6, 0x54, 0x61, 0x72, 0x67, 0x65, 0x74, 0x92, 0x01, 0xA3, 0x46, 0x6F, 0x6F, 0x90, 0xA3, 0x46, 0x6F, 0x6F});
     auto output = messagepack_hub_protocol().parse_messages(payload);
     ASSERT_EQ(1, output.size());
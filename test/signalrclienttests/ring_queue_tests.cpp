@@ -0,0 +1,58 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "../src/signalrclient/ring_queue.h"
+#include <string>
+
+using namespace signalr;
+
+TEST(ring_queue, items_come_out_in_order)
+{
+    ring_queue<int> queue;
+    ASSERT_TRUE(queue.empty());
+
+    for (int i = 0; i < 5; ++i)
+    {
+        queue.push_back(int(i));
+    }
+
+    ASSERT_EQ(5u, queue.size());
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_EQ(i, queue.pop_front());
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(ring_queue, keeps_order_when_growing_after_wrapping_around)
+{
+    ring_queue<std::string> queue;
+    int next_in = 0;
+    int next_out = 0;
+
+    // wrap the head around the buffer a few times before growing it
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            queue.push_back(std::to_string(next_in++));
+        }
+        for (int i = 0; i < 8; ++i)
+        {
+            ASSERT_EQ(std::to_string(next_out++), queue.pop_front());
+        }
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        queue.push_back(std::to_string(next_in++));
+    }
+
+    while (!queue.empty())
+    {
+        ASSERT_EQ(std::to_string(next_out++), queue.pop_front());
+    }
+    ASSERT_EQ(next_in, next_out);
+}
@@ -5,6 +5,8 @@
 #include "stdafx.h"
 #include "test_utils.h"
 #include "../src/signalrclient/signalr_default_scheduler.h"
+#include "signalrclient/signalr_client_config.h"
+#include <atomic>
 
 using namespace signalr;
 
@@ -96,4 +98,242 @@ TEST(scheduler, scheduler_can_destruct_with_callbacks_registered)
     }
     continue_mre.set();
     start_mre.get();
-}
\ No newline at end of file
+}
+TEST(scheduler, delayed_callbacks_run_in_deadline_order)
+{
+    signalr_default_scheduler scheduler;
+
+    std::mutex order_lock;
+    std::vector<int> order;
+    auto mre = manual_reset_event<void>();
+
+    // scheduled in reverse order of their deadlines
+    for (int i = 4; i >= 0; --i)
+    {
+        scheduler.schedule([i, &order_lock, &order, &mre]()
+            {
+                bool done;
+                {
+                    std::lock_guard<std::mutex> lock(order_lock);
+                    order.push_back(i);
+                    done = order.size() == 5;
+                }
+
+                // set after unlocking, the test can return and destroy the lock as soon as it's set
+                if (done)
+                {
+                    mre.set();
+                }
+            }, std::chrono::milliseconds(50 + 50 * i));
+    }
+
+    mre.get();
+
+    ASSERT_EQ((std::vector<int>{ 0, 1, 2, 3, 4 }), order);
+}
+
+TEST(scheduler, earlier_deadline_scheduled_later_runs_first)
+{
+    signalr_default_scheduler scheduler;
+
+    auto mre = manual_reset_event<void>();
+    auto late_mre = manual_reset_event<void>();
+    std::atomic<bool> late_callback_ran{ false };
+
+    scheduler.schedule([&late_callback_ran, &late_mre]()
+        {
+            late_callback_ran = true;
+            late_mre.set();
+        }, std::chrono::seconds(1));
+
+    // the dispatcher is sleeping until the first deadline and must be woken for this one
+    scheduler.schedule([&mre]()
+        {
+            mre.set();
+        }, std::chrono::milliseconds(50));
+
+    mre.get();
+    ASSERT_FALSE(late_callback_ran);
+    late_mre.get();
+}
+
+TEST(scheduler, runs_more_callbacks_than_workers)
+{
+    signalr_default_scheduler scheduler;
+
+    const int count = 100;
+    std::atomic<int> run_count{ 0 };
+    auto mre = manual_reset_event<void>();
+
+    for (int i = 0; i < count; ++i)
+    {
+        scheduler.schedule([&run_count, &mre]()
+            {
+                if (++run_count == count)
+                {
+                    mre.set();
+                }
+            });
+    }
+
+    mre.get();
+    ASSERT_EQ(count, run_count.load());
+}
+
+TEST(scheduler, default_scheduler_is_shared_between_configs)
+{
+    signalr_client_config first;
+    signalr_client_config second;
+
+    ASSERT_EQ(first.get_scheduler(), second.get_scheduler());
+}
+
+TEST(scheduler, shared_default_scheduler_is_only_shared_between_configs_with_the_same_thread_settings)
+{
+    signalr_client_config first;
+    first.set_scheduler_thread_count(2);
+    signalr_client_config second;
+    second.set_scheduler_thread_count(2);
+    signalr_client_config more_threads;
+    more_threads.set_scheduler_thread_count(3);
+    signalr_client_config named;
+    named.set_scheduler_thread_count(2);
+    named.set_scheduler_thread_name("named");
+
+    ASSERT_EQ(first.get_scheduler(), second.get_scheduler());
+    ASSERT_NE(first.get_scheduler(), more_threads.get_scheduler());
+    ASSERT_NE(first.get_scheduler(), named.get_scheduler());
+}
+
+TEST(scheduler, default_scheduler_is_created_on_first_use_and_shared_by_copies)
+{
+    signalr_client_config config;
+    config.set_use_shared_scheduler(false);
+    auto earlier_copy = config;
+
+    const auto& scheduler = config.get_scheduler();
+    ASSERT_NE(nullptr, scheduler);
+    ASSERT_EQ(scheduler, earlier_copy.get_scheduler());
+
+    auto copy = config;
+    ASSERT_EQ(scheduler, copy.get_scheduler());
+
+    copy.set_scheduler_thread_count(1);
+    ASSERT_NE(scheduler, copy.get_scheduler());
+    ASSERT_EQ(scheduler, config.get_scheduler());
+}
+
+TEST(scheduler, default_scheduler_is_created_once_when_first_used_from_several_threads)
+{
+    signalr_client_config config;
+    config.set_use_shared_scheduler(false);
+
+    std::vector<std::shared_ptr<scheduler>> schedulers(4);
+    std::vector<std::thread> threads;
+    for (auto& scheduler : schedulers)
+    {
+        threads.emplace_back([&config, &scheduler]()
+            {
+                scheduler = config.get_scheduler();
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto& scheduler : schedulers)
+    {
+        ASSERT_EQ(config.get_scheduler(), scheduler);
+    }
+}
+
+TEST(scheduler, config_can_opt_out_of_shared_default_scheduler)
+{
+    signalr_client_config shared;
+    signalr_client_config isolated;
+    isolated.set_use_shared_scheduler(false);
+
+    ASSERT_NE(shared.get_scheduler(), isolated.get_scheduler());
+
+    auto mre = manual_reset_event<void>();
+    isolated.get_scheduler()->schedule([&mre]()
+        {
+            mre.set();
+        });
+    mre.get();
+}
+
+TEST(scheduler, metrics_are_disabled_by_default)
+{
+    signalr_default_scheduler scheduler;
+
+    scheduler_metrics metrics;
+    ASSERT_FALSE(scheduler.get_metrics(metrics));
+}
+
+TEST(scheduler, metrics_record_dispatch_latency_timer_lateness_and_busy_time)
+{
+    thread_pool_options options;
+    options.thread_count = 2;
+    signalr_default_scheduler scheduler(options);
+    scheduler.enable_metrics();
+
+    auto mre = manual_reset_event<void>();
+    scheduler.schedule([]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+    scheduler.schedule([&mre]()
+        {
+            mre.set();
+        }, std::chrono::milliseconds(50));
+    mre.get();
+
+    scheduler_metrics metrics;
+    ASSERT_TRUE(scheduler.get_metrics(metrics));
+    ASSERT_LE(2u, metrics.dispatch_latency.count);
+    ASSERT_EQ(1u, metrics.timer_lateness.count);
+    ASSERT_LE(1u, metrics.peak_queue_depth);
+    ASSERT_EQ(0u, metrics.pending_timers);
+    ASSERT_EQ(2u, metrics.worker_busy_time.size());
+
+    std::chrono::microseconds busy{ 0 };
+    for (auto worker_busy : metrics.worker_busy_time)
+    {
+        busy += worker_busy;
+    }
+    ASSERT_LE(std::chrono::milliseconds(20), busy);
+
+    uint64_t bucketed = 0;
+    for (auto count : metrics.dispatch_latency.buckets)
+    {
+        bucketed += count;
+    }
+    ASSERT_EQ(metrics.dispatch_latency.count, bucketed);
+}
+
+TEST(scheduler, metrics_are_pushed_to_callback)
+{
+    signalr_client_config config;
+    config.set_use_shared_scheduler(false);
+
+    // pushes can still be running on a worker when the test returns
+    auto mre = std::make_shared<manual_reset_event<void>>();
+    auto pushes = std::make_shared<std::atomic<int>>(0);
+    config.set_scheduler_metrics_callback([mre, pushes](const scheduler_metrics&)
+        {
+            if (++*pushes == 2)
+            {
+                mre->set();
+            }
+        }, std::chrono::milliseconds(20));
+
+    ASSERT_TRUE(config.get_scheduler_metrics_enabled());
+    // pushes start with the scheduler, which a connection creates when it starts
+    config.get_scheduler();
+    mre->get();
+
+    scheduler_metrics metrics;
+    ASSERT_TRUE(config.get_scheduler_metrics(metrics));
+}
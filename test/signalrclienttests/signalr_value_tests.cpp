@@ -0,0 +1,189 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "signalrclient/signalr_exception.h"
+#include "signalrclient/signalr_value.h"
+#include <stdexcept>
+
+using namespace signalr;
+
+namespace
+{
+    std::vector<std::string> member_names(const value_map& map)
+    {
+        std::vector<std::string> names;
+        for (auto& member : map)
+        {
+            names.push_back(member.first);
+        }
+        return names;
+    }
+}
+
+TEST(value_map, members_are_sorted_by_name)
+{
+    std::vector<std::pair<std::string, value>> members;
+    members.emplace_back("symbol", value("MSFT"));
+    members.emplace_back("price", value(412.37));
+    members.emplace_back("change", value(-1.25));
+    members.emplace_back("", value());
+    value_map map(std::move(members));
+
+    ASSERT_EQ((std::vector<std::string>{ "", "change", "price", "symbol" }), member_names(map));
+    ASSERT_EQ(4u, map.size());
+    ASSERT_FALSE(map.empty());
+    ASSERT_TRUE(value_map().empty());
+}
+
+TEST(value_map, find_count_and_at_look_up_members_by_name)
+{
+    value_map map(std::map<std::string, value>
+        {
+            { "a", value(1.0) }, { "b", value(2.0) }, { "d", value(4.0) }
+        });
+
+    for (auto name : { "a", "b", "d" })
+    {
+        auto found = map.find(name);
+        ASSERT_NE(map.end(), found) << name;
+        ASSERT_EQ(name, found->first);
+        ASSERT_EQ(1u, map.count(name));
+        ASSERT_EQ(found->second.as_double(), map.at(name).as_double());
+    }
+
+    for (auto name : { "", "c", "e", "A" })
+    {
+        ASSERT_EQ(map.end(), map.find(name)) << name;
+        ASSERT_EQ(0u, map.count(name));
+        ASSERT_THROW(map.at(name), std::out_of_range);
+    }
+}
+
+TEST(value_map, keeps_the_first_of_duplicate_members)
+{
+    std::vector<std::pair<std::string, value>> members;
+    members.emplace_back("b", value(1.0));
+    members.emplace_back("a", value(2.0));
+    members.emplace_back("b", value(3.0));
+    members.emplace_back("b", value(4.0));
+    value_map map(std::move(members));
+
+    ASSERT_EQ((std::vector<std::string>{ "a", "b" }), member_names(map));
+    ASSERT_EQ(1.0, map.at("b").as_double());
+}
+
+TEST(value, map_converts_to_and_from_std_map)
+{
+    value v(std::map<std::string, value>
+        {
+            { "name", value("player one") }, { "flags", value(std::vector<value>{ value(true) }) }
+        });
+    ASSERT_TRUE(v.is_map());
+
+    // code written against a std::map keeps working, the members are copied to it once
+    const std::map<std::string, value>& map = v.as_map();
+    ASSERT_EQ(2u, map.size());
+    ASSERT_EQ("player one", map.at("name").as_string());
+    ASSERT_TRUE(map.at("flags").as_array()[0].as_bool());
+    ASSERT_EQ(&map, &v.as_map());
+
+    auto& value_map = v.as_value_map();
+    ASSERT_EQ(2u, value_map.size());
+    ASSERT_EQ("player one", value_map.at("name").as_string());
+    ASSERT_THROW(value(1.0).as_value_map(), signalr_exception);
+}
+
+TEST(value, map_is_copied_and_moved_with_its_members)
+{
+    value original(std::map<std::string, value>
+        {
+            { "nested", value(std::map<std::string, value>{ { "x", value(1.0) } }) }, { "text", value("a string that does not fit in place") }
+        });
+
+    value copy(original);
+    ASSERT_NE(&original.as_map(), &copy.as_map());
+    ASSERT_EQ(1.0, copy.as_map().at("nested").as_map().at("x").as_double());
+    ASSERT_EQ("a string that does not fit in place", original.as_map().at("text").as_string());
+
+    value moved(std::move(copy));
+    ASSERT_EQ(1.0, moved.as_map().at("nested").as_map().at("x").as_double());
+
+    value assigned;
+    assigned = moved;
+    ASSERT_EQ(2u, assigned.as_map().size());
+    assigned = value(value_type::map);
+    ASSERT_TRUE(assigned.as_map().empty());
+    ASSERT_EQ(2u, moved.as_map().size());
+}
+
+TEST(value_array, elements_are_accessed_like_a_vector)
+{
+    value v(std::vector<value>{ value(1.0), value("two"), value(true) });
+    auto& array = v.as_value_array();
+
+    ASSERT_EQ(3u, array.size());
+    ASSERT_FALSE(array.empty());
+    ASSERT_EQ(1.0, array.front().as_double());
+    ASSERT_EQ("two", array[1].as_string());
+    ASSERT_TRUE(array.back().as_bool());
+    ASSERT_EQ("two", array.at(1).as_string());
+    ASSERT_THROW(array.at(3), std::out_of_range);
+    ASSERT_TRUE(value(value_type::array).as_value_array().empty());
+
+    size_t count = 0;
+    for (auto& element : array)
+    {
+        ASSERT_EQ(array[count++].type(), element.type());
+    }
+    ASSERT_EQ(3u, count);
+
+    // code written against a std::vector keeps working, the elements are copied to it once
+    const std::vector<value>& vector = v.as_array();
+    ASSERT_EQ(3u, vector.size());
+    ASSERT_EQ("two", vector[1].as_string());
+    ASSERT_EQ(&vector, &v.as_array());
+}
+
+TEST(value, integers_are_stored_exactly)
+{
+    value large(int64_t(9007199254740993));
+    ASSERT_TRUE(large.is_int64());
+    ASSERT_FALSE(large.is_double());
+    ASSERT_EQ(9007199254740993, large.as_int64());
+    ASSERT_EQ(9007199254740993u, large.as_uint64());
+    // converted to the nearest double
+    ASSERT_EQ(9007199254740992.0, large.as_double());
+
+    value max(UINT64_MAX);
+    ASSERT_TRUE(max.is_uint64());
+    ASSERT_EQ(UINT64_MAX, max.as_uint64());
+    ASSERT_THROW(max.as_int64(), signalr_exception);
+    ASSERT_EQ(int64_t(42), value(uint64_t(42)).as_int64());
+
+    ASSERT_THROW(value(int64_t(-1)).as_uint64(), signalr_exception);
+    ASSERT_THROW(value(1.0).as_int64(), signalr_exception);
+    ASSERT_EQ(0, value(value_type::int64).as_int64());
+
+    value copy(large);
+    copy = max;
+    ASSERT_EQ(UINT64_MAX, copy.as_uint64());
+}
+
+TEST(value, is_number_matches_doubles_and_integers)
+{
+    ASSERT_TRUE(value(1.5).is_number());
+    ASSERT_TRUE(value(int64_t(-1)).is_number());
+    ASSERT_TRUE(value(UINT64_MAX).is_number());
+    ASSERT_FALSE(value(int64_t(1)).is_double());
+
+    // as_double reads every number
+    ASSERT_EQ(-1.0, value(int64_t(-1)).as_double());
+    ASSERT_EQ(18446744073709551616.0, value(UINT64_MAX).as_double());
+    ASSERT_THROW(value("1").as_double(), signalr_exception);
+
+    ASSERT_FALSE(value().is_number());
+    ASSERT_FALSE(value(true).is_number());
+    ASSERT_FALSE(value("1").is_number());
+}
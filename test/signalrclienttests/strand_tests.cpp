@@ -0,0 +1,129 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "../src/signalrclient/strand.h"
+#include "../src/signalrclient/signalr_default_scheduler.h"
+#include <atomic>
+
+using namespace signalr;
+
+TEST(strand, callbacks_run_in_order_and_never_concurrently)
+{
+    const int count = 2000;
+    auto strand = strand::create(std::make_shared<signalr_default_scheduler>());
+
+    std::vector<int> order;
+    std::atomic<int> running(0);
+    std::atomic<bool> overlapped(false);
+    auto mre = manual_reset_event<void>();
+    for (int i = 0; i < count; ++i)
+    {
+        strand->schedule([i, count, &order, &running, &overlapped, &mre]()
+            {
+                if (++running != 1)
+                {
+                    overlapped = true;
+                }
+                order.push_back(i);
+                --running;
+
+                if (i == count - 1)
+                {
+                    mre.set();
+                }
+            });
+    }
+
+    mre.get();
+    ASSERT_FALSE(overlapped.load());
+    ASSERT_EQ((size_t)count, order.size());
+    for (int i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(i, order[i]);
+    }
+}
+
+TEST(strand, strands_sharing_a_scheduler_run_independently)
+{
+    auto scheduler = std::make_shared<signalr_default_scheduler>();
+    auto first = strand::create(scheduler);
+    auto second = strand::create(scheduler);
+
+    auto blocked = manual_reset_event<void>();
+    auto unblock = manual_reset_event<void>();
+    auto mre = manual_reset_event<void>();
+    auto done = manual_reset_event<void>();
+
+    first->schedule([&blocked, &unblock, &done]()
+        {
+            blocked.set();
+            unblock.get();
+            done.set();
+        });
+    blocked.get();
+
+    // the first strand is busy, the second one can still make progress
+    second->schedule([&mre]()
+        {
+            mre.set();
+        });
+    mre.get();
+
+    unblock.set();
+    // avoids referencing the events after they've been destructed
+    done.get();
+}
+
+TEST(strand, dispatch_runs_inline_when_idle)
+{
+    auto strand = strand::create(std::make_shared<signalr_default_scheduler>());
+
+    auto current_thread = std::this_thread::get_id();
+    std::thread::id id;
+    strand->dispatch([&id]()
+        {
+            id = std::this_thread::get_id();
+        });
+
+    ASSERT_EQ(current_thread, id);
+}
+
+TEST(strand, dispatch_queues_behind_running_callback)
+{
+    auto strand = strand::create(std::make_shared<signalr_default_scheduler>());
+
+    std::vector<int> order;
+    auto mre = manual_reset_event<void>();
+    strand->dispatch([&strand, &order, &mre]()
+        {
+            // re-entrant dispatch doesn't run inline, it waits for the running callback to finish
+            strand->dispatch([&order, &mre]()
+                {
+                    order.push_back(2);
+                    mre.set();
+                });
+            order.push_back(1);
+        });
+
+    mre.get();
+    ASSERT_EQ(std::vector<int>({ 1, 2 }), order);
+}
+
+TEST(strand, delayed_callback_is_delayed)
+{
+    auto strand = strand::create(std::make_shared<signalr_default_scheduler>());
+    auto delay = std::chrono::milliseconds(100);
+
+    auto mre = manual_reset_event<void>();
+    auto start = std::chrono::steady_clock::now();
+    strand->schedule([&mre]()
+        {
+            mre.set();
+        }, delay);
+
+    mre.get();
+    ASSERT_LE(delay, std::chrono::steady_clock::now() - start);
+}
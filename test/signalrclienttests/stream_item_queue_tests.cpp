@@ -0,0 +1,154 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "../src/signalrclient/stream_item_queue.h"
+#include "signalrclient/signalr_exception.h"
+#include "signalrclient/virtual_scheduler.h"
+
+using namespace signalr;
+
+namespace
+{
+    struct stream_record
+    {
+        std::vector<double> items;
+        int completions = 0;
+        std::exception_ptr error;
+        std::vector<bool> full_changes;
+    };
+
+    std::shared_ptr<stream_item_queue> create_queue(const std::shared_ptr<virtual_scheduler>& scheduler, size_t capacity, stream_record& record)
+    {
+        return stream_item_queue::create(scheduler, capacity,
+            [&record](const signalr::value& item) { record.items.push_back(item.as_double()); },
+            [&record](std::exception_ptr error) { ++record.completions; record.error = error; },
+            [&record](bool full) { record.full_changes.push_back(full); });
+    }
+}
+
+TEST(stream_item_queue, delivers_items_in_order_then_completes)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    stream_record record;
+    auto queue = create_queue(scheduler, 64, record);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        queue->push(signalr::value(static_cast<double>(i)));
+    }
+    queue->complete(nullptr);
+    // nothing is delivered on the thread pushing the items
+    ASSERT_TRUE(record.items.empty());
+
+    scheduler->run_until_idle();
+
+    ASSERT_EQ(10u, record.items.size());
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(i, record.items[i]);
+    }
+    ASSERT_EQ(1, record.completions);
+    ASSERT_EQ(nullptr, record.error);
+    ASSERT_TRUE(record.full_changes.empty());
+}
+
+TEST(stream_item_queue, reports_full_at_capacity_and_room_at_half)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    std::vector<bool> full_changes;
+    // how many changes had been reported when each item was delivered
+    std::vector<size_t> changes_at_item;
+    auto queue = stream_item_queue::create(scheduler, 4,
+        [&full_changes, &changes_at_item](const signalr::value&) { changes_at_item.push_back(full_changes.size()); },
+        [](std::exception_ptr) {},
+        [&full_changes](bool full) { full_changes.push_back(full); });
+
+    for (int i = 0; i < 3; ++i)
+    {
+        queue->push(signalr::value(static_cast<double>(i)));
+    }
+    ASSERT_TRUE(full_changes.empty());
+
+    queue->push(signalr::value(3.0));
+    ASSERT_EQ(std::vector<bool>{ true }, full_changes);
+
+    scheduler->run_until_idle();
+
+    // room is reported once taking the second item leaves two in the queue, before that item is delivered
+    ASSERT_EQ((std::vector<bool>{ true, false }), full_changes);
+    ASSERT_EQ((std::vector<size_t>{ 1, 2, 2, 2 }), changes_at_item);
+}
+
+TEST(stream_item_queue, completing_a_full_queue_reports_room)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    stream_record record;
+    auto queue = create_queue(scheduler, 2, record);
+
+    queue->push(signalr::value(1.0));
+    queue->push(signalr::value(2.0));
+    queue->complete(std::make_exception_ptr(signalr_exception("failed")));
+
+    // the queued items are still delivered, but nothing else will come to hold the connection back for
+    ASSERT_EQ((std::vector<bool>{ true, false }), record.full_changes);
+    ASSERT_TRUE(record.items.empty());
+
+    scheduler->run_until_idle();
+
+    ASSERT_EQ((std::vector<double>{ 1, 2 }), record.items);
+    ASSERT_EQ(1, record.completions);
+    try
+    {
+        std::rethrow_exception(record.error);
+    }
+    catch (const signalr_exception& e)
+    {
+        ASSERT_STREQ("failed", e.what());
+    }
+}
+
+TEST(stream_item_queue, cancel_drops_queued_items)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    stream_record record;
+    auto queue = create_queue(scheduler, 2, record);
+
+    queue->push(signalr::value(1.0));
+    queue->push(signalr::value(2.0));
+    queue->cancel(std::make_exception_ptr(signalr_exception("canceled")));
+    queue->push(signalr::value(3.0));
+    queue->complete(nullptr);
+
+    scheduler->run_until_idle();
+
+    ASSERT_TRUE(record.items.empty());
+    ASSERT_EQ(1, record.completions);
+    ASSERT_NE(nullptr, record.error);
+    ASSERT_EQ((std::vector<bool>{ true, false }), record.full_changes);
+}
+
+TEST(stream_item_queue, gives_other_work_a_turn_after_capacity_items)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    stream_record record;
+    auto queue = create_queue(scheduler, 4, record);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        queue->push(signalr::value(static_cast<double>(i)));
+    }
+
+    int other_work = 0;
+    scheduler->schedule([&other_work, &record]()
+        {
+            // the queue was scheduled first and delivered its capacity worth of items before yielding
+            other_work = static_cast<int>(record.items.size());
+        });
+    scheduler->run_until_idle();
+
+    ASSERT_EQ(4, other_work);
+    ASSERT_EQ(10u, record.items.size());
+    ASSERT_EQ(0, record.completions);
+}
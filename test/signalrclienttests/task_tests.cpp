@@ -0,0 +1,141 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "../src/signalrclient/task.h"
+#include "../src/signalrclient/signalr_default_scheduler.h"
+#include <array>
+
+using namespace signalr;
+
+TEST(task, default_constructed_task_is_empty)
+{
+    task t;
+    ASSERT_FALSE(t);
+}
+
+TEST(task, empty_function_makes_empty_task)
+{
+    signalr_base_cb callback;
+    task t(callback);
+    ASSERT_FALSE(t);
+
+    task moved(std::move(callback));
+    ASSERT_FALSE(moved);
+}
+
+TEST(task, invokes_small_and_large_callables)
+{
+    int calls = 0;
+    task small([&calls]()
+        {
+            ++calls;
+        });
+
+    // bigger than the inline storage so it is kept on the heap
+    std::array<char, task::inline_capacity * 2> padding{};
+    padding[0] = 1;
+    task large([&calls, padding]()
+        {
+            calls += padding[0] * 10;
+        });
+
+    small();
+    large();
+    ASSERT_EQ(11, calls);
+}
+
+TEST(task, move_transfers_callable)
+{
+    auto captured = std::make_shared<int>(42);
+    int result = 0;
+    task first([captured, &result]()
+        {
+            result = *captured;
+        });
+    ASSERT_EQ(2, captured.use_count());
+
+    task second(std::move(first));
+    ASSERT_FALSE(first);
+    ASSERT_TRUE(second);
+    ASSERT_EQ(2, captured.use_count());
+
+    task third;
+    third = std::move(second);
+    ASSERT_FALSE(second);
+    third();
+    ASSERT_EQ(42, result);
+    ASSERT_EQ(2, captured.use_count());
+}
+
+TEST(task, releases_callable_when_destroyed_or_reset)
+{
+    auto captured = std::make_shared<int>(0);
+    std::array<char, task::inline_capacity * 2> padding{};
+
+    {
+        task small([captured]() {});
+        task large([captured, padding]() {});
+        ASSERT_EQ(3, captured.use_count());
+
+        small.reset();
+        ASSERT_FALSE(small);
+        ASSERT_EQ(2, captured.use_count());
+    }
+
+    ASSERT_EQ(1, captured.use_count());
+}
+
+TEST(task, assigning_replaces_callable)
+{
+    auto first_captured = std::make_shared<int>(0);
+    auto second_captured = std::make_shared<int>(0);
+    task t([first_captured]() {});
+    t = task([second_captured]() {});
+
+    ASSERT_EQ(1, first_captured.use_count());
+    ASSERT_EQ(2, second_captured.use_count());
+}
+
+TEST(task, default_scheduler_runs_tasks)
+{
+    signalr_default_scheduler scheduler;
+
+    auto mre = std::make_shared<manual_reset_event<void>>();
+    scheduler.schedule_task(task([mre]()
+        {
+            mre->set();
+        }));
+    mre->get();
+
+    scheduler.schedule_task(task([mre]()
+        {
+            mre->set();
+        }), std::chrono::milliseconds(10));
+    mre->get();
+}
+
+TEST(task, schedule_task_wraps_task_for_function_schedulers)
+{
+    struct function_scheduler : scheduler
+    {
+        int schedule_count = 0;
+
+        void schedule(const signalr_base_cb& cb, std::chrono::milliseconds) override
+        {
+            ++schedule_count;
+            cb();
+        }
+    } scheduler;
+
+    int calls = 0;
+    schedule_task(scheduler, nullptr, task([&calls]()
+        {
+            ++calls;
+        }));
+
+    ASSERT_EQ(1, scheduler.schedule_count);
+    ASSERT_EQ(1, calls);
+}
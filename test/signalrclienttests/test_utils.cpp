@@ -114,10 +114,16 @@ void assert_signalr_value_equality(const signalr::value& expected, const signalr
     case value_type::float64:
         ASSERT_DOUBLE_EQ(expected.as_double(), actual.as_double());
         break;
+    case value_type::int64:
+        ASSERT_EQ(expected.as_int64(), actual.as_int64());
+        break;
+    case value_type::uint64:
+        ASSERT_EQ(expected.as_uint64(), actual.as_uint64());
+        break;
     case value_type::map:
     {
-        auto& expected_map = expected.as_map();
-        auto& actual_map = actual.as_map();
+        auto& expected_map = expected.as_value_map();
+        auto& actual_map = actual.as_value_map();
         ASSERT_EQ(expected_map.size(), actual_map.size());
         for (auto& pair : expected_map)
         {
@@ -129,8 +135,8 @@ void assert_signalr_value_equality(const signalr::value& expected, const signalr
     }
     case value_type::array:
     {
-        auto& expected_array = expected.as_array();
-        auto& actual_array = actual.as_array();
+        auto& expected_array = expected.as_value_array();
+        auto& actual_array = actual.as_value_array();
         ASSERT_EQ(expected_array.size(), actual_array.size());
         for (auto i = 0; i < expected_array.size(); ++i)
         {
@@ -163,6 +169,7 @@ void assert_hub_message_equality(signalr::hub_message* expected, signalr::hub_me
     switch (expected->message_type)
     {
     case message_type::invocation:
+    case message_type::stream_invocation:
     {
         auto expected_message = reinterpret_cast<invocation_message*>(expected);
         auto actual_message = reinterpret_cast<invocation_message*>(actual);
@@ -170,7 +177,7 @@ void assert_hub_message_equality(signalr::hub_message* expected, signalr::hub_me
         ASSERT_STREQ(expected_message->invocation_id.data(), actual_message->invocation_id.data());
         ASSERT_STREQ(expected_message->target.data(), actual_message->target.data());
         assert_signalr_value_equality(expected_message->arguments, actual_message->arguments);
-        //stream_ids
+        ASSERT_EQ(expected_message->stream_ids, actual_message->stream_ids);
         break;
     }
     case message_type::completion:
@@ -185,6 +192,21 @@ void assert_hub_message_equality(signalr::hub_message* expected, signalr::hub_me
 
         break;
     }
+    case message_type::stream_item:
+    {
+        auto expected_message = reinterpret_cast<stream_item_message*>(expected);
+        auto actual_message = reinterpret_cast<stream_item_message*>(actual);
+
+        ASSERT_STREQ(expected_message->invocation_id.data(), actual_message->invocation_id.data());
+        assert_signalr_value_equality(expected_message->item, actual_message->item);
+        break;
+    }
+    case message_type::cancel_invocation:
+    {
+        ASSERT_STREQ(reinterpret_cast<cancel_invocation_message*>(expected)->invocation_id.data(),
+            reinterpret_cast<cancel_invocation_message*>(actual)->invocation_id.data());
+        break;
+    }
     case message_type::ping:
     {
         // No fields on ping messages currently
@@ -7,6 +7,7 @@
 #include "signalrclient/websocket_client.h"
 #include "signalrclient/http_client.h"
 #include "signalrclient/signalr_client_config.h"
+#include "signalrclient/virtual_scheduler.h"
 #include <future>
 #include <signalrclient/signalr_value.h>
 #include <hub_protocol.h>
@@ -102,6 +103,16 @@ private:
     std::promise<void> m_promise;
 };
 
+// for tests on a virtual_scheduler, runs the scheduler's callbacks on the calling thread until the future is ready
+template <typename T>
+bool run_until_ready(signalr::virtual_scheduler& scheduler, const std::future<T>& future)
+{
+    return scheduler.run_until([&future]()
+        {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+}
+
 class custom_exception : public std::exception
 {
 public:
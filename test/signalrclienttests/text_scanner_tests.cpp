@@ -0,0 +1,148 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "../src/signalrclient/text_scanner.h"
+#include <random>
+#include <string>
+
+using namespace signalr;
+
+namespace
+{
+    std::vector<std::pair<std::string, text_scanner::scan_function>> scan_functions()
+    {
+        std::vector<std::pair<std::string, text_scanner::scan_function>> functions
+        {
+            { "scan", &text_scanner::scan },
+            { "portable", &text_scanner::scan_portable }
+        };
+
+        // only the ones the machine running the tests supports
+        if (text_scanner::sse2() != nullptr)
+        {
+            functions.push_back({ "sse2", text_scanner::sse2() });
+        }
+        if (text_scanner::avx2() != nullptr)
+        {
+            functions.push_back({ "avx2", text_scanner::avx2() });
+        }
+
+        return functions;
+    }
+
+    // every offset from 0 to past the largest block, so the interesting bytes land at every position within a block and
+    // across block boundaries
+    const size_t max_padding = 70;
+}
+
+TEST(text_scanner, finds_separators_at_any_position)
+{
+    for (auto& function : scan_functions())
+    {
+        for (size_t padding = 0; padding < max_padding; ++padding)
+        {
+            auto text = std::string(padding, 'a') + "\x1e" + std::string(padding % 7, 'b') + "\x1e\x1e" + std::string(padding, 'c');
+
+            std::vector<size_t> separators;
+            ASSERT_TRUE(function.second(text.data(), text.size(), '\x1e', separators)) << function.first;
+            std::vector<size_t> expected{ padding, padding + 1 + padding % 7, padding + 2 + padding % 7 };
+            ASSERT_EQ(expected, separators) << function.first << " " << padding;
+        }
+    }
+}
+
+TEST(text_scanner, accepts_valid_utf8_at_any_position)
+{
+    const std::string characters[] =
+    {
+        "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xEF\xBF\xBF", "\xF0\x90\x80\x80",
+        "\xF4\x8F\xBF\xBF", "\xD7\x9E\xD7\x97\xD7\xA8"
+    };
+
+    for (auto& function : scan_functions())
+    {
+        for (auto& character : characters)
+        {
+            for (size_t padding = 0; padding < max_padding; ++padding)
+            {
+                auto text = std::string(padding, 'a') + character + "\x1e" + std::string(max_padding - padding, 'b');
+
+                std::vector<size_t> separators;
+                ASSERT_TRUE(function.second(text.data(), text.size(), '\x1e', separators)) << function.first << " " << padding;
+                ASSERT_EQ(std::vector<size_t>{ padding + character.size() }, separators) << function.first << " " << padding;
+            }
+        }
+    }
+}
+
+TEST(text_scanner, rejects_invalid_utf8_at_any_position)
+{
+    const std::string sequences[] =
+    {
+        // stray continuation bytes
+        "\x80", "\xBF",
+        // overlong encodings
+        "\xC0\x80", "\xC1\xBF", "\xE0\x9F\xBF", "\xF0\x8F\xBF\xBF",
+        // surrogates
+        "\xED\xA0\x80", "\xED\xBF\xBF",
+        // above U+10FFFF
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF",
+        // truncated or interrupted sequences
+        "\xC3", "\xE2\x82", "\xF0\x9F\x98", "\xC3\x1e", "\xE2\x82" "a"
+    };
+
+    for (auto& function : scan_functions())
+    {
+        for (auto& sequence : sequences)
+        {
+            for (size_t padding = 0; padding < max_padding; ++padding)
+            {
+                auto text = std::string(padding, 'a') + sequence + std::string(max_padding - padding, 'b');
+                std::vector<size_t> separators;
+                ASSERT_FALSE(function.second(text.data(), text.size(), '\x1e', separators)) << function.first << " " << padding;
+
+                // also at the very end of the text
+                text = std::string(padding, 'a') + sequence;
+                ASSERT_FALSE(function.second(text.data(), text.size(), '\x1e', separators)) << function.first << " " << padding;
+            }
+        }
+    }
+}
+
+TEST(text_scanner, implementations_agree_on_random_text)
+{
+    std::mt19937 random(42);
+    // mostly ASCII with separators, valid characters of every length and the occasional random byte
+    const std::string pieces[] = { "abcdefgh", "{\"type\":1}", "\x1e", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80" };
+    std::uniform_int_distribution<size_t> piece(0, 5);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> corrupt(0, 400);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string text;
+        while (text.size() < 300)
+        {
+            text += pieces[piece(random)];
+            if (corrupt(random) == 0)
+            {
+                text.push_back(static_cast<char>(byte(random)));
+            }
+        }
+
+        std::vector<size_t> expected;
+        auto expected_valid = text_scanner::scan_portable(text.data(), text.size(), '\x1e', expected);
+
+        for (auto& function : scan_functions())
+        {
+            std::vector<size_t> separators;
+            ASSERT_EQ(expected_valid, function.second(text.data(), text.size(), '\x1e', separators)) << function.first;
+            if (expected_valid)
+            {
+                ASSERT_EQ(expected, separators) << function.first;
+            }
+        }
+    }
+}
@@ -0,0 +1,278 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "../src/signalrclient/thread_pool.h"
+#include <atomic>
+#include <future>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+using namespace signalr;
+
+TEST(thread_pool, uses_configured_thread_count)
+{
+    thread_pool_options options;
+    options.thread_count = 3;
+    thread_pool pool(options);
+
+    ASSERT_EQ(3, pool.thread_count());
+}
+
+TEST(thread_pool, default_thread_count_is_at_least_five)
+{
+    thread_pool pool(thread_pool_options{});
+
+    ASSERT_LE(5, pool.thread_count());
+    ASSERT_LE(std::thread::hardware_concurrency(), pool.thread_count());
+}
+
+TEST(thread_pool, starts_min_thread_count_workers)
+{
+    thread_pool_options options;
+    options.thread_count = 3;
+    thread_pool pool(options);
+    ASSERT_EQ(0, pool.active_thread_count());
+
+    options.min_thread_count = 2;
+    thread_pool pool_with_min(options);
+    ASSERT_EQ(2, pool_with_min.active_thread_count());
+}
+
+TEST(thread_pool, starts_workers_when_callbacks_are_submitted)
+{
+    thread_pool_options options;
+    options.thread_count = 3;
+    thread_pool pool(options);
+
+    auto mre = std::make_shared<manual_reset_event<void>>();
+    pool.submit([mre]()
+        {
+            mre->set();
+        });
+
+    mre->get();
+    ASSERT_LE(1, pool.active_thread_count());
+}
+
+TEST(thread_pool, grows_while_workers_are_blocked)
+{
+    thread_pool_options options;
+    options.thread_count = 3;
+    thread_pool pool(options);
+
+    auto first_blocked = std::make_shared<manual_reset_event<void>>();
+    auto second_blocked = std::make_shared<manual_reset_event<void>>();
+    auto release = std::make_shared<std::promise<void>>();
+    auto released = release->get_future().share();
+    auto done = std::make_shared<manual_reset_event<void>>();
+    pool.submit([first_blocked, released]()
+        {
+            first_blocked->set();
+            released.wait();
+        });
+    first_blocked->get();
+
+    pool.submit([second_blocked, released, done]()
+        {
+            second_blocked->set();
+            released.wait();
+            done->set();
+        });
+    second_blocked->get();
+
+    // both workers are blocked, so this one needs a third
+    pool.submit([release]()
+        {
+            release->set_value();
+        });
+
+    done->get();
+    ASSERT_EQ(3, pool.active_thread_count());
+}
+
+TEST(thread_pool, idle_workers_exit_down_to_min_thread_count)
+{
+    thread_pool_options options;
+    options.thread_count = 3;
+    options.min_thread_count = 1;
+    options.idle_timeout = std::chrono::milliseconds(50);
+    thread_pool pool(options);
+
+    auto blocked = std::make_shared<manual_reset_event<void>>();
+    auto release = std::make_shared<manual_reset_event<void>>();
+    pool.submit([blocked, release]()
+        {
+            blocked->set();
+            release->get();
+        });
+    blocked->get();
+    pool.submit([release]()
+        {
+            release->set();
+        });
+
+    for (int i = 0; i < 100 && pool.active_thread_count() != 1; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ASSERT_EQ(1, pool.active_thread_count());
+
+    // workers are started again once there is work
+    auto mre = std::make_shared<manual_reset_event<void>>();
+    pool.submit([mre]()
+        {
+            mre->set();
+        });
+    mre->get();
+}
+
+TEST(thread_pool, shutdown_runs_queued_callbacks)
+{
+    const int count = 1000;
+    std::atomic<int> ran(0);
+    thread_pool_options options;
+    options.thread_count = 2;
+    thread_pool pool(options);
+
+    for (int i = 0; i < count; ++i)
+    {
+        pool.submit([&ran]()
+            {
+                ++ran;
+            });
+    }
+
+    pool.shutdown();
+    ASSERT_EQ(count, ran.load());
+}
+
+TEST(thread_pool, callbacks_queued_by_a_busy_worker_are_stolen)
+{
+    thread_pool_options options;
+    options.thread_count = 2;
+    thread_pool pool(options);
+
+    auto stolen = manual_reset_event<void>();
+    auto done = manual_reset_event<void>();
+    pool.submit([&pool, &stolen, &done]()
+        {
+            // queued on this worker, which stays busy until the other worker has run it
+            pool.submit([&stolen]()
+                {
+                    stolen.set();
+                });
+
+            stolen.get();
+            done.set();
+        });
+
+    done.get();
+}
+
+TEST(thread_pool, callbacks_can_submit_while_shutting_down)
+{
+    std::atomic<int> ran(0);
+    thread_pool_options options;
+    options.thread_count = 2;
+    thread_pool pool(options);
+
+    pool.submit([&pool, &ran]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            pool.submit([&ran]()
+                {
+                    ++ran;
+                });
+        });
+
+    pool.shutdown();
+    ASSERT_EQ(1, ran.load());
+}
+
+TEST(thread_pool, worker_timing_out_as_a_callback_is_submitted_runs_it)
+{
+    thread_pool_options options;
+    options.thread_count = 1;
+    options.idle_timeout = std::chrono::milliseconds(1);
+    thread_pool pool(options);
+
+    // submits land around the moment the only worker times out, it must not exit while one is waiting for it
+    for (int i = 0; i < 500; ++i)
+    {
+        auto ran = std::make_shared<cancellation_token_source>();
+        pool.submit([ran]()
+            {
+                ran->cancel();
+            });
+        ASSERT_FALSE(ran->wait(5000)) << i;
+        std::this_thread::sleep_for(std::chrono::microseconds(900 + (i % 10) * 20));
+    }
+}
+
+TEST(thread_pool, shutdown_runs_or_destroys_callbacks_submitted_while_no_worker_is_running)
+{
+    for (int i = 0; i < 200; ++i)
+    {
+        auto ran = std::make_shared<std::atomic<int>>(0);
+        int submitted = 0;
+        {
+            thread_pool_options options;
+            options.thread_count = 2;
+            options.idle_timeout = std::chrono::milliseconds(1);
+            thread_pool pool(options);
+
+            // the worker has exited by the time the submits race with shutdown
+            pool.submit([]() {});
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            std::atomic<bool> go(false);
+            std::thread submitter([&pool, &go, &submitted, ran]()
+                {
+                    while (!go.load())
+                    {
+                    }
+                    for (; submitted < 20; ++submitted)
+                    {
+                        pool.submit([ran]()
+                            {
+                                ++*ran;
+                            });
+                    }
+                });
+
+            go.store(true);
+            pool.shutdown();
+            submitter.join();
+        }
+
+        // callbacks that got in before shutdown ran, the rest were destroyed instead of being left behind
+        ASSERT_LE(ran->load(), submitted) << i;
+        ASSERT_EQ(1, ran.use_count()) << i;
+    }
+}
+
+#if defined(__linux__)
+TEST(thread_pool, workers_are_named)
+{
+    thread_pool_options options;
+    options.thread_count = 2;
+    options.thread_name = "signalr";
+    thread_pool pool(options);
+
+    auto mre = manual_reset_event<std::string>();
+    pool.submit([&mre]()
+        {
+            char name[16] = {};
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            mre.set(std::string(name));
+        });
+
+    auto name = mre.get();
+    ASSERT_TRUE(name == "signalr-0" || name == "signalr-1") << name;
+}
+#endif
@@ -0,0 +1,156 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "../src/signalrclient/timer.h"
+#include "../src/signalrclient/signalr_default_scheduler.h"
+#include <atomic>
+
+using namespace signalr;
+
+TEST(timer, schedule_after_runs_callback_once_delay_elapsed)
+{
+    auto scheduled_timer = timer::create(std::make_shared<signalr_default_scheduler>());
+    auto delay = std::chrono::milliseconds(50);
+
+    auto mre = manual_reset_event<void>();
+    auto start = std::chrono::steady_clock::now();
+    scheduled_timer->schedule_after(delay, [&mre]()
+        {
+            mre.set();
+        });
+
+    mre.get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_LE(delay, elapsed);
+    // millisecond precision rather than the old one second tick
+    ASSERT_GT(std::chrono::milliseconds(500), elapsed);
+}
+
+TEST(timer, schedule_at_runs_callback_at_deadline)
+{
+    auto scheduled_timer = timer::create(std::make_shared<signalr_default_scheduler>());
+    auto deadline = timer::clock::now() + std::chrono::milliseconds(30);
+
+    auto mre = manual_reset_event<void>();
+    scheduled_timer->schedule_at(deadline, [&mre]()
+        {
+            mre.set();
+        });
+
+    mre.get();
+    ASSERT_LE(deadline, timer::clock::now());
+}
+
+TEST(timer, canceled_timer_does_not_run)
+{
+    auto scheduler = std::make_shared<signalr_default_scheduler>();
+    auto scheduled_timer = timer::create(scheduler);
+
+    std::atomic<bool> called(false);
+    scheduled_timer->schedule_after(std::chrono::milliseconds(50), [&called]()
+        {
+            called = true;
+        });
+    scheduled_timer->cancel();
+
+    auto mre = manual_reset_event<void>();
+    scheduler->schedule([&mre]()
+        {
+            mre.set();
+        }, std::chrono::milliseconds(150));
+    mre.get();
+
+    ASSERT_FALSE(called.load());
+}
+
+TEST(timer, rearming_replaces_previous_callback)
+{
+    auto scheduled_timer = timer::create(std::make_shared<signalr_default_scheduler>());
+
+    std::atomic<int> first(0);
+    auto mre = manual_reset_event<void>();
+    scheduled_timer->schedule_after(std::chrono::milliseconds(20), [&first]()
+        {
+            ++first;
+        });
+    scheduled_timer->schedule_after(std::chrono::milliseconds(100), [&mre]()
+        {
+            mre.set();
+        });
+
+    mre.get();
+    ASSERT_EQ(0, first.load());
+}
+
+TEST(timer, schedule_every_repeats_until_canceled_from_callback)
+{
+    auto scheduled_timer = timer::create(std::make_shared<signalr_default_scheduler>());
+    std::weak_ptr<timer> weak_timer = scheduled_timer;
+
+    std::atomic<int> ticks(0);
+    auto mre = manual_reset_event<void>();
+    scheduled_timer->schedule_every(std::chrono::milliseconds(10), [&ticks, &mre, weak_timer]()
+        {
+            if (++ticks == 3)
+            {
+                weak_timer.lock()->cancel();
+                mre.set();
+            }
+        });
+
+    mre.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(3, ticks.load());
+}
+
+TEST(timer, pending_tick_keeps_timer_alive_and_releases_it_after_firing)
+{
+    std::weak_ptr<timer> weak_timer;
+    auto mre = manual_reset_event<void>();
+    {
+        auto scheduled_timer = timer::create(std::make_shared<signalr_default_scheduler>());
+        weak_timer = scheduled_timer;
+        scheduled_timer->schedule_after(std::chrono::milliseconds(20), [&mre]()
+            {
+                mre.set();
+            });
+    }
+
+    mre.get();
+    for (int i = 0; i < 100 && !weak_timer.expired(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(weak_timer.expired());
+}
+
+TEST(timer, canceled_timer_is_released_before_its_deadline)
+{
+    auto scheduler = std::make_shared<signalr_default_scheduler>();
+    std::weak_ptr<timer> weak_timer;
+    std::atomic<bool> called(false);
+    {
+        auto scheduled_timer = timer::create(scheduler);
+        weak_timer = scheduled_timer;
+        scheduled_timer->schedule_after(std::chrono::milliseconds(50), [&called]()
+            {
+                called = true;
+            });
+        scheduled_timer->cancel();
+    }
+
+    ASSERT_TRUE(weak_timer.expired());
+
+    // the tick that is still pending finds the timer gone
+    auto mre = manual_reset_event<void>();
+    scheduler->schedule([&mre]()
+        {
+            mre.set();
+        }, std::chrono::milliseconds(150));
+    mre.get();
+
+    ASSERT_FALSE(called.load());
+}
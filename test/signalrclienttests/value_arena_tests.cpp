@@ -0,0 +1,90 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "../src/signalrclient/value_arena.h"
+#include <cstdint>
+
+using namespace signalr;
+
+TEST(value_arena, allocations_are_aligned_and_do_not_overlap)
+{
+    value_arena arena;
+    std::vector<std::pair<char*, size_t>> allocations;
+    // small ones filling the first blocks, and one larger than any block
+    for (size_t size : { 1, 7, 16, 33, 1000, 3000, 5000, 3 * 1024 * 1024, 24 })
+    {
+        auto memory = static_cast<char*>(arena.allocate(size));
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(memory) % alignof(std::max_align_t)) << size;
+        memset(memory, 0xab, size);
+        allocations.emplace_back(memory, size);
+    }
+
+    for (size_t i = 0; i < allocations.size(); ++i)
+    {
+        for (size_t j = i + 1; j < allocations.size(); ++j)
+        {
+            auto& a = allocations[i];
+            auto& b = allocations[j];
+            ASSERT_TRUE(a.first + a.second <= b.first || b.first + b.second <= a.first) << i << " " << j;
+        }
+    }
+}
+
+TEST(value_arena, release_reuses_the_memory)
+{
+    value_arena arena;
+    auto first = arena.allocate(100);
+    arena.allocate(100);
+
+    arena.release();
+    ASSERT_EQ(first, arena.allocate(100));
+}
+
+TEST(value_arena, scope_sets_the_current_arena)
+{
+    value_arena outer;
+    value_arena inner;
+    ASSERT_EQ(nullptr, current_value_arena());
+    {
+        value_arena::scope outer_scope(&outer);
+        ASSERT_EQ(&outer, current_value_arena());
+        {
+            value_arena::scope inner_scope(&inner);
+            ASSERT_EQ(&inner, current_value_arena());
+            {
+                value_arena::scope heap_scope(nullptr);
+                ASSERT_EQ(nullptr, current_value_arena());
+            }
+            ASSERT_EQ(&inner, current_value_arena());
+        }
+        ASSERT_EQ(&outer, current_value_arena());
+    }
+    ASSERT_EQ(nullptr, current_value_arena());
+}
+
+TEST(value_arena, copies_of_values_outlive_the_arena)
+{
+    value copy;
+    {
+        value_arena arena;
+        value original;
+        {
+            value_arena::scope scope(&arena);
+            std::vector<std::pair<std::string, value>> members;
+            members.emplace_back("prices", value(std::vector<value>{ value(1.0), value(2.0), value(3.0) }));
+            members.emplace_back("symbol", value("MSFT"));
+            original = value(value_map(std::move(members)));
+        }
+
+        copy = original;
+        original = value();
+        arena.release();
+    }
+
+    ASSERT_EQ("MSFT", copy.as_map().at("symbol").as_string());
+    auto& prices = copy.as_map().at("prices").as_array();
+    ASSERT_EQ(3u, prices.size());
+    ASSERT_EQ(3.0, prices[2].as_double());
+}
@@ -0,0 +1,167 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stdafx.h"
+#include "test_utils.h"
+#include "signalrclient/virtual_scheduler.h"
+#include "../src/signalrclient/timer.h"
+#include "../src/signalrclient/strand.h"
+#include <atomic>
+#include <thread>
+
+using namespace signalr;
+
+TEST(virtual_scheduler, callbacks_only_run_when_driven)
+{
+    virtual_scheduler scheduler;
+
+    int calls = 0;
+    scheduler.schedule([&calls]()
+        {
+            ++calls;
+        });
+
+    ASSERT_EQ(0, calls);
+    ASSERT_EQ(1u, scheduler.pending());
+
+    ASSERT_EQ(1u, scheduler.run_until_idle());
+    ASSERT_EQ(1, calls);
+    ASSERT_EQ(0u, scheduler.pending());
+}
+
+TEST(virtual_scheduler, delayed_callbacks_run_in_deadline_order_when_advanced)
+{
+    virtual_scheduler scheduler;
+    auto start = scheduler.now();
+
+    std::vector<std::pair<int, std::chrono::milliseconds>> order;
+    auto record = [&order, &scheduler, start](int id)
+    {
+        return [&order, &scheduler, start, id]()
+        {
+            order.push_back({ id, std::chrono::duration_cast<std::chrono::milliseconds>(scheduler.now() - start) });
+        };
+    };
+
+    scheduler.schedule(record(3), std::chrono::milliseconds(300));
+    scheduler.schedule(record(1), std::chrono::milliseconds(100));
+    scheduler.schedule(record(4), std::chrono::milliseconds(300));
+    scheduler.schedule(record(2), std::chrono::milliseconds(200));
+
+    ASSERT_EQ(0u, scheduler.run_until_idle());
+    ASSERT_EQ(2u, scheduler.advance(std::chrono::milliseconds(250)));
+    ASSERT_EQ(std::chrono::milliseconds(250), scheduler.now() - start);
+    ASSERT_EQ(2u, scheduler.advance(std::chrono::milliseconds(50)));
+
+    ASSERT_EQ(4u, order.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(i + 1, order[i].first);
+    }
+
+    // each callback sees the clock at its own deadline
+    ASSERT_EQ(std::chrono::milliseconds(100), order[0].second);
+    ASSERT_EQ(std::chrono::milliseconds(200), order[1].second);
+    ASSERT_EQ(std::chrono::milliseconds(300), order[2].second);
+    ASSERT_EQ(std::chrono::milliseconds(300), order[3].second);
+}
+
+TEST(virtual_scheduler, advance_runs_callbacks_scheduled_by_callbacks)
+{
+    virtual_scheduler scheduler;
+
+    int calls = 0;
+    std::function<void()> reschedule = [&scheduler, &calls, &reschedule]()
+    {
+        if (++calls < 10)
+        {
+            scheduler.schedule(reschedule, std::chrono::seconds(1));
+        }
+    };
+    scheduler.schedule(reschedule, std::chrono::seconds(1));
+
+    scheduler.advance(std::chrono::seconds(5));
+    ASSERT_EQ(5, calls);
+
+    scheduler.advance(std::chrono::hours(1));
+    ASSERT_EQ(10, calls);
+}
+
+TEST(virtual_scheduler, repeating_timer_ticks_on_virtual_time)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto repeating = timer::create(scheduler);
+
+    int ticks = 0;
+    repeating->schedule_every(std::chrono::seconds(15), [&ticks]()
+        {
+            ++ticks;
+        });
+
+    scheduler->advance(std::chrono::minutes(10));
+    ASSERT_EQ(40, ticks);
+
+    repeating->cancel();
+    scheduler->advance(std::chrono::minutes(10));
+    ASSERT_EQ(40, ticks);
+}
+
+TEST(virtual_scheduler, strand_reads_the_virtual_clock)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+    auto serial = strand::create(scheduler);
+
+    auto start = clock_now(*serial);
+    ASSERT_EQ(scheduler->now(), start);
+
+    scheduler->advance(std::chrono::hours(1));
+    ASSERT_EQ(std::chrono::hours(1), clock_now(*serial) - start);
+}
+
+TEST(virtual_scheduler, schedulers_without_a_clock_use_the_steady_clock)
+{
+    struct plain_scheduler : scheduler
+    {
+        void schedule(const signalr_base_cb& cb, std::chrono::milliseconds) override
+        {
+            cb();
+        }
+    };
+
+    plain_scheduler plain;
+    ASSERT_EQ(nullptr, find_clock(plain));
+
+    auto before = std::chrono::steady_clock::now();
+    auto now = clock_now(plain);
+    ASSERT_LE(before, now);
+    ASSERT_LE(now, std::chrono::steady_clock::now());
+}
+
+TEST(virtual_scheduler, run_until_runs_callbacks_scheduled_by_other_threads)
+{
+    auto scheduler = std::make_shared<virtual_scheduler>();
+
+    std::atomic<bool> ran(false);
+    std::thread other([scheduler, &ran]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            scheduler->schedule([&ran]()
+                {
+                    ran = true;
+                });
+        });
+
+    ASSERT_TRUE(scheduler->run_until([&ran]() { return ran.load(); }));
+    other.join();
+}
+
+TEST(virtual_scheduler, run_until_gives_up_after_timeout)
+{
+    virtual_scheduler scheduler;
+    scheduler.schedule([]() {}, std::chrono::seconds(1));
+
+    ASSERT_FALSE(scheduler.run_until([]() { return false; }, std::chrono::milliseconds(20)));
+    // the clock doesn't move while waiting
+    ASSERT_EQ(1u, scheduler.pending());
+}
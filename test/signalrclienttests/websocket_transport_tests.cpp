@@ -531,6 +531,100 @@ TEST(websocket_transport_receive_loop, process_response_callback_called_when_mes
     mre.get();
 }
 
+TEST(websocket_transport_receive_loop, paused_receive_loop_waits_for_resume)
+{
+    auto client = std::make_shared<test_websocket_client>();
+
+    auto messages = std::make_shared<std::vector<std::string>>();
+    auto first_message = std::make_shared<cancellation_token_source>();
+    auto second_message = std::make_shared<cancellation_token_source>();
+
+    auto ws_transport = websocket_transport::create([&](const signalr_client_config& config)
+        {
+            client->set_config(config);
+            return client;
+        }, signalr_client_config{}, logger(std::make_shared<trace_log_writer>(), trace_level::none));
+    std::weak_ptr<transport> weak_transport = ws_transport;
+    ws_transport->on_receive([messages, first_message, second_message, weak_transport](const std::string& message, std::exception_ptr)
+    {
+        messages->push_back(message);
+        if (messages->size() == 1)
+        {
+            // takes effect before the loop asks for the next message
+            weak_transport.lock()->pause_receiving();
+            first_message->cancel();
+        }
+        else
+        {
+            second_message->cancel();
+        }
+    });
+
+    auto mre = manual_reset_event<void>();
+    ws_transport->start("ws://fakeuri.org", [&mre](std::exception_ptr exception)
+    {
+        mre.set(exception);
+    });
+    mre.get();
+
+    client->receive_message("first");
+    ASSERT_FALSE(first_message->wait(5000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(1, client->receive_count);
+
+    ws_transport->resume_receiving();
+    client->receive_message("second");
+    ASSERT_FALSE(second_message->wait(5000));
+    ASSERT_EQ((std::vector<std::string>{ "first", "second" }), *messages);
+
+    ws_transport->stop([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    mre.get();
+}
+
+TEST(websocket_transport_receive_loop, stop_completes_while_receive_loop_is_paused)
+{
+    auto client = std::make_shared<test_websocket_client>();
+    client->set_close_function([](std::function<void(std::exception_ptr)> callback)
+    {
+        callback(nullptr);
+    });
+
+    auto message_received = std::make_shared<cancellation_token_source>();
+    auto ws_transport = websocket_transport::create([&](const signalr_client_config& config)
+        {
+            client->set_config(config);
+            return client;
+        }, signalr_client_config{}, logger(std::make_shared<trace_log_writer>(), trace_level::none));
+    ws_transport->on_receive([message_received](const std::string&, std::exception_ptr)
+    {
+        message_received->cancel();
+    });
+
+    auto mre = manual_reset_event<void>();
+    ws_transport->start("ws://fakeuri.org", [&mre](std::exception_ptr exception)
+    {
+        mre.set(exception);
+    });
+    mre.get();
+
+    // pauses and resumes are counted, one resume still leaves the loop paused
+    ws_transport->pause_receiving();
+    ws_transport->pause_receiving();
+    ws_transport->resume_receiving();
+    client->receive_message("message");
+    ASSERT_FALSE(message_received->wait(5000));
+
+    ws_transport->stop([&mre](std::exception_ptr exception)
+        {
+            mre.set(exception);
+        });
+    mre.get();
+    ASSERT_EQ(1, client->receive_count);
+}
+
 TEST(websocket_transport_receive_loop, error_callback_called_when_exception_thrown)
 {
     auto client = std::make_shared<test_websocket_client>();